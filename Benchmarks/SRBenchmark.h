@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <SocketRocket/SRWebSocketMetrics.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef struct {
+    /** Average wall time of a single iteration in nanoseconds. */
+    double nanosecondsPerOperation;
+    /** Average number of heap allocations done by a single iteration. */
+    double allocationsPerOperation;
+    /** Average number of bytes allocated on the heap by a single iteration. */
+    double bytesPerOperation;
+    /** Payload bytes processed per nanosecond, `0` if the benchmark doesn't process a payload. */
+    double bytesPerNanosecond;
+} SRBenchmarkResult;
+
+/**
+ Runs `block` `iterations` times, each inside its own autorelease pool, after a short warm up.
+ Heap allocations done on any thread while the block runs are counted.
+
+ @param name       Name of the benchmark that is printed together with the result.
+ @param iterations Number of measured iterations.
+ @param block      Block with the operation to measure.
+
+ @return Averaged result of the measured iterations.
+ */
+extern SRBenchmarkResult SRBenchmarkRun(NSString *name, NSUInteger iterations, void (^block)(void));
+
+/**
+ Same as `SRBenchmarkRun`, for benchmarks that process `byteCount` bytes of payload per iteration, so that throughput is reported too.
+ */
+extern SRBenchmarkResult SRBenchmarkRunWithByteCount(NSString *name, NSUInteger iterations, size_t byteCount, void (^block)(void));
+
+/**
+ Prints percentiles of latency samples. Sorts `latencies` in place.
+
+ @param name      Name of the benchmark that is printed together with the result.
+ @param latencies Latency samples in nanoseconds.
+ @param count     Number of samples.
+ */
+extern void SRBenchmarkReportLatencies(NSString *name, uint64_t *latencies, NSUInteger count);
+
+/**
+ Prints and records named values measured by a benchmark that doesn't fit the per-operation model, e.g. an end-to-end scenario.
+
+ @param name   Name of the benchmark that is printed together with the result.
+ @param values Measured values by name, printed in key order.
+ */
+extern void SRBenchmarkReportValues(NSString *name, NSDictionary<NSString *, NSNumber *> *values);
+
+/**
+ Prints and records the allocations a socket counted itself per delivered message, for every stage of its receive pipeline.
+ Unlike other values, these are compared with a baseline like the allocations of `SRBenchmarkRun`, so growth fails the comparison.
+ Does nothing unless SocketRocket was built with `SR_ALLOCATION_AUDIT_ENABLED` defined.
+
+ @param name    Name prefix of the results, the stage is appended to it.
+ @param metrics Metrics of the socket after the benchmark.
+ */
+extern void SRBenchmarkReportAllocationAudit(NSString *name, SRWebSocketMetrics *metrics);
+
+/**
+ Results of all benchmarks that ran so far, in order, as JSON-compatible dictionaries with a `name` key.
+ */
+extern NSArray<NSDictionary<NSString *, id> *> *SRBenchmarkRecordedResults(void);
+
+NS_ASSUME_NONNULL_END
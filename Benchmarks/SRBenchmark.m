@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRBenchmark.h"
+
+#import <malloc/malloc.h>
+#import <mach/mach.h>
+#import <stdatomic.h>
+
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSMutableArray<NSDictionary<NSString *, id> *> *_recordedResults;
+
+static void SRBenchmarkRecordResult(NSDictionary<NSString *, id> *result)
+{
+    if (!_recordedResults) {
+        _recordedResults = [NSMutableArray array];
+    }
+    [_recordedResults addObject:result];
+}
+
+NSArray<NSDictionary<NSString *, id> *> *SRBenchmarkRecordedResults(void)
+{
+    return [_recordedResults copy] ?: @[];
+}
+
+static atomic_bool _countingAllocations;
+static atomic_uint_fast64_t _allocationCount;
+static atomic_uint_fast64_t _allocationBytes;
+
+static void *(*_originalMalloc)(malloc_zone_t *zone, size_t size);
+static void *(*_originalCalloc)(malloc_zone_t *zone, size_t count, size_t size);
+static void *(*_originalRealloc)(malloc_zone_t *zone, void *_Nullable pointer, size_t size);
+
+static inline void SRCountAllocation(size_t size)
+{
+    if (atomic_load_explicit(&_countingAllocations, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&_allocationCount, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&_allocationBytes, size, memory_order_relaxed);
+    }
+}
+
+static void *SRCountingMalloc(malloc_zone_t *zone, size_t size)
+{
+    SRCountAllocation(size);
+    return _originalMalloc(zone, size);
+}
+
+static void *SRCountingCalloc(malloc_zone_t *zone, size_t count, size_t size)
+{
+    SRCountAllocation(count * size);
+    return _originalCalloc(zone, count, size);
+}
+
+static void *SRCountingRealloc(malloc_zone_t *zone, void *_Nullable pointer, size_t size)
+{
+    SRCountAllocation(size);
+    return _originalRealloc(zone, pointer, size);
+}
+
+// Replaces allocation functions of the default malloc zone with counting ones.
+// Zone structure lives in read-only memory, so it has to be made writable first.
+static void SRInstallAllocationCounters(void)
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        malloc_zone_t *zone = malloc_default_zone();
+
+        vm_address_t page = trunc_page((vm_address_t)zone);
+        vm_protect(mach_task_self(), page, vm_page_size, 0, VM_PROT_READ | VM_PROT_WRITE);
+
+        _originalMalloc = zone->malloc;
+        _originalCalloc = zone->calloc;
+        _originalRealloc = zone->realloc;
+        zone->malloc = SRCountingMalloc;
+        zone->calloc = SRCountingCalloc;
+        zone->realloc = SRCountingRealloc;
+
+        vm_protect(mach_task_self(), page, vm_page_size, 0, VM_PROT_READ);
+    });
+}
+
+SRBenchmarkResult SRBenchmarkRun(NSString *name, NSUInteger iterations, void (^block)(void))
+{
+    return SRBenchmarkRunWithByteCount(name, iterations, 0, block);
+}
+
+SRBenchmarkResult SRBenchmarkRunWithByteCount(NSString *name, NSUInteger iterations, size_t byteCount, void (^block)(void))
+{
+    SRInstallAllocationCounters();
+
+    // Warm up caches and pools before measuring.
+    NSUInteger warmupIterations = MAX(iterations / 10, (NSUInteger)1);
+    for (NSUInteger i = 0; i < warmupIterations; i++) {
+        @autoreleasepool {
+            block();
+        }
+    }
+
+    atomic_store(&_allocationCount, 0);
+    atomic_store(&_allocationBytes, 0);
+    atomic_store(&_countingAllocations, true);
+
+    uint64_t startTime = SRMonotonicTimeNanoseconds();
+    for (NSUInteger i = 0; i < iterations; i++) {
+        @autoreleasepool {
+            block();
+        }
+    }
+    uint64_t endTime = SRMonotonicTimeNanoseconds();
+
+    atomic_store(&_countingAllocations, false);
+
+    SRBenchmarkResult result = {
+        .nanosecondsPerOperation = (double)(endTime - startTime) / iterations,
+        .allocationsPerOperation = (double)atomic_load(&_allocationCount) / iterations,
+        .bytesPerOperation = (double)atomic_load(&_allocationBytes) / iterations,
+        .bytesPerNanosecond = (double)byteCount * iterations / MAX(endTime - startTime, (uint64_t)1),
+    };
+
+    printf("%-48s %12.1f ns/op %8.2f allocs/op %12.1f B/op",
+           name.UTF8String,
+           result.nanosecondsPerOperation,
+           result.allocationsPerOperation,
+           result.bytesPerOperation);
+    if (byteCount > 0) {
+        printf(" %8.2f GB/s", result.bytesPerNanosecond);
+    }
+    printf("\n");
+
+    SRBenchmarkRecordResult(@{
+        @"name" : name,
+        @"nsPerOp" : @(result.nanosecondsPerOperation),
+        @"allocsPerOp" : @(result.allocationsPerOperation),
+        @"allocatedBytesPerOp" : @(result.bytesPerOperation),
+        @"bytesPerNs" : @(result.bytesPerNanosecond),
+    });
+
+    return result;
+}
+
+static int SRCompareLatencies(const void *left, const void *right)
+{
+    uint64_t leftLatency = *(const uint64_t *)left;
+    uint64_t rightLatency = *(const uint64_t *)right;
+    return (leftLatency > rightLatency) - (leftLatency < rightLatency);
+}
+
+void SRBenchmarkReportLatencies(NSString *name, uint64_t *latencies, NSUInteger count)
+{
+    if (count == 0) {
+        return;
+    }
+    qsort(latencies, count, sizeof(uint64_t), SRCompareLatencies);
+
+    printf("%-48s p50 %10.1f us  p90 %10.1f us  p99 %10.1f us  p999 %10.1f us  max %10.1f us\n",
+           name.UTF8String,
+           latencies[count / 2] / 1000.0,
+           latencies[count * 90 / 100] / 1000.0,
+           latencies[count * 99 / 100] / 1000.0,
+           latencies[count * 999 / 1000] / 1000.0,
+           latencies[count - 1] / 1000.0);
+
+    SRBenchmarkRecordResult(@{
+        @"name" : name,
+        @"p50Ns" : @(latencies[count / 2]),
+        @"p90Ns" : @(latencies[count * 90 / 100]),
+        @"p99Ns" : @(latencies[count * 99 / 100]),
+        @"p999Ns" : @(latencies[count * 999 / 1000]),
+        @"maxNs" : @(latencies[count - 1]),
+    });
+}
+
+void SRBenchmarkReportValues(NSString *name, NSDictionary<NSString *, NSNumber *> *values)
+{
+    printf("%-48s", name.UTF8String);
+    NSArray<NSString *> *keys = [values.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    for (NSString *key in keys) {
+        printf(" %s %.1f", key.UTF8String, values[key].doubleValue);
+    }
+    printf("\n");
+
+    NSMutableDictionary<NSString *, id> *result = [values mutableCopy];
+    result[@"name"] = name;
+    SRBenchmarkRecordResult(result);
+}
+
+void SRBenchmarkReportAllocationAudit(NSString *name, SRWebSocketMetrics *metrics)
+{
+    if (!SRWebSocketMetrics.allocationAuditEnabled || metrics.messagesDelivered == 0) {
+        return;
+    }
+
+    // In the order of `SRAllocationStage`.
+    NSArray<NSString *> *stageNames = @[ @"consumerBlock", @"consumer", @"dataSubrange", @"dataConcatenation", @"frameData", @"messageString" ];
+    NSCAssert(stageNames.count == SRAllocationStageCount, @"Every allocation stage needs a name.");
+
+    double messageCount = metrics.messagesDelivered;
+    for (SRAllocationStage stage = 0; stage < SRAllocationStageCount; stage++) {
+        NSString *stageName = [NSString stringWithFormat:@"%@/allocations/%@", name, stageNames[stage]];
+        double allocationsPerMessage = [metrics allocationCountForStage:stage] / messageCount;
+        double bytesPerMessage = [metrics allocatedBytesForStage:stage] / messageCount;
+        printf("%-48s %8.2f allocs/msg %10.1f B/msg\n", stageName.UTF8String, allocationsPerMessage, bytesPerMessage);
+
+        SRBenchmarkRecordResult(@{
+            @"name" : stageName,
+            @"allocsPerOp" : @(allocationsPerMessage),
+            @"allocatedBytesPerOp" : @(bytesPerMessage),
+        });
+    }
+}
+
+NS_ASSUME_NONNULL_END
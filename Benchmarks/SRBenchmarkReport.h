@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Writes results of all benchmarks that ran so far as JSON.
+
+ @param path            Path of the file to write.
+ @param cpuFrequencyGHz Clock frequency of the CPU, used to convert throughput into bytes per cycle. `0` leaves bytes per cycle out.
+ @param error           Set if the file can't be written.
+
+ @return `YES` if the file was written.
+ */
+extern BOOL SRBenchmarkWriteResults(NSString *path, double cpuFrequencyGHz, NSError **error);
+
+/**
+ Compares results of all benchmarks that ran so far against a file written by `SRBenchmarkWriteResults` and prints every regression.
+ Time per operation regresses when it grows by more than `threshold`, allocations per operation regress when they grow at all.
+ Benchmarks that are missing from the baseline are skipped.
+
+ @param path      Path of the baseline file.
+ @param threshold Allowed relative growth of time per operation, e.g. `0.1` for 10%.
+ @param error     Set if the baseline can't be read.
+
+ @return Number of regressions, or `-1` if the baseline can't be read.
+ */
+extern NSInteger SRBenchmarkCompareResults(NSString *path, double threshold, NSError **error);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRBenchmarkReport.h"
+
+#import "SRBenchmark.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Allocation counts are deterministic, so any growth beyond rounding noise of the warm up is a regression.
+static const double SRAllocationsTolerance = 0.05;
+
+BOOL SRBenchmarkWriteResults(NSString *path, double cpuFrequencyGHz, NSError **error)
+{
+    NSMutableArray<NSDictionary<NSString *, id> *> *results = [NSMutableArray array];
+    for (NSDictionary<NSString *, id> *result in SRBenchmarkRecordedResults()) {
+        double bytesPerNanosecond = [result[@"bytesPerNs"] doubleValue];
+        if (cpuFrequencyGHz > 0 && bytesPerNanosecond > 0) {
+            NSMutableDictionary<NSString *, id> *resultWithCycles = [result mutableCopy];
+            resultWithCycles[@"bytesPerCycle"] = @(bytesPerNanosecond / cpuFrequencyGHz);
+            result = resultWithCycles;
+        }
+        [results addObject:result];
+    }
+
+    NSDictionary *report = @{
+        @"cpuFrequencyGHz" : @(cpuFrequencyGHz),
+        @"benchmarks" : results,
+    };
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:error];
+    return (data && [data writeToFile:path options:NSDataWritingAtomic error:error]);
+}
+
+NSInteger SRBenchmarkCompareResults(NSString *path, double threshold, NSError **error)
+{
+    NSData *data = [NSData dataWithContentsOfFile:path options:0 error:error];
+    NSDictionary *baseline = (data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:error] : nil);
+    if (![baseline isKindOfClass:[NSDictionary class]]) {
+        return -1;
+    }
+
+    NSMutableDictionary<NSString *, NSDictionary *> *baselineResults = [NSMutableDictionary dictionary];
+    for (NSDictionary *result in baseline[@"benchmarks"]) {
+        baselineResults[result[@"name"]] = result;
+    }
+
+    printf("\n# Comparison with %s (threshold %.0f%%)\n", path.fileSystemRepresentation, threshold * 100);
+    NSInteger regressionCount = 0;
+    for (NSDictionary<NSString *, id> *result in SRBenchmarkRecordedResults()) {
+        NSString *name = result[@"name"];
+        NSDictionary *baselineResult = baselineResults[name];
+        // Latency percentiles are too noisy to gate on, only per-operation results are compared.
+        if (!baselineResult || !result[@"allocsPerOp"] || !baselineResult[@"allocsPerOp"]) {
+            continue;
+        }
+
+        double allocations = [result[@"allocsPerOp"] doubleValue];
+        double baselineAllocations = [baselineResult[@"allocsPerOp"] doubleValue];
+        BOOL allocationsRegressed = (allocations > baselineAllocations + SRAllocationsTolerance);
+
+        // Allocations counted by the audit of the library itself have no time.
+        if (!result[@"nsPerOp"] || !baselineResult[@"nsPerOp"]) {
+            if (allocationsRegressed) {
+                regressionCount++;
+            }
+            printf("%-48s %8.2f -> %8.2f allocs/op%s\n",
+                   name.UTF8String, baselineAllocations, allocations, (allocationsRegressed ? "  REGRESSION" : ""));
+            continue;
+        }
+
+        double time = [result[@"nsPerOp"] doubleValue];
+        double baselineTime = [baselineResult[@"nsPerOp"] doubleValue];
+        BOOL timeRegressed = (time > baselineTime * (1.0 + threshold));
+        if (timeRegressed || allocationsRegressed) {
+            regressionCount++;
+        }
+        printf("%-48s %12.1f -> %12.1f ns/op (%+6.1f%%) %8.2f -> %8.2f allocs/op%s\n",
+               name.UTF8String,
+               baselineTime, time, (baselineTime > 0 ? (time / baselineTime - 1.0) * 100 : 0),
+               baselineAllocations, allocations,
+               (timeRegressed || allocationsRegressed ? "  REGRESSION" : ""));
+    }
+    return regressionCount;
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRConcurrentDeliveryBenchmarks.h"
+
+#import <stdatomic.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const uint32_t SRConcurrentDeliveryMessageCount = 20000;
+static const NSUInteger SRConcurrentDeliveryMessageLength = 1024;
+static const uint32_t SRConcurrentDeliveryKeyCount = 64;
+
+@interface SRConcurrentDeliveryBenchmarkDelegate : NSObject <SRWebSocketDelegate>
+{
+@public
+    atomic_uint _handledCount;
+    atomic_uint _orderViolationCount;
+    uint32_t _lastIndexes[SRConcurrentDeliveryKeyCount];
+    dispatch_semaphore_t _finished;
+}
+@end
+
+@implementation SRConcurrentDeliveryBenchmarkDelegate
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _finished = dispatch_semaphore_create(0);
+    memset(_lastIndexes, 0xFF, sizeof(_lastIndexes));
+
+    return self;
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    uint32_t index = 0;
+    [data getBytes:&index length:sizeof(index)];
+
+    // Stands in for decoding and handling, roughly 50us of work per message.
+    const uint8_t *bytes = data.bytes;
+    uint32_t hash = 2166136261u;
+    for (NSUInteger round = 0; round < 64; round++) {
+        for (NSUInteger i = 0; i < data.length; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+    __asm__ volatile("" : : "r"(hash));
+
+    // Messages with the same key are never handled at the same time, so plain reads and writes are fine here.
+    uint32_t key = index % SRConcurrentDeliveryKeyCount;
+    if (_lastIndexes[key] != UINT32_MAX && _lastIndexes[key] > index) {
+        atomic_fetch_add_explicit(&_orderViolationCount, 1, memory_order_relaxed);
+    }
+    _lastIndexes[key] = index;
+
+    if (atomic_fetch_add_explicit(&_handledCount, 1, memory_order_relaxed) + 1 == SRConcurrentDeliveryMessageCount) {
+        dispatch_semaphore_signal(_finished);
+    }
+}
+
+@end
+
+static double SRConcurrentDeliveryRun(NSUInteger width, NSUInteger *orderViolationCount)
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    SRConcurrentDeliveryBenchmarkDelegate *delegate = [[SRConcurrentDeliveryBenchmarkDelegate alloc] init];
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = delegate;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.delegate", DISPATCH_QUEUE_CONCURRENT);
+    webSocket.concurrentDeliveryWidth = width;
+    webSocket.messageOrderingKeyBlock = ^id _Nullable(id message) {
+        uint32_t index = 0;
+        [(NSData *)message getBytes:&index length:sizeof(index)];
+        return @(index % SRConcurrentDeliveryKeyCount);
+    };
+    [webSocket open];
+
+    if (![server acceptConnection]) {
+        return 0.0;
+    }
+
+    uint64_t startTime = SRMonotonicTimeNanoseconds();
+    NSMutableData *payload = [NSMutableData dataWithLength:SRConcurrentDeliveryMessageLength];
+    for (uint32_t i = 0; i < SRConcurrentDeliveryMessageCount; i++) {
+        memcpy(payload.mutableBytes, &i, sizeof(i));
+        [server sendFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload];
+    }
+    dispatch_semaphore_wait(delegate->_finished, DISPATCH_TIME_FOREVER);
+    uint64_t duration = SRMonotonicTimeNanoseconds() - startTime;
+
+    *orderViolationCount = atomic_load(&delegate->_orderViolationCount);
+
+    [webSocket close];
+    [server close];
+
+    return (double)SRConcurrentDeliveryMessageCount / ((double)duration / NSEC_PER_SEC);
+}
+
+void SRRunConcurrentDeliveryBenchmarks(void)
+{
+    printf("\n# Keyed concurrent delivery, %u messages over %u keys\n", SRConcurrentDeliveryMessageCount, SRConcurrentDeliveryKeyCount);
+
+    NSUInteger processorCount = [NSProcessInfo processInfo].activeProcessorCount;
+    NSMutableArray<NSNumber *> *widths = [NSMutableArray array];
+    for (NSUInteger width = 1; width < processorCount; width *= 2) {
+        [widths addObject:@(width)];
+    }
+    [widths addObject:@(processorCount)];
+
+    double baseline = 0.0;
+    for (NSNumber *width in widths) {
+        NSUInteger orderViolationCount = 0;
+        double messagesPerSecond = SRConcurrentDeliveryRun(width.unsignedIntegerValue, &orderViolationCount);
+        if (baseline == 0.0) {
+            baseline = messagesPerSecond;
+        }
+        printf("%-48s %12.0f msg/s %8.2fx %8lu out of order\n",
+               [NSString stringWithFormat:@"delivery/keyed/width-%@", width].UTF8String,
+               messagesPerSecond,
+               (baseline > 0.0 ? messagesPerSecond / baseline : 0.0),
+               (unsigned long)orderViolationCount);
+    }
+}
+
+NS_ASSUME_NONNULL_END
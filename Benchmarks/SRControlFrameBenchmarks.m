@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRControlFrameBenchmarks.h"
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRBenchmark.h"
+#import "SRTLocalServer.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+void SRRunControlFrameBenchmarks(void)
+{
+    printf("\n# Pong latency with a blocked delegate queue\n");
+
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    if (!server) {
+        printf("Failed to start the server.\n");
+        return;
+    }
+
+    dispatch_queue_t delegateQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.delegate", DISPATCH_QUEUE_SERIAL);
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegateDispatchQueue = delegateQueue;
+    [webSocket open];
+
+    if (![server acceptConnection]) {
+        printf("Failed to accept the connection.\n");
+        return;
+    }
+    while (webSocket.readyState == SR_CONNECTING) {
+        usleep(1000);
+    }
+
+    const NSUInteger count = 100;
+    uint64_t latencies[count];
+
+    // Simulates a main thread that is busy with layout for the whole run.
+    dispatch_async(delegateQueue, ^{
+        usleep(5 * USEC_PER_SEC);
+    });
+
+    for (NSUInteger i = 0; i < count; i++) {
+        uint64_t sendTime = SRMonotonicTimeNanoseconds();
+        [server sendFrameWithOpCode:SRTOpCodePing payload:[NSData dataWithBytes:&sendTime length:sizeof(sendTime)]];
+
+        SRTOpCode opCode = 0;
+        NSData *payload = nil;
+        do {
+            payload = [server readFrameWithOpCode:&opCode];
+        } while (payload && opCode != SRTOpCodePong);
+
+        latencies[i] = SRMonotonicTimeNanoseconds() - sendTime;
+        usleep(10 * USEC_PER_MSEC);
+    }
+
+    SRBenchmarkReportLatencies(@"control/pong", latencies, count);
+
+    [webSocket close];
+    [server close];
+}
+
+NS_ASSUME_NONNULL_END
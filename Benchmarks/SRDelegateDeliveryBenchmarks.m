@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRDelegateDeliveryBenchmarks.h"
+
+#import "SRBenchmark.h"
+#import "SRDelegateController.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static void SRMeasureDeliveryLatency(NSString *name, SRDelegateController *controller)
+{
+    const NSUInteger count = 20000;
+    uint64_t *latencies = calloc(count, sizeof(uint64_t));
+
+    // Stands in for the socket work queue, which reads and decodes messages.
+    dispatch_queue_t workQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.work", DISPATCH_QUEUE_SERIAL);
+
+    // Messages are delivered one at a time, so latency doesn't include time spent behind earlier messages.
+    dispatch_semaphore_t delivered = dispatch_semaphore_create(0);
+    for (NSUInteger i = 0; i < count; i++) {
+        dispatch_async(workQueue, ^{
+            uint64_t readTime = SRMonotonicTimeNanoseconds();
+            [controller performDelegateBlock:^(id<SRWebSocketDelegate> _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+                latencies[i] = SRMonotonicTimeNanoseconds() - readTime;
+                dispatch_semaphore_signal(delivered);
+            }];
+        });
+        dispatch_semaphore_wait(delivered, DISPATCH_TIME_FOREVER);
+    }
+
+    SRBenchmarkReportLatencies(name, latencies, count);
+    free(latencies);
+}
+
+void SRRunDelegateDeliveryBenchmarks(void)
+{
+    printf("\n# Delegate delivery latency (read to handler)\n");
+
+    // Main queue isn't measured, since this tool doesn't run a main run loop.
+    // A private serial queue stands in for it with the same number of hops.
+    SRDelegateController *dispatchQueueController = [[SRDelegateController alloc] init];
+    dispatchQueueController.dispatchQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.delegate", DISPATCH_QUEUE_SERIAL);
+    SRMeasureDeliveryLatency(@"delivery/dispatchQueue", dispatchQueueController);
+
+    SRDelegateController *operationQueueController = [[SRDelegateController alloc] init];
+    NSOperationQueue *operationQueue = [[NSOperationQueue alloc] init];
+    operationQueue.maxConcurrentOperationCount = 1;
+    operationQueueController.operationQueue = operationQueue;
+    SRMeasureDeliveryLatency(@"delivery/operationQueue", operationQueueController);
+
+    SRDelegateController *inlineController = [[SRDelegateController alloc] init];
+    inlineController.performsInline = YES;
+    SRMeasureDeliveryLatency(@"delivery/inline", inlineController);
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,25 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Drives `clientCount` sockets through end-to-end scenarios against an echo server: small message ping-pong, large message throughput,
+ fragmented messages, mixed text and binary messages, and `idleCount` idle sockets.
+
+ @param echoURL     URL of an external echo server, e.g. `/echo` of the servers in `TestChatServer/`.
+ `nil` starts a loopback echo server for every socket inside this process, its CPU time is then included in the results.
+ @param clientCount Number of sockets that send messages at the same time.
+ @param idleCount   Number of sockets in the idle scenario.
+ */
+extern void SRRunEchoBenchmarks(NSURL *_Nullable echoURL, NSUInteger clientCount, NSUInteger idleCount);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,391 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SREchoBenchmarks.h"
+
+#import <limits.h>
+#import <mach/mach.h>
+#import <sys/resource.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRBenchmark.h"
+#import "SRTLocalServer.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const NSTimeInterval SREchoTimeout = 60.0;
+static const NSTimeInterval SREchoIdleDuration = 5.0;
+
+// Text payloads start with the send time as decimal digits, binary payloads with the send time as a raw `uint64_t`.
+static const NSUInteger SREchoTextTimestampLength = 20;
+
+static dispatch_time_t SREchoDeadline(void)
+{
+    return dispatch_time(DISPATCH_TIME_NOW, (int64_t)(SREchoTimeout * NSEC_PER_SEC));
+}
+
+@interface SREchoClient : NSObject <SRWebSocketDelegate>
+{
+@public
+    SRWebSocket *_webSocket;
+    // Only set if the client has a loopback server of its own.
+    SRTLocalServer *_Nullable _server;
+    BOOL _echoes;
+
+    dispatch_semaphore_t _opened;
+    dispatch_semaphore_t _finished;
+    dispatch_semaphore_t _window;
+
+    // Accessed only on the delegate queue, read by the driver after `_finished` is signaled.
+    uint64_t _expectedCount;
+    uint64_t _receivedCount;
+    uint64_t _receivedBytes;
+    uint64_t _mismatchCount;
+    uint64_t *_latencies;
+    BOOL _failed;
+}
+@end
+
+@implementation SREchoClient
+
+- (nullable instancetype)initWithURL:(nullable NSURL *)echoURL fragmentLength:(NSUInteger)fragmentLength echoes:(BOOL)echoes
+{
+    self = [super init];
+    if (!self) return self;
+
+    NSURL *url = echoURL;
+    if (!url) {
+        SRTLocalServer *server = [[SRTLocalServer alloc] init];
+        if (!server) {
+            return nil;
+        }
+        _server = server;
+        _echoes = echoes;
+        url = server.URL;
+        [NSThread detachNewThreadWithBlock:^{
+            if ([server acceptConnection] && echoes) {
+                [server echoMessagesWithFragmentLength:fragmentLength];
+                [server close];
+            }
+        }];
+    }
+
+    _opened = dispatch_semaphore_create(0);
+    _finished = dispatch_semaphore_create(0);
+    _window = dispatch_semaphore_create(0);
+
+    _webSocket = [[SRWebSocket alloc] initWithURL:url];
+    _webSocket.delegate = self;
+    _webSocket.delegateDispatchQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.echo", DISPATCH_QUEUE_SERIAL);
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_latencies);
+}
+
+- (BOOL)waitUntilOpen
+{
+    if (dispatch_semaphore_wait(_opened, SREchoDeadline()) != 0) {
+        return NO;
+    }
+    __block BOOL failed = NO;
+    dispatch_sync(_webSocket.delegateDispatchQueue, ^{
+        failed = self->_failed;
+    });
+    return !failed;
+}
+
+- (void)expectMessageCount:(uint64_t)count window:(NSUInteger)window
+{
+    dispatch_sync(_webSocket.delegateDispatchQueue, ^{
+        self->_expectedCount = count;
+        self->_receivedCount = 0;
+        self->_receivedBytes = 0;
+        self->_mismatchCount = 0;
+        free(self->_latencies);
+        self->_latencies = calloc(MAX(count, 1), sizeof(uint64_t));
+    });
+    // Semaphore starts at zero and is filled up, so it can be released while messages are still in flight.
+    _window = dispatch_semaphore_create(0);
+    for (NSUInteger i = 0; i < window; i++) {
+        dispatch_semaphore_signal(_window);
+    }
+}
+
+- (BOOL)sendMessageWithLength:(NSUInteger)length text:(BOOL)text
+{
+    if (dispatch_semaphore_wait(_window, SREchoDeadline()) != 0) {
+        return NO;
+    }
+
+    uint64_t sendTime = SRMonotonicTimeNanoseconds();
+    if (text) {
+        NSString *timestamp = [NSString stringWithFormat:@"%020llu", sendTime];
+        NSString *message = [timestamp stringByPaddingToLength:MAX(length, SREchoTextTimestampLength) withString:@"a" startingAtIndex:0];
+        return [_webSocket sendString:message error:NULL];
+    }
+    NSMutableData *message = [NSMutableData dataWithLength:MAX(length, sizeof(uint64_t))];
+    memcpy(message.mutableBytes, &sendTime, sizeof(sendTime));
+    return [_webSocket sendData:message error:NULL];
+}
+
+- (BOOL)waitUntilFinished
+{
+    return (dispatch_semaphore_wait(_finished, SREchoDeadline()) == 0);
+}
+
+- (void)close
+{
+    [_webSocket close];
+    if (!_echoes) {
+        [_server close];
+    }
+}
+
+- (void)_didReceiveMessageSentAt:(uint64_t)sendTime length:(NSUInteger)length matchesKind:(BOOL)matchesKind
+{
+    if (_receivedCount < _expectedCount) {
+        _latencies[_receivedCount] = SRMonotonicTimeNanoseconds() - sendTime;
+    }
+    if (!matchesKind) {
+        _mismatchCount++;
+    }
+    _receivedBytes += length;
+    _receivedCount++;
+
+    dispatch_semaphore_signal(_window);
+    if (_receivedCount == _expectedCount) {
+        dispatch_semaphore_signal(_finished);
+    }
+}
+
+#pragma mark - SRWebSocketDelegate
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    dispatch_semaphore_signal(_opened);
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    NSString *timestamp = (string.length >= SREchoTextTimestampLength ? [string substringToIndex:SREchoTextTimestampLength] : @"");
+    BOOL isTimestamp = (timestamp.length > 0 &&
+                        [timestamp rangeOfCharacterFromSet:[NSCharacterSet decimalDigitCharacterSet].invertedSet].location == NSNotFound);
+    uint64_t sendTime = (isTimestamp ? strtoull(timestamp.UTF8String, NULL, 10) : SRMonotonicTimeNanoseconds());
+    [self _didReceiveMessageSentAt:sendTime length:[string lengthOfBytesUsingEncoding:NSUTF8StringEncoding] matchesKind:isTimestamp];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    uint64_t sendTime = SRMonotonicTimeNanoseconds();
+    BOOL matchesKind = (data.length >= sizeof(sendTime));
+    if (matchesKind) {
+        [data getBytes:&sendTime length:sizeof(sendTime)];
+    }
+    [self _didReceiveMessageSentAt:sendTime length:data.length matchesKind:matchesKind];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error
+{
+    _failed = YES;
+    fprintf(stderr, "Echo client failed: %s\n", error.localizedDescription.UTF8String);
+    dispatch_semaphore_signal(_opened);
+    dispatch_semaphore_signal(_finished);
+    dispatch_semaphore_signal(_window);
+}
+
+@end
+
+static uint64_t SRProcessCPUTimeMicroseconds(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * USEC_PER_SEC +
+        (uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec;
+}
+
+// Peak resident size of the process in bytes.
+static uint64_t SRPeakResidentSize(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_maxrss;
+}
+
+static uint64_t SRCurrentResidentSize(void)
+{
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+// Every loopback socket takes three descriptors, the default limit doesn't allow for many of them.
+static void SRRaiseFileDescriptorLimit(void)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return;
+    }
+    rlim_t wanted = MIN((rlim_t)OPEN_MAX, limit.rlim_max);
+    if (limit.rlim_cur < wanted) {
+        limit.rlim_cur = wanted;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void SREchoCloseClients(NSArray<SREchoClient *> *clients)
+{
+    for (SREchoClient *client in clients) {
+        [client close];
+    }
+}
+
+static nullable NSArray<SREchoClient *> *SREchoOpenClients(NSURL *_Nullable echoURL, NSUInteger count, NSUInteger fragmentLength, BOOL echoes)
+{
+    NSMutableArray<SREchoClient *> *clients = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        SREchoClient *client = [[SREchoClient alloc] initWithURL:echoURL fragmentLength:fragmentLength echoes:echoes];
+        if (!client) {
+            break;
+        }
+        [clients addObject:client];
+        [client->_webSocket open];
+    }
+
+    BOOL opened = (clients.count == count);
+    for (SREchoClient *client in clients) {
+        opened = ([client waitUntilOpen] && opened);
+    }
+    if (!opened) {
+        fprintf(stderr, "Failed to open %lu echo clients\n", (unsigned long)count);
+        SREchoCloseClients(clients);
+        return nil;
+    }
+    return clients;
+}
+
+static void SREchoRunTraffic(NSString *name,
+                             NSURL *_Nullable echoURL,
+                             NSUInteger clientCount,
+                             NSUInteger fragmentLength,
+                             NSUInteger messageCount,
+                             NSUInteger messageLength,
+                             NSUInteger window,
+                             BOOL mixed)
+{
+    NSArray<SREchoClient *> *clients = SREchoOpenClients(echoURL, clientCount, fragmentLength, YES);
+    if (!clients) {
+        return;
+    }
+    for (SREchoClient *client in clients) {
+        [client expectMessageCount:messageCount window:window];
+    }
+
+    uint64_t startCPUTime = SRProcessCPUTimeMicroseconds();
+    uint64_t startTime = SRMonotonicTimeNanoseconds();
+
+    // Each client gets a thread of its own, so that a client waiting for its window doesn't hold back the others.
+    dispatch_group_t group = dispatch_group_create();
+    for (SREchoClient *client in clients) {
+        dispatch_group_enter(group);
+        [NSThread detachNewThreadWithBlock:^{
+            for (NSUInteger i = 0; i < messageCount; i++) {
+                if (![client sendMessageWithLength:messageLength text:(mixed && i % 2 == 0)]) {
+                    break;
+                }
+            }
+            [client waitUntilFinished];
+            dispatch_group_leave(group);
+        }];
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    uint64_t elapsedTime = SRMonotonicTimeNanoseconds() - startTime;
+    uint64_t cpuTime = SRProcessCPUTimeMicroseconds() - startCPUTime;
+
+    uint64_t receivedCount = 0;
+    uint64_t receivedBytes = 0;
+    uint64_t errorCount = 0;
+    uint64_t *latencies = calloc(clientCount * messageCount, sizeof(uint64_t));
+    for (SREchoClient *client in clients) {
+        dispatch_sync(client->_webSocket.delegateDispatchQueue, ^{});
+        uint64_t count = MIN(client->_receivedCount, client->_expectedCount);
+        memcpy(latencies + receivedCount, client->_latencies, count * sizeof(uint64_t));
+        receivedCount += count;
+        receivedBytes += client->_receivedBytes;
+        errorCount += client->_mismatchCount + (client->_expectedCount - count) + (client->_failed ? 1 : 0);
+    }
+    SREchoCloseClients(clients);
+
+    double seconds = (double)elapsedTime / NSEC_PER_SEC;
+    SRBenchmarkReportValues(name, @{
+        @"messagesPerSecond" : @(receivedCount / seconds),
+        @"megabytesPerSecond" : @(receivedBytes / seconds / 1000000.0),
+        @"cpuMicrosecondsPerMessage" : @((double)cpuTime / MAX(receivedCount, (uint64_t)1)),
+        @"peakResidentMegabytes" : @(SRPeakResidentSize() / 1000000.0),
+        @"errors" : @(errorCount),
+    });
+    SRBenchmarkReportLatencies([name stringByAppendingString:@"/latency"], latencies, (NSUInteger)receivedCount);
+    free(latencies);
+}
+
+static void SREchoRunIdle(NSURL *_Nullable echoURL, NSUInteger idleCount)
+{
+    uint64_t startResidentSize = SRCurrentResidentSize();
+    uint64_t startTime = SRMonotonicTimeNanoseconds();
+    NSArray<SREchoClient *> *clients = SREchoOpenClients(echoURL, idleCount, 0, NO);
+    if (!clients) {
+        return;
+    }
+    uint64_t openTime = SRMonotonicTimeNanoseconds() - startTime;
+    double residentSizeGrowth = (double)SRCurrentResidentSize() - (double)startResidentSize;
+
+    uint64_t startCPUTime = SRProcessCPUTimeMicroseconds();
+    [NSThread sleepForTimeInterval:SREchoIdleDuration];
+    uint64_t cpuTime = SRProcessCPUTimeMicroseconds() - startCPUTime;
+
+    SREchoCloseClients(clients);
+
+    SRBenchmarkReportValues([NSString stringWithFormat:@"echo/idle/%lu", (unsigned long)idleCount], @{
+        @"openMilliseconds" : @((double)openTime / NSEC_PER_MSEC),
+        @"residentKilobytesPerSocket" : @(residentSizeGrowth / 1024.0 / idleCount),
+        @"cpuMicrosecondsPerSocketSecond" : @((double)cpuTime / idleCount / SREchoIdleDuration),
+        @"peakResidentMegabytes" : @(SRPeakResidentSize() / 1000000.0),
+    });
+}
+
+void SRRunEchoBenchmarks(NSURL *_Nullable echoURL, NSUInteger clientCount, NSUInteger idleCount)
+{
+    SRRaiseFileDescriptorLimit();
+
+    printf("\n# End-to-end echo (%lu clients, %s)\n",
+           (unsigned long)clientCount,
+           (echoURL ? echoURL.absoluteString.UTF8String : "in-process loopback servers"));
+
+    SREchoRunTraffic(@"echo/pingPong/16", echoURL, clientCount, 0, 5000, 16, 1, NO);
+    SREchoRunTraffic(@"echo/throughput/1048576", echoURL, clientCount, 0, 200, 1024 * 1024, 4, NO);
+    if (!echoURL) {
+        SREchoRunTraffic(@"echo/fragmented/262144", echoURL, clientCount, 4096, 500, 256 * 1024, 8, NO);
+    } else {
+        // External servers decide on their own how to frame a message.
+        printf("%-48s skipped, needs the in-process server\n", "echo/fragmented/262144");
+    }
+    SREchoRunTraffic(@"echo/mixed/1024", echoURL, clientCount, 0, 20000, 1024, 32, YES);
+    SREchoRunIdle(echoURL, idleCount);
+}
+
+NS_ASSUME_NONNULL_END
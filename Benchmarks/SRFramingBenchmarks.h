@@ -0,0 +1,17 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Compares allocations and payload copies per outgoing message for the different send paths.
+extern void SRRunFramingBenchmarks(void);
+
+NS_ASSUME_NONNULL_END
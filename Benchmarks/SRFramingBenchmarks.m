@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRFramingBenchmarks.h"
+
+#import "SRBenchmark.h"
+#import "SRFrameBufferPool.h"
+#import "SRFrameHeader.h"
+#import "SRMessageBuilder+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Stands in for serializing an application message (e.g. a protobuf) into `bytes`.
+static void SRSerializeMessage(uint8_t *bytes, size_t length)
+{
+    memset(bytes, 0x2A, length);
+}
+
+void SRRunFramingBenchmarks(void)
+{
+    const size_t payloadLengths[] = { 16, 1024, 64 * 1024 };
+    const NSUInteger iterations = 100000;
+
+    SRFrameBufferPool *bufferPool = [[SRFrameBufferPool alloc] init];
+
+    printf("\n# Framing (payload copies per message: sendData 2, sendDataNoCopy 1, builder 0)\n");
+    for (size_t i = 0; i < sizeof(payloadLengths) / sizeof(payloadLengths[0]); i++) {
+        size_t length = payloadLengths[i];
+
+        SRBenchmarkRun([NSString stringWithFormat:@"framing/sendData/%zu", length], iterations, ^{
+            NSMutableData *payload = [[NSMutableData alloc] initWithLength:length];
+            SRSerializeMessage(payload.mutableBytes, length);
+            NSData *frame = SRFrameDataCreate(SROpCodeBinaryFrame, [payload copy]);
+            (void)frame;
+        });
+
+        SRBenchmarkRun([NSString stringWithFormat:@"framing/sendDataNoCopy/%zu", length], iterations, ^{
+            NSMutableData *payload = [[NSMutableData alloc] initWithLength:length];
+            SRSerializeMessage(payload.mutableBytes, length);
+            NSData *frame = SRFrameDataCreate(SROpCodeBinaryFrame, payload);
+            (void)frame;
+        });
+
+        SRBenchmarkRun([NSString stringWithFormat:@"framing/builder/%zu", length], iterations, ^{
+            SRMessageBuilder *builder = [[SRMessageBuilder alloc] initWithBufferPool:bufferPool capacity:length];
+            builder.length = length;
+            SRSerializeMessage(builder.mutableBytes, length);
+            NSData *frame = [builder finishFrameWithOpCode:SROpCodeBinaryFrame];
+            (void)frame;
+        });
+    }
+
+    printf("\n# Scatter-gather (64 byte envelope + body)\n");
+    NSData *envelope = [[NSMutableData alloc] initWithLength:64];
+    for (size_t i = 1; i < sizeof(payloadLengths) / sizeof(payloadLengths[0]); i++) {
+        size_t length = payloadLengths[i];
+        NSData *body = [[NSMutableData alloc] initWithLength:length];
+
+        SRBenchmarkRun([NSString stringWithFormat:@"framing/concatenate/%zu", length], iterations, ^{
+            NSMutableData *payload = [[NSMutableData alloc] initWithCapacity:envelope.length + body.length];
+            [payload appendData:envelope];
+            [payload appendData:body];
+            NSData *frame = SRFrameDataCreate(SROpCodeBinaryFrame, payload);
+            (void)frame;
+        });
+
+        SRBenchmarkRun([NSString stringWithFormat:@"framing/sendDataParts/%zu", length], iterations, ^{
+            NSData *frame = SRFrameDataCreateWithParts(SROpCodeBinaryFrame, @[ envelope, body ], bufferPool);
+            (void)frame;
+        });
+    }
+
+    printf("\n# Strings\n");
+    for (size_t i = 0; i < sizeof(payloadLengths) / sizeof(payloadLengths[0]); i++) {
+        size_t length = payloadLengths[i];
+        NSDictionary<NSString *, NSString *> *strings = @{
+            @"ascii" : [@"" stringByPaddingToLength:length withString:@"a" startingAtIndex:0],
+            @"utf8" : [@"" stringByPaddingToLength:length / 2 withString:@"\u00e9" startingAtIndex:0],
+        };
+        for (NSString *kind in @[ @"ascii", @"utf8" ]) {
+            NSString *string = strings[kind];
+
+            SRBenchmarkRun([NSString stringWithFormat:@"framing/dataUsingEncoding/%@/%zu", kind, length], iterations, ^{
+                NSData *frame = SRFrameDataCreate(SROpCodeTextFrame, [[string copy] dataUsingEncoding:NSUTF8StringEncoding]);
+                (void)frame;
+            });
+
+            SRBenchmarkRun([NSString stringWithFormat:@"framing/encodeIntoFrame/%@/%zu", kind, length], iterations, ^{
+                NSData *frame = SRFrameDataCreateWithString(SROpCodeTextFrame, string, bufferPool);
+                (void)frame;
+            });
+        }
+    }
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Measures the building blocks of the read and write paths in isolation: masking, UTF-8 validation, header scanning,
+// frame header encoding and decoding, consumer pooling and delegate dispatch.
+extern void SRRunKernelBenchmarks(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRKernelBenchmarks.h"
+
+#import "SRBenchmark.h"
+#import "SRDelegateController.h"
+#import "SRFrameHeader.h"
+#import "SRIOConsumerPool.h"
+#import "SRSIMDHelpers.h"
+#import "SRScanner.h"
+#import "SRUTF8Validation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Kernels that take only a few nanoseconds run in batches, so that the autorelease pool around each iteration doesn't dominate.
+static const NSUInteger SRKernelBatchSize = 1000;
+
+static const size_t SRKernelPayloadLengths[] = { 16, 1024, 64 * 1024 };
+static const size_t SRKernelPayloadLengthCount = sizeof(SRKernelPayloadLengths) / sizeof(SRKernelPayloadLengths[0]);
+
+static void SRRunMaskBenchmarks(void)
+{
+    printf("\n# Masking\n");
+    uint8_t maskKey[sizeof(uint32_t)] = { 0x12, 0x34, 0x56, 0x78 };
+    for (size_t i = 0; i < SRKernelPayloadLengthCount; i++) {
+        size_t length = SRKernelPayloadLengths[i];
+        NSMutableData *payload = [[NSMutableData alloc] initWithLength:length];
+        NSMutableData *destination = [[NSMutableData alloc] initWithLength:length];
+
+        SRBenchmarkRunWithByteCount([NSString stringWithFormat:@"kernel/mask/%zu", length], 100000, length, ^{
+            SRMaskBytesSIMD(payload.mutableBytes, length, maskKey);
+        });
+        SRBenchmarkRunWithByteCount([NSString stringWithFormat:@"kernel/maskCopy/%zu", length], 100000, length, ^{
+            SRMaskCopyBytesSIMD(destination.mutableBytes, payload.bytes, length, maskKey);
+        });
+    }
+}
+
+static void SRRunUTF8ValidationBenchmarks(void)
+{
+    printf("\n# UTF-8 validation\n");
+    for (size_t i = 1; i < SRKernelPayloadLengthCount; i++) {
+        size_t length = SRKernelPayloadLengths[i];
+        NSDictionary<NSString *, NSData *> *payloads = @{
+            @"ascii" : [[@"" stringByPaddingToLength:length withString:@"a" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding],
+            @"utf8" : [[@"" stringByPaddingToLength:length / 2 withString:@"é" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding],
+        };
+        for (NSString *kind in @[ @"ascii", @"utf8" ]) {
+            NSData *payload = payloads[kind];
+            SRBenchmarkRunWithByteCount([NSString stringWithFormat:@"kernel/utf8/%@/%zu", kind, length], 10000, payload.length, ^{
+                int32_t validLength = SRValidUTF8Length(payload);
+                NSCAssert(validLength == (int32_t)payload.length, @"Payload should be valid UTF-8.");
+                (void)validLength;
+            });
+        }
+    }
+}
+
+static void SRRunScannerBenchmarks(void)
+{
+    printf("\n# Header scanning (CRLFCRLF)\n");
+    static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
+
+    NSData *response = [@"HTTP/1.1 101 Switching Protocols\r\n"
+                        "Upgrade: websocket\r\n"
+                        "Connection: Upgrade\r\n"
+                        "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+                        "Sec-WebSocket-Protocol: chat\r\n"
+                        "Server: SocketRocketBenchmark\r\n"
+                        "Date: Thu, 01 Jan 1970 00:00:00 GMT\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+    SRBenchmarkRunWithByteCount(@"kernel/scan/response", 100000, response.length, ^{
+        size_t foundLength = SRScanUntilBytes(response, CRLFCRLFBytes, sizeof(CRLFCRLFBytes));
+        NSCAssert(foundLength == response.length, @"Terminator should be found at the end.");
+        (void)foundLength;
+    });
+
+    // Header that is still incomplete is rescanned from the start on every read.
+    NSMutableData *incomplete = [[NSMutableData alloc] initWithLength:16 * 1024];
+    memset(incomplete.mutableBytes, 'a', incomplete.length);
+    SRBenchmarkRunWithByteCount(@"kernel/scan/incomplete/16384", 10000, incomplete.length, ^{
+        size_t foundLength = SRScanUntilBytes(incomplete, CRLFCRLFBytes, sizeof(CRLFCRLFBytes));
+        (void)foundLength;
+    });
+}
+
+static void SRRunFrameHeaderBenchmarks(void)
+{
+    printf("\n# Frame headers (per %lu headers)\n", (unsigned long)SRKernelBatchSize);
+    for (size_t i = 0; i < SRKernelPayloadLengthCount; i++) {
+        size_t length = SRKernelPayloadLengths[i];
+        uint8_t header[SRFrameHeaderMaxLength];
+        uint8_t maskKey[sizeof(uint32_t)] = { 0x12, 0x34, 0x56, 0x78 };
+
+        SRBenchmarkRun([NSString stringWithFormat:@"kernel/frameHeader/encode/%zu", length], 10000, ^{
+            for (NSUInteger j = 0; j < SRKernelBatchSize; j++) {
+                SRFrameHeaderWriteWithMaskKey(header, SROpCodeBinaryFrame, length, maskKey);
+            }
+        });
+
+        SRFrameHeaderWriteWithMaskKey(header, SROpCodeBinaryFrame, length, maskKey);
+        __block volatile uint64_t decodedLength = 0;
+        SRBenchmarkRun([NSString stringWithFormat:@"kernel/frameHeader/decode/%zu", length], 10000, ^{
+            for (NSUInteger j = 0; j < SRKernelBatchSize; j++) {
+                // Same steps as the read path: fixed 2 bytes first, then the extended payload length.
+                uint8_t opCode = header[0] & SROpCodeMask;
+                BOOL fin = !!(header[0] & SRFinMask);
+                uint8_t payloadLength = header[1] & SRPayloadLenMask;
+                size_t extendedLengthSize = SRFrameHeaderExtendedLengthSize(payloadLength);
+                decodedLength = SRFrameHeaderReadExtendedLength(header + 2, payloadLength) + opCode + fin + extendedLengthSize;
+            }
+        });
+    }
+}
+
+static void SRRunConsumerPoolBenchmarks(void)
+{
+    printf("\n# Consumer pool\n");
+    SRIOConsumerPool *pool = [[SRIOConsumerPool alloc] init];
+    data_callback handler = ^(SRWebSocket *webSocket, NSData *data) {};
+
+    SRBenchmarkRun(@"kernel/consumerPool/churn", 1000000, ^{
+        SRIOConsumer *consumer = [pool consumerWithScanner:nil handler:handler bytesNeeded:2 readToCurrentFrame:NO unmaskBytes:NO];
+        [pool returnConsumer:consumer];
+    });
+
+    // Steady state of the read path keeps a header and a payload consumer outstanding.
+    SRBenchmarkRun(@"kernel/consumerPool/churn/outstanding", 1000000, ^{
+        SRIOConsumer *header = [pool consumerWithScanner:nil handler:handler bytesNeeded:2 readToCurrentFrame:NO unmaskBytes:NO];
+        SRIOConsumer *payload = [pool consumerWithScanner:nil handler:handler bytesNeeded:1024 readToCurrentFrame:YES unmaskBytes:NO];
+        [pool returnConsumer:header];
+        [pool returnConsumer:payload];
+    });
+}
+
+static void SRRunDelegateDispatchBenchmarks(void)
+{
+    printf("\n# Delegate dispatch (cost on the work queue)\n");
+    SRDelegateBlock block = ^(id<SRWebSocketDelegate> _Nullable delegate, SRDelegateAvailableMethods availableMethods) {};
+
+    SRDelegateController *inlineController = [[SRDelegateController alloc] init];
+    inlineController.performsInline = YES;
+    SRBenchmarkRun(@"kernel/delegateDispatch/inline", 1000000, ^{
+        [inlineController performDelegateBlock:block];
+    });
+
+    SRDelegateController *queueController = [[SRDelegateController alloc] init];
+    dispatch_queue_t delegateQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.delegate", DISPATCH_QUEUE_SERIAL);
+    queueController.dispatchQueue = delegateQueue;
+    SRBenchmarkRun(@"kernel/delegateDispatch/dispatchQueue", 1000000, ^{
+        [queueController performDelegateBlock:block];
+    });
+    dispatch_sync(delegateQueue, ^{});
+
+    queueController.orderingLaneCount = 4;
+    SRBenchmarkRun(@"kernel/delegateDispatch/keyed", 1000000, ^{
+        [queueController performDelegateBlock:block orderingKey:@"key"];
+    });
+    dispatch_sync(delegateQueue, ^{});
+}
+
+void SRRunKernelBenchmarks(void)
+{
+    SRRunMaskBenchmarks();
+    SRRunUTF8ValidationBenchmarks();
+    SRRunScannerBenchmarks();
+    SRRunFrameHeaderBenchmarks();
+    SRRunConsumerPoolBenchmarks();
+    SRRunDelegateDispatchBenchmarks();
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Measures round trips through an in-memory `SRLoopbackTransport`, so results contain the cost of the library
+// and of the minimal built-in server only, without the kernel network stack.
+extern void SRRunLoopbackBenchmarks(void);
+
+NS_ASSUME_NONNULL_END
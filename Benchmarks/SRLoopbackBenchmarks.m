@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRLoopbackBenchmarks.h"
+
+#import <sys/resource.h>
+
+#import <SocketRocket/SRLoopbackTransport.h>
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRBenchmark.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const NSTimeInterval SRLoopbackTimeout = 60.0;
+
+static dispatch_time_t SRLoopbackDeadline(void)
+{
+    return dispatch_time(DISPATCH_TIME_NOW, (int64_t)(SRLoopbackTimeout * NSEC_PER_SEC));
+}
+
+static uint64_t SRLoopbackCPUTimeMicroseconds(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * USEC_PER_SEC +
+        (uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec;
+}
+
+@interface SRLoopbackBenchmarkDelegate : NSObject <SRWebSocketDelegate>
+{
+@public
+    dispatch_semaphore_t _opened;
+    dispatch_semaphore_t _received;
+}
+@end
+
+@implementation SRLoopbackBenchmarkDelegate
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _opened = dispatch_semaphore_create(0);
+    _received = dispatch_semaphore_create(0);
+
+    return self;
+}
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    dispatch_semaphore_signal(_opened);
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    dispatch_semaphore_signal(_received);
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    dispatch_semaphore_signal(_received);
+}
+
+@end
+
+// Sends one message at a time and waits for its echo. Besides the round trip time, reports the CPU time of the whole process
+// per echoed message, which is the cost of the socket and of the server, since nothing else runs meanwhile.
+static void SRRunLoopbackRoundTrips(NSString *name, SRLoopbackTransport *transport, NSUInteger length, BOOL text, NSUInteger iterations)
+{
+    SRLoopbackBenchmarkDelegate *delegate = [[SRLoopbackBenchmarkDelegate alloc] init];
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:[NSURL URLWithString:@"ws://loopback/"]];
+    webSocket.delegate = delegate;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.loopback", DISPATCH_QUEUE_SERIAL);
+    webSocket.loopbackTransport = transport;
+    [webSocket open];
+    if (dispatch_semaphore_wait(delegate->_opened, SRLoopbackDeadline()) != 0) {
+        printf("%-48s failed to open\n", name.UTF8String);
+        return;
+    }
+
+    NSString *string = [@"" stringByPaddingToLength:length withString:@"a" startingAtIndex:0];
+    NSData *data = [NSMutableData dataWithLength:length];
+    __block BOOL timedOut = NO;
+
+    uint64_t cpuStartTime = SRLoopbackCPUTimeMicroseconds();
+    SRBenchmarkRunWithByteCount(name, iterations, 2 * length, ^{
+        if (timedOut) {
+            return;
+        }
+        if (text) {
+            [webSocket sendString:string error:NULL];
+        } else {
+            [webSocket sendData:data error:NULL];
+        }
+        timedOut = (dispatch_semaphore_wait(delegate->_received, SRLoopbackDeadline()) != 0);
+    });
+    uint64_t cpuTime = SRLoopbackCPUTimeMicroseconds() - cpuStartTime;
+    SRWebSocketMetrics *metrics = webSocket.metrics;
+    [webSocket close];
+
+    NSUInteger messageCount = transport.receivedMessageCount;
+    if (timedOut || messageCount == 0) {
+        printf("%-48s timed out waiting for an echo\n", name.UTF8String);
+        return;
+    }
+    SRBenchmarkReportValues([name stringByAppendingString:@"/cpu"], @{
+        @"cpuMicrosecondsPerMessage" : @((double)cpuTime / messageCount),
+    });
+    SRBenchmarkReportAllocationAudit(name, metrics);
+}
+
+void SRRunLoopbackBenchmarks(void)
+{
+    printf("\n# Round trips over the in-memory loopback transport\n");
+
+    SRRunLoopbackRoundTrips(@"loopback/pingPong/16", [[SRLoopbackTransport alloc] init], 16, YES, 20000);
+    SRRunLoopbackRoundTrips(@"loopback/pingPong/1024", [[SRLoopbackTransport alloc] init], 1024, NO, 10000);
+    SRRunLoopbackRoundTrips(@"loopback/throughput/1048576", [[SRLoopbackTransport alloc] init], 1024 * 1024, NO, 200);
+
+    // Segment sized chunks, 0.5 ms one way and 1 Gbit/s make delivery look like a fast local network, the same on every run.
+    SRLoopbackTransport *shapedTransport = [[SRLoopbackTransport alloc] init];
+    shapedTransport.chunkLength = 1460;
+    shapedTransport.latency = 0.0005;
+    shapedTransport.bandwidth = 125 * 1000 * 1000;
+    SRRunLoopbackRoundTrips(@"loopback/shaped/65536", shapedTransport, 64 * 1024, NO, 200);
+}
+
+NS_ASSUME_NONNULL_END
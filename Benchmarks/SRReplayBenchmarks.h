@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Measures the receive pipeline by replaying a capture as fast as possible, without a socket.
+// `nil` records a capture of mixed traffic from the loopback server first, so runs are comparable with a baseline.
+extern void SRRunReplayBenchmarks(NSURL *_Nullable captureURL);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRReplayBenchmarks.h"
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRBenchmark.h"
+#import "SRTLocalServer.h"
+#import "SRTrafficCapture.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SRReplayBenchmarkDelegate : NSObject <SRWebSocketDelegate>
+{
+@public
+    dispatch_semaphore_t _closed;
+}
+@end
+
+@implementation SRReplayBenchmarkDelegate
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _closed = dispatch_semaphore_create(0);
+
+    return self;
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(nullable NSString *)reason wasClean:(BOOL)wasClean
+{
+    dispatch_semaphore_signal(_closed);
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error
+{
+    dispatch_semaphore_signal(_closed);
+}
+
+@end
+
+static BOOL SRRecordMixedTrafficCapture(NSURL *captureURL)
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    if (!server) {
+        return NO;
+    }
+
+    SRReplayBenchmarkDelegate *delegate = [[SRReplayBenchmarkDelegate alloc] init];
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = delegate;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.delegate", DISPATCH_QUEUE_SERIAL);
+    webSocket.captureFileURL = captureURL;
+    [webSocket open];
+
+    if (![server acceptConnection]) {
+        return NO;
+    }
+
+    NSData *textPayload = [[@"" stringByPaddingToLength:100 withString:@"text " startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *binaryPayload = [NSMutableData dataWithLength:64 * 1024];
+    for (NSUInteger i = 0; i < 1000; i++) {
+        [server sendFrameWithOpCode:SRTOpCodeTextFrame payload:textPayload];
+        if (i % 10 == 0) {
+            [server sendFrameWithOpCode:SRTOpCodeBinaryFrame payload:binaryPayload];
+        }
+        if (i % 50 == 0) {
+            // Fragmented text message.
+            [server sendFrameWithOpCode:SRTOpCodeTextFrame payload:textPayload fin:NO];
+            [server sendFrameWithOpCode:SRTOpCodeContinuationFrame payload:textPayload fin:NO];
+            [server sendFrameWithOpCode:SRTOpCodeContinuationFrame payload:textPayload fin:YES];
+        }
+    }
+    uint16_t closeCode = CFSwapInt16HostToBig(SRStatusCodeNormal);
+    [server sendFrameWithOpCode:SRTOpCodeConnectionClose payload:[NSData dataWithBytes:&closeCode length:sizeof(closeCode)]];
+
+    SRTOpCode opCode = 0;
+    while ([server readFrameWithOpCode:&opCode] && opCode != SRTOpCodeConnectionClose) {
+    }
+    BOOL closed = (dispatch_semaphore_wait(delegate->_closed, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC)) == 0);
+    [server close];
+    return closed;
+}
+
+void SRRunReplayBenchmarks(NSURL *_Nullable captureURL)
+{
+    printf("\n# Capture replay through the receive pipeline\n");
+
+    NSURL *url = captureURL;
+    if (!url) {
+        url = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"SRReplayBenchmarks.capture"]];
+        if (!SRRecordMixedTrafficCapture(url)) {
+            printf("Failed to record a capture.\n");
+            return;
+        }
+    }
+
+    __block size_t receivedLength = 0;
+    NSError *error = nil;
+    BOOL success = SRTrafficCaptureEnumerateRecords(url, &error, ^(SRTrafficCaptureRecordType type, uint64_t timestamp, NSData *payload, BOOL *stop) {
+        if (type == SRTrafficCaptureRecordTypeReceived) {
+            receivedLength += payload.length;
+        }
+    });
+    if (!success) {
+        printf("Failed to read the capture: %s\n", error.localizedDescription.UTF8String);
+        return;
+    }
+
+    NSString *name = (captureURL ? @"replay/capture" : @"replay/mixed");
+    NSURL *replayURL = [NSURL URLWithString:@"ws://localhost"];
+    dispatch_queue_t delegateQueue = dispatch_queue_create("com.facebook.socketrocket.benchmark.delegate", DISPATCH_QUEUE_SERIAL);
+    SRWebSocket *(^replay)(void) = ^SRWebSocket *{
+        SRReplayBenchmarkDelegate *delegate = [[SRReplayBenchmarkDelegate alloc] init];
+        SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:replayURL];
+        webSocket.delegate = delegate;
+        webSocket.delegateDispatchQueue = delegateQueue;
+        if ([webSocket replayCaptureFromURL:url atRecordedSpeed:NO error:NULL]) {
+            dispatch_semaphore_wait(delegate->_closed, DISPATCH_TIME_FOREVER);
+        }
+        return webSocket;
+    };
+    SRBenchmarkRunWithByteCount(name, 20, receivedLength, ^{
+        replay();
+    });
+    // Once more outside of the measured iterations, for the allocations the socket counted itself.
+    SRBenchmarkReportAllocationAudit(name, replay().metrics);
+
+    if (!captureURL) {
+        [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+    }
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Compares arming and cancelling timers on the shared timer wheel with a dispatch timer per socket,
+// then opens and closes 10k sockets, each of them arming timeouts.
+extern void SRRunTimerBenchmarks(void);
+
+NS_ASSUME_NONNULL_END
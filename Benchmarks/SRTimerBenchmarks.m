@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRTimerBenchmarks.h"
+
+#import <netinet/in.h>
+#import <sys/socket.h>
+#import <unistd.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRBenchmark.h"
+#import "SRTime.h"
+#import "SRTimerWheel.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Returns a URL on the loopback interface that nothing listens on, so connections are refused right away.
+static NSURL *SRClosedPortURL(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = {
+        .sin_len = sizeof(struct sockaddr_in),
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addressLength = sizeof(address);
+    bind(fd, (struct sockaddr *)&address, addressLength);
+    getsockname(fd, (struct sockaddr *)&address, &addressLength);
+    close(fd);
+    return [NSURL URLWithString:[NSString stringWithFormat:@"ws://127.0.0.1:%d/", ntohs(address.sin_port)]];
+}
+
+static void SRRunSocketChurnBenchmark(void)
+{
+    const NSUInteger socketCount = 10000;
+    // Keeps the number of open file descriptors under the default limit.
+    const NSUInteger batchSize = 100;
+
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:SRClosedPortURL()];
+    request.timeoutInterval = 30;
+
+    uint64_t startTime = SRMonotonicTimeNanoseconds();
+    for (NSUInteger opened = 0; opened < socketCount; opened += batchSize) {
+        @autoreleasepool {
+            NSMutableArray<SRWebSocket *> *sockets = [NSMutableArray arrayWithCapacity:batchSize];
+            for (NSUInteger i = 0; i < batchSize; i++) {
+                SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURLRequest:request];
+                webSocket.idleTimeout = 60;
+                webSocket.closeTimeout = 5;
+                [webSocket open];
+                [webSocket close];
+                [sockets addObject:webSocket];
+            }
+            for (SRWebSocket *webSocket in sockets) {
+                while (webSocket.readyState != SR_CLOSED) {
+                    usleep(100);
+                }
+            }
+        }
+    }
+    uint64_t elapsedTime = SRMonotonicTimeNanoseconds() - startTime;
+
+    printf("%-48s %12.1f us/socket %10.2f s total\n",
+           "timers/openClose10k",
+           (double)elapsedTime / socketCount / NSEC_PER_USEC,
+           (double)elapsedTime / NSEC_PER_SEC);
+}
+
+void SRRunTimerBenchmarks(void)
+{
+    printf("\n# Timers\n");
+
+    const NSUInteger iterations = 10000;
+    dispatch_queue_t queue = dispatch_queue_create("com.facebook.socketrocket.benchmark.timers", DISPATCH_QUEUE_SERIAL);
+
+    SRTimerWheel *timerWheel = [SRTimerWheel sharedWheel];
+    SRBenchmarkRun(@"timers/timerWheel/armCancel", iterations, ^{
+        SRTimerWheelTimer *timer = [timerWheel scheduleTimerWithDelay:30 queue:queue block:^{}];
+        [timerWheel cancelTimer:timer];
+    });
+
+    SRBenchmarkRun(@"timers/dispatchSource/armCancel", iterations, ^{
+        dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+        dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, 30 * NSEC_PER_SEC), DISPATCH_TIME_FOREVER, NSEC_PER_SEC / 100);
+        dispatch_source_set_event_handler(timer, ^{});
+        dispatch_resume(timer);
+        dispatch_source_cancel(timer);
+    });
+
+    SRRunSocketChurnBenchmark();
+}
+
+NS_ASSUME_NONNULL_END
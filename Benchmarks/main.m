@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SRBenchmarkReport.h"
+#import "SRConcurrentDeliveryBenchmarks.h"
+#import "SRControlFrameBenchmarks.h"
+#import "SRDelegateDeliveryBenchmarks.h"
+#import "SREchoBenchmarks.h"
+#import "SRFramingBenchmarks.h"
+#import "SRKernelBenchmarks.h"
+#import "SRLoopbackBenchmarks.h"
+#import "SRReplayBenchmarks.h"
+#import "SRTimerBenchmarks.h"
+
+static void SRPrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--suite <name>]... [--json <path>] [--compare <baseline>] [--threshold <fraction>] [--cpu-ghz <frequency>]\n"
+            "       [--echo-url <url>] [--clients <count>] [--idle <count>] [--capture <path>]\n"
+            "  --suite      run only the named suite: kernels, framing, delivery, concurrentDelivery, controlFrames, timers, echo, loopback, replay\n"
+            "  --json       write results as JSON\n"
+            "  --compare    compare results with a JSON baseline, exit with 1 on regressions\n"
+            "  --threshold  allowed growth of ns/op when comparing (default 0.1)\n"
+            "  --cpu-ghz    CPU clock frequency, to report bytes per cycle\n"
+            "  --echo-url   external echo server for the echo suite (default: in-process loopback servers)\n"
+            "  --clients    sockets sending at the same time in the echo suite (default 4)\n"
+            "  --idle       idle sockets in the echo suite (default 200)\n"
+            "  --capture    capture file for the replay suite, written via SRWebSocket.captureFileURL (default: recorded mixed traffic)\n",
+            program);
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+        NSMutableSet<NSString *> *suites = [NSMutableSet set];
+        NSString *resultsPath = nil;
+        NSString *baselinePath = nil;
+        double threshold = 0.1;
+        double cpuFrequencyGHz = 0;
+        NSURL *echoURL = nil;
+        NSUInteger echoClientCount = 4;
+        NSUInteger echoIdleCount = 200;
+        NSURL *captureURL = nil;
+
+        for (int i = 1; i < argc; i++) {
+            NSString *option = @(argv[i]);
+            if (i + 1 >= argc) {
+                SRPrintUsage(argv[0]);
+                return 2;
+            }
+            NSString *value = @(argv[++i]);
+            if ([option isEqualToString:@"--suite"]) {
+                [suites addObject:value];
+            } else if ([option isEqualToString:@"--json"]) {
+                resultsPath = value;
+            } else if ([option isEqualToString:@"--compare"]) {
+                baselinePath = value;
+            } else if ([option isEqualToString:@"--threshold"]) {
+                threshold = value.doubleValue;
+            } else if ([option isEqualToString:@"--cpu-ghz"]) {
+                cpuFrequencyGHz = value.doubleValue;
+            } else if ([option isEqualToString:@"--echo-url"]) {
+                echoURL = [NSURL URLWithString:value];
+            } else if ([option isEqualToString:@"--clients"]) {
+                echoClientCount = (NSUInteger)MAX(value.integerValue, 1);
+            } else if ([option isEqualToString:@"--idle"]) {
+                echoIdleCount = (NSUInteger)MAX(value.integerValue, 1);
+            } else if ([option isEqualToString:@"--capture"]) {
+                captureURL = [NSURL fileURLWithPath:value];
+            } else {
+                SRPrintUsage(argv[0]);
+                return 2;
+            }
+        }
+
+        NSArray<NSString *> *suiteOrder = @[ @"kernels", @"framing", @"delivery", @"concurrentDelivery", @"controlFrames", @"timers", @"echo", @"loopback", @"replay" ];
+        NSDictionary<NSString *, void (^)(void)> *suiteBlocks = @{
+            @"kernels" : ^{ SRRunKernelBenchmarks(); },
+            @"framing" : ^{ SRRunFramingBenchmarks(); },
+            @"delivery" : ^{ SRRunDelegateDeliveryBenchmarks(); },
+            @"concurrentDelivery" : ^{ SRRunConcurrentDeliveryBenchmarks(); },
+            @"controlFrames" : ^{ SRRunControlFrameBenchmarks(); },
+            @"timers" : ^{ SRRunTimerBenchmarks(); },
+            @"echo" : ^{ SRRunEchoBenchmarks(echoURL, echoClientCount, echoIdleCount); },
+            @"loopback" : ^{ SRRunLoopbackBenchmarks(); },
+            @"replay" : ^{ SRRunReplayBenchmarks(captureURL); },
+        };
+        for (NSString *suite in suites) {
+            if (!suiteBlocks[suite]) {
+                SRPrintUsage(argv[0]);
+                return 2;
+            }
+        }
+        for (NSString *suite in suiteOrder) {
+            if (suites.count == 0 || [suites containsObject:suite]) {
+                suiteBlocks[suite]();
+            }
+        }
+
+        if (resultsPath) {
+            NSError *error = nil;
+            if (!SRBenchmarkWriteResults(resultsPath, cpuFrequencyGHz, &error)) {
+                fprintf(stderr, "Failed to write results: %s\n", error.localizedDescription.UTF8String);
+                return 2;
+            }
+        }
+        if (baselinePath) {
+            NSError *error = nil;
+            NSInteger regressionCount = SRBenchmarkCompareResults(baselinePath, threshold, &error);
+            if (regressionCount < 0) {
+                fprintf(stderr, "Failed to read baseline: %s\n", error.localizedDescription.UTF8String);
+                return 2;
+            }
+            if (regressionCount > 0) {
+                fprintf(stderr, "%ld benchmarks regressed\n", (long)regressionCount);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ High dynamic range histogram of positive integer values with 3 significant digits, laid out like HdrHistogram,
+ so that recording is constant time and histograms of different connections can be added up.
+ Not thread-safe.
+ */
+@interface SRHdrHistogram : NSObject
+
+@property (nonatomic, assign, readonly) uint64_t totalCount;
+@property (nonatomic, assign, readonly) uint64_t minimumValue;
+@property (nonatomic, assign, readonly) uint64_t maximumValue;
+@property (nonatomic, assign, readonly) double meanValue;
+
+/**
+ @param highestTrackableValue Values above this are recorded as this value.
+ */
+- (instancetype)initWithHighestTrackableValue:(uint64_t)highestTrackableValue NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+- (void)recordValue:(uint64_t)value;
+
+/**
+ Adds all values of `histogram`, which must have the same highest trackable value.
+ */
+- (void)addHistogram:(SRHdrHistogram *)histogram;
+
+/**
+ Highest value that `percentile` percent of the values are equivalent to or below, `0` if nothing was recorded.
+ */
+- (uint64_t)valueAtPercentile:(double)percentile;
+
+/**
+ Percentile distribution in the text format of HdrHistogram (`.hgrm`), which its plotter reads.
+
+ @param scale Values are divided by this for output, e.g. `1000` to print microseconds as milliseconds.
+ */
+- (NSString *)percentileDistributionWithScale:(double)scale;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRHdrHistogram.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 3 significant digits need 2 * 10^3 sub-buckets, rounded up to a power of two.
+static const uint32_t SRHdrSubBucketCountMagnitude = 11;
+static const uint32_t SRHdrSubBucketHalfCountMagnitude = SRHdrSubBucketCountMagnitude - 1;
+static const uint64_t SRHdrSubBucketCount = 1ULL << SRHdrSubBucketCountMagnitude;
+static const uint64_t SRHdrSubBucketHalfCount = SRHdrSubBucketCount / 2;
+static const uint64_t SRHdrSubBucketMask = SRHdrSubBucketCount - 1;
+
+// Percentiles reported per halving of the distance to 100%, the same as the default of HdrHistogram.
+static const double SRHdrPercentileTicksPerHalfDistance = 5;
+
+static uint32_t SRHdrBucketIndex(uint64_t value)
+{
+    uint32_t powerOfTwoCeiling = 64 - (uint32_t)__builtin_clzll(value | SRHdrSubBucketMask);
+    return powerOfTwoCeiling - (SRHdrSubBucketHalfCountMagnitude + 1);
+}
+
+static size_t SRHdrCountsIndex(uint64_t value)
+{
+    uint32_t bucketIndex = SRHdrBucketIndex(value);
+    uint64_t subBucketIndex = value >> bucketIndex;
+    return ((size_t)(bucketIndex + 1) << SRHdrSubBucketHalfCountMagnitude) + (size_t)(subBucketIndex - SRHdrSubBucketHalfCount);
+}
+
+static uint64_t SRHdrHighestEquivalentValue(size_t index)
+{
+    int64_t bucketIndex = (int64_t)(index >> SRHdrSubBucketHalfCountMagnitude) - 1;
+    uint64_t subBucketIndex = (index & (SRHdrSubBucketHalfCount - 1)) + SRHdrSubBucketHalfCount;
+    if (bucketIndex < 0) {
+        subBucketIndex -= SRHdrSubBucketHalfCount;
+        bucketIndex = 0;
+    }
+    uint64_t lowestEquivalentValue = subBucketIndex << bucketIndex;
+    return lowestEquivalentValue + (1ULL << bucketIndex) - 1;
+}
+
+@implementation SRHdrHistogram {
+    uint64_t _highestTrackableValue;
+    uint64_t *_counts;
+    size_t _countsLength;
+    double _sum;
+}
+
+- (instancetype)initWithHighestTrackableValue:(uint64_t)highestTrackableValue
+{
+    self = [super init];
+    if (!self) return self;
+
+    _highestTrackableValue = MAX(highestTrackableValue, SRHdrSubBucketCount);
+    _countsLength = SRHdrCountsIndex(_highestTrackableValue) + 1;
+    _counts = calloc(_countsLength, sizeof(uint64_t));
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_counts);
+}
+
+- (void)recordValue:(uint64_t)value
+{
+    value = MIN(value, _highestTrackableValue);
+    _counts[SRHdrCountsIndex(value)]++;
+    _minimumValue = (_totalCount == 0 ? value : MIN(_minimumValue, value));
+    _maximumValue = MAX(_maximumValue, value);
+    _totalCount++;
+    _sum += value;
+}
+
+- (void)addHistogram:(SRHdrHistogram *)histogram
+{
+    NSParameterAssert(histogram->_countsLength == _countsLength);
+    if (histogram->_totalCount == 0) {
+        return;
+    }
+    for (size_t i = 0; i < _countsLength; i++) {
+        _counts[i] += histogram->_counts[i];
+    }
+    _minimumValue = (_totalCount == 0 ? histogram->_minimumValue : MIN(_minimumValue, histogram->_minimumValue));
+    _maximumValue = MAX(_maximumValue, histogram->_maximumValue);
+    _totalCount += histogram->_totalCount;
+    _sum += histogram->_sum;
+}
+
+- (double)meanValue
+{
+    return (_totalCount > 0 ? _sum / _totalCount : 0);
+}
+
+- (uint64_t)valueAtPercentile:(double)percentile
+{
+    if (_totalCount == 0) {
+        return 0;
+    }
+    uint64_t countAtPercentile = MAX((uint64_t)ceil(MIN(percentile, 100.0) / 100.0 * _totalCount), 1);
+    uint64_t count = 0;
+    for (size_t i = 0; i < _countsLength; i++) {
+        count += _counts[i];
+        if (count >= countAtPercentile) {
+            return MIN(SRHdrHighestEquivalentValue(i), _maximumValue);
+        }
+    }
+    return _maximumValue;
+}
+
+- (uint64_t)_countAtOrBelowValue:(uint64_t)value
+{
+    size_t lastIndex = MIN(SRHdrCountsIndex(MIN(value, _highestTrackableValue)), _countsLength - 1);
+    uint64_t count = 0;
+    for (size_t i = 0; i <= lastIndex; i++) {
+        count += _counts[i];
+    }
+    return count;
+}
+
+- (NSString *)percentileDistributionWithScale:(double)scale
+{
+    NSMutableString *output = [NSMutableString stringWithFormat:@"%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)"];
+
+    double percentile = 0;
+    while (_totalCount > 0) {
+        uint64_t value = [self valueAtPercentile:percentile];
+        uint64_t count = [self _countAtOrBelowValue:value];
+        if (count >= _totalCount) {
+            [output appendFormat:@"%12.3f %2.12f %10llu\n", value / scale, 1.0, count];
+            break;
+        }
+        [output appendFormat:@"%12.3f %2.12f %10llu %14.2f\n", value / scale, percentile / 100.0, count, 1.0 / (1.0 - percentile / 100.0)];
+
+        double reportingTicks = SRHdrPercentileTicksPerHalfDistance * pow(2, floor(log2(100.0 / (100.0 - percentile))) + 1);
+        percentile += 100.0 / reportingTicks;
+    }
+
+    double variance = 0;
+    if (_totalCount > 0) {
+        double mean = self.meanValue;
+        for (size_t i = 0; i < _countsLength; i++) {
+            if (_counts[i] > 0) {
+                double deviation = SRHdrHighestEquivalentValue(i) - mean;
+                variance += deviation * deviation * _counts[i];
+            }
+        }
+        variance /= _totalCount;
+    }
+    [output appendFormat:@"#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", self.meanValue / scale, sqrt(variance) / scale];
+    [output appendFormat:@"#[Max     = %12.3f, Total count    = %12llu]\n", _maximumValue / scale, _totalCount];
+    [output appendFormat:@"#[Buckets = %12zu, SubBuckets     = %12llu]\n", _countsLength >> SRHdrSubBucketHalfCountMagnitude, SRHdrSubBucketCount];
+    return output;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
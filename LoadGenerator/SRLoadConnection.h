@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+@class SRHdrHistogram;
+@class SRLoadPhase;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Highest latency in microseconds that histograms tell apart, longer ones are recorded as this.
+extern const uint64_t SRLoadHighestTrackableLatency;
+
+/**
+ A single socket of the load generator. Once open, it runs through the phases and measures the round trip time of every message
+ that comes back, so the server is expected to echo messages. Sent messages start with the send time, as decimal digits in text
+ messages and as a raw `uint64_t` in binary ones.
+ */
+@interface SRLoadConnection : NSObject
+
+- (instancetype)initWithIdentifier:(NSUInteger)identifier
+                               URL:(NSURL *)url
+                            phases:(NSArray<SRLoadPhase *> *)phases
+                     finishedGroup:(dispatch_group_t)finishedGroup NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Opens the socket. `finishedGroup` is entered right away and left once the script is done or the socket failed.
+ */
+- (void)start;
+
+/**
+ Closes the socket. Messages that come back afterwards are not counted.
+ */
+- (void)stop;
+
+/**
+ Adds the latencies of this connection to `latencyHistogram` and its connect time to `connectHistogram`, both in microseconds,
+ and returns its statistics as a JSON-compatible dictionary.
+ */
+- (NSDictionary<NSString *, id> *)statisticsAddingLatenciesToHistogram:(SRHdrHistogram *)latencyHistogram
+                                                      connectHistogram:(SRHdrHistogram *)connectHistogram;
+
+@end
+
+NS_ASSUME_NONNULL_END
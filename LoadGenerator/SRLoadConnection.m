@@ -0,0 +1,289 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRLoadConnection.h"
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRHdrHistogram.h"
+#import "SRLoadPhase.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+const uint64_t SRLoadHighestTrackableLatency = 60 * USEC_PER_SEC;
+
+static const NSUInteger SRLoadTextTimestampLength = 20;
+
+@interface SRLoadConnection () <SRWebSocketDelegate>
+@end
+
+@implementation SRLoadConnection {
+    NSUInteger _identifier;
+    NSArray<SRLoadPhase *> *_phases;
+    dispatch_group_t _finishedGroup;
+
+    // Everything below is accessed only on `_queue`, which is also the delegate queue of the socket.
+    dispatch_queue_t _queue;
+    SRWebSocket *_webSocket;
+    dispatch_source_t _sendTimer;
+
+    uint64_t _startTime;
+    uint64_t _openTime;
+    uint64_t _scriptStartTime;
+    uint64_t _nextSendTime;
+    NSUInteger _phaseIndex;
+    BOOL _finished;
+    BOOL _stopped;
+
+    uint64_t _sentCount;
+    uint64_t _sentBytes;
+    uint64_t _receivedCount;
+    uint64_t _receivedBytes;
+    uint64_t _errorCount;
+    NSString *_lastError;
+    SRHdrHistogram *_latencyHistogram;
+}
+
+- (instancetype)initWithIdentifier:(NSUInteger)identifier
+                               URL:(NSURL *)url
+                            phases:(NSArray<SRLoadPhase *> *)phases
+                     finishedGroup:(dispatch_group_t)finishedGroup
+{
+    self = [super init];
+    if (!self) return self;
+
+    _identifier = identifier;
+    _phases = [phases copy];
+    _finishedGroup = finishedGroup;
+
+    _queue = dispatch_queue_create("com.facebook.socketrocket.loadgenerator.connection", DISPATCH_QUEUE_SERIAL);
+    _latencyHistogram = [[SRHdrHistogram alloc] initWithHighestTrackableValue:SRLoadHighestTrackableLatency];
+    _phaseIndex = NSNotFound;
+
+    _webSocket = [[SRWebSocket alloc] initWithURL:url];
+    _webSocket.delegate = self;
+    _webSocket.delegateDispatchQueue = _queue;
+
+    return self;
+}
+
+- (void)start
+{
+    dispatch_group_enter(_finishedGroup);
+    dispatch_async(_queue, ^{
+        self->_startTime = SRMonotonicTimeNanoseconds();
+        [self->_webSocket open];
+    });
+}
+
+- (void)stop
+{
+    dispatch_sync(_queue, ^{
+        self->_stopped = YES;
+        [self _finish];
+        [self->_webSocket close];
+    });
+}
+
+- (void)_finish
+{
+    if (_finished) {
+        return;
+    }
+    _finished = YES;
+    if (_sendTimer) {
+        dispatch_source_cancel(_sendTimer);
+        _sendTimer = nil;
+    }
+    dispatch_group_leave(_finishedGroup);
+}
+
+- (void)_failWithDescription:(NSString *)description
+{
+    if (_stopped) {
+        return;
+    }
+    _errorCount++;
+    _lastError = description;
+    [self _finish];
+}
+
+///--------------------------------------
+#pragma mark - Sending
+///--------------------------------------
+
+- (void)_sendNext
+{
+    if (_finished) {
+        return;
+    }
+
+    uint64_t now = SRMonotonicTimeNanoseconds();
+    uint64_t phaseEndTime = _scriptStartTime;
+    NSUInteger phaseIndex = 0;
+    for (; phaseIndex < _phases.count; phaseIndex++) {
+        phaseEndTime += (uint64_t)(_phases[phaseIndex].duration * NSEC_PER_SEC);
+        if (now < phaseEndTime) {
+            break;
+        }
+    }
+    if (phaseIndex == _phases.count) {
+        [self _finish];
+        return;
+    }
+
+    SRLoadPhase *phase = _phases[phaseIndex];
+    if (phaseIndex != _phaseIndex) {
+        _phaseIndex = phaseIndex;
+        _nextSendTime = now;
+    }
+
+    uint64_t wakeTime = phaseEndTime;
+    if (phase.messagesPerSecond > 0) {
+        if (now >= _nextSendTime) {
+            [self _sendMessageForPhase:phase];
+            // Sending follows a fixed schedule, a late timer catches up instead of lowering the rate.
+            _nextSendTime += (uint64_t)(NSEC_PER_SEC / phase.messagesPerSecond);
+        }
+        wakeTime = MIN(MAX(_nextSendTime, now), phaseEndTime);
+    }
+    dispatch_source_set_timer(_sendTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(wakeTime - now)), DISPATCH_TIME_FOREVER, NSEC_PER_MSEC);
+}
+
+- (void)_sendMessageForPhase:(SRLoadPhase *)phase
+{
+    NSUInteger length = phase.minimumLength + arc4random_uniform((uint32_t)(phase.maximumLength - phase.minimumLength + 1));
+    BOOL binary = (phase.binaryFraction > 0 && arc4random_uniform(10000) < phase.binaryFraction * 10000);
+
+    uint64_t sendTime = SRMonotonicTimeNanoseconds();
+    NSError *error = nil;
+    BOOL sent = NO;
+    if (binary) {
+        NSMutableData *message = [NSMutableData dataWithLength:MAX(length, sizeof(sendTime))];
+        memcpy(message.mutableBytes, &sendTime, sizeof(sendTime));
+        sent = [_webSocket sendData:message error:&error];
+        length = message.length;
+    } else {
+        NSString *timestamp = [NSString stringWithFormat:@"%020llu", sendTime];
+        NSString *message = [timestamp stringByPaddingToLength:MAX(length, SRLoadTextTimestampLength) withString:@"x" startingAtIndex:0];
+        sent = [_webSocket sendString:message error:&error];
+        length = message.length;
+    }
+
+    if (sent) {
+        _sentCount++;
+        _sentBytes += length;
+    } else {
+        _errorCount++;
+        _lastError = error.localizedDescription;
+    }
+}
+
+- (void)_didReceiveMessageSentAt:(uint64_t)sendTime length:(NSUInteger)length
+{
+    if (_stopped) {
+        return;
+    }
+    _receivedCount++;
+    _receivedBytes += length;
+    if (sendTime > 0) {
+        [_latencyHistogram recordValue:(SRMonotonicTimeNanoseconds() - sendTime) / NSEC_PER_USEC];
+    }
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    _openTime = SRMonotonicTimeNanoseconds();
+    if (_finished) {
+        return;
+    }
+    _scriptStartTime = _openTime;
+    _sendTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+    __weak typeof(self) wself = self;
+    dispatch_source_set_event_handler(_sendTimer, ^{
+        [wself _sendNext];
+    });
+    dispatch_resume(_sendTimer);
+    [self _sendNext];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    uint64_t sendTime = 0;
+    if (string.length >= SRLoadTextTimestampLength) {
+        sendTime = strtoull([string substringToIndex:SRLoadTextTimestampLength].UTF8String, NULL, 10);
+    }
+    [self _didReceiveMessageSentAt:sendTime length:[string lengthOfBytesUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    uint64_t sendTime = 0;
+    if (data.length >= sizeof(sendTime)) {
+        [data getBytes:&sendTime length:sizeof(sendTime)];
+    }
+    [self _didReceiveMessageSentAt:sendTime length:data.length];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error
+{
+    [self _failWithDescription:error.localizedDescription];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(nullable NSString *)reason wasClean:(BOOL)wasClean
+{
+    [self _failWithDescription:[NSString stringWithFormat:@"Closed by the server with code %ld", (long)code]];
+}
+
+///--------------------------------------
+#pragma mark - Statistics
+///--------------------------------------
+
+- (NSDictionary<NSString *, id> *)statisticsAddingLatenciesToHistogram:(SRHdrHistogram *)latencyHistogram
+                                                      connectHistogram:(SRHdrHistogram *)connectHistogram
+{
+    __block NSDictionary<NSString *, id> *statistics = nil;
+    dispatch_sync(_queue, ^{
+        BOOL opened = (self->_openTime > 0);
+        uint64_t connectTime = (opened ? (self->_openTime - self->_startTime) / NSEC_PER_USEC : 0);
+        if (opened) {
+            [connectHistogram recordValue:connectTime];
+        }
+        [latencyHistogram addHistogram:self->_latencyHistogram];
+
+        SRHdrHistogram *histogram = self->_latencyHistogram;
+        statistics = @{
+            @"id" : @(self->_identifier),
+            @"opened" : @(opened),
+            @"connectMicroseconds" : @(connectTime),
+            @"messagesSent" : @(self->_sentCount),
+            @"bytesSent" : @(self->_sentBytes),
+            @"messagesReceived" : @(self->_receivedCount),
+            @"bytesReceived" : @(self->_receivedBytes),
+            @"errors" : @(self->_errorCount),
+            @"lastError" : self->_lastError ?: [NSNull null],
+            @"latencyMicroseconds" : @{
+                @"p50" : @([histogram valueAtPercentile:50]),
+                @"p99" : @([histogram valueAtPercentile:99]),
+                @"max" : @(histogram.maximumValue),
+                @"mean" : @(histogram.meanValue),
+            },
+        };
+    });
+    return statistics;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
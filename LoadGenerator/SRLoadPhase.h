@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Part of the script every connection runs through after it opens: for `duration` seconds,
+ send `messagesPerSecond` messages with lengths uniformly distributed between `minimumLength` and `maximumLength`,
+ `binaryFraction` of them binary and the rest text.
+ */
+@interface SRLoadPhase : NSObject
+
+@property (nonatomic, assign) NSTimeInterval duration;
+@property (nonatomic, assign) double messagesPerSecond;
+@property (nonatomic, assign) NSUInteger minimumLength;
+@property (nonatomic, assign) NSUInteger maximumLength;
+@property (nonatomic, assign) double binaryFraction;
+
+/**
+ Reads a script, a JSON array of phases like `{"duration": 10, "rate": 5, "minSize": 16, "maxSize": 1024, "binaryFraction": 0.5}`.
+ Missing keys take the values of a phase created with `init`.
+ */
++ (nullable NSArray<SRLoadPhase *> *)phasesWithContentsOfURL:(NSURL *)url error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
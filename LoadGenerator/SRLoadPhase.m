@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRLoadPhase.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSError *SRLoadScriptError(NSString *description)
+{
+    return [NSError errorWithDomain:@"SRLoadGenerator" code:1 userInfo:@{ NSLocalizedDescriptionKey : description }];
+}
+
+@implementation SRLoadPhase
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _duration = 30.0;
+    _messagesPerSecond = 1.0;
+    _minimumLength = 64;
+    _maximumLength = 64;
+
+    return self;
+}
+
++ (nullable NSArray<SRLoadPhase *> *)phasesWithContentsOfURL:(NSURL *)url error:(NSError **)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:url options:0 error:error];
+    if (!data) {
+        return nil;
+    }
+    NSArray *objects = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+    if (!objects) {
+        return nil;
+    }
+    if (![objects isKindOfClass:[NSArray class]] || objects.count == 0) {
+        if (error) {
+            *error = SRLoadScriptError(@"Script must be a non-empty array of phases.");
+        }
+        return nil;
+    }
+
+    NSMutableArray<SRLoadPhase *> *phases = [NSMutableArray arrayWithCapacity:objects.count];
+    for (NSDictionary *object in objects) {
+        if (![object isKindOfClass:[NSDictionary class]]) {
+            if (error) {
+                *error = SRLoadScriptError(@"Every phase must be an object.");
+            }
+            return nil;
+        }
+        SRLoadPhase *phase = [[SRLoadPhase alloc] init];
+        if (object[@"duration"]) {
+            phase.duration = [object[@"duration"] doubleValue];
+        }
+        if (object[@"rate"]) {
+            phase.messagesPerSecond = [object[@"rate"] doubleValue];
+        }
+        if (object[@"minSize"]) {
+            phase.minimumLength = [object[@"minSize"] unsignedIntegerValue];
+        }
+        if (object[@"maxSize"]) {
+            phase.maximumLength = [object[@"maxSize"] unsignedIntegerValue];
+        }
+        if (object[@"binaryFraction"]) {
+            phase.binaryFraction = [object[@"binaryFraction"] doubleValue];
+        }
+        phase.maximumLength = MAX(phase.maximumLength, phase.minimumLength);
+        [phases addObject:phase];
+    }
+    return phases;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
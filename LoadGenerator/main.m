@@ -0,0 +1,216 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <limits.h>
+#import <sys/resource.h>
+
+#import "SRHdrHistogram.h"
+#import "SRLoadConnection.h"
+#import "SRLoadPhase.h"
+#import "SRTime.h"
+
+static void SRPrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s --url <url> [--connections <count>] [--ramp <count>] [--duration <seconds>] [--rate <count>]\n"
+            "       [--size <bytes>|<min>-<max>] [--binary <fraction>] [--script <path>] [--drain <seconds>]\n"
+            "       [--json <path>] [--histogram <path>]\n"
+            "  --url          echo server to connect to\n"
+            "  --connections  number of connections (default 100)\n"
+            "  --ramp         connections opened per second (default 100)\n"
+            "  --duration     seconds every connection sends for after it opens (default 30)\n"
+            "  --rate         messages per second per connection (default 1)\n"
+            "  --size         message length in bytes, or a range of lengths to pick from uniformly (default 64)\n"
+            "  --binary       fraction of binary messages, the rest are text (default 0)\n"
+            "  --script       JSON array of phases, replaces --duration, --rate, --size and --binary\n"
+            "  --drain        seconds to wait for outstanding echoes after the last connection finished (default 2)\n"
+            "  --json         write statistics of every connection and the totals as JSON\n"
+            "  --histogram    write the latency distribution in milliseconds as an HdrHistogram percentile file\n",
+            program);
+}
+
+// Every connection takes a file descriptor, the default limit doesn't allow for many of them.
+static void SRRaiseFileDescriptorLimit(void)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return;
+    }
+    rlim_t wanted = MIN((rlim_t)OPEN_MAX, limit.rlim_max);
+    if (limit.rlim_cur < wanted) {
+        limit.rlim_cur = wanted;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static NSDictionary<NSString *, NSNumber *> *SRHistogramSummary(SRHdrHistogram *histogram)
+{
+    return @{
+        @"count" : @(histogram.totalCount),
+        @"p50" : @([histogram valueAtPercentile:50]),
+        @"p90" : @([histogram valueAtPercentile:90]),
+        @"p99" : @([histogram valueAtPercentile:99]),
+        @"p999" : @([histogram valueAtPercentile:99.9]),
+        @"max" : @(histogram.maximumValue),
+        @"mean" : @(histogram.meanValue),
+    };
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+        NSURL *url = nil;
+        NSUInteger connectionCount = 100;
+        double rampRate = 100;
+        double drainDuration = 2;
+        NSString *scriptPath = nil;
+        NSString *resultsPath = nil;
+        NSString *histogramPath = nil;
+        SRLoadPhase *phase = [[SRLoadPhase alloc] init];
+
+        for (int i = 1; i < argc; i++) {
+            NSString *option = @(argv[i]);
+            if (i + 1 >= argc) {
+                SRPrintUsage(argv[0]);
+                return 2;
+            }
+            NSString *value = @(argv[++i]);
+            if ([option isEqualToString:@"--url"]) {
+                url = [NSURL URLWithString:value];
+            } else if ([option isEqualToString:@"--connections"]) {
+                connectionCount = (NSUInteger)MAX(value.integerValue, 1);
+            } else if ([option isEqualToString:@"--ramp"]) {
+                rampRate = MAX(value.doubleValue, 0.001);
+            } else if ([option isEqualToString:@"--duration"]) {
+                phase.duration = value.doubleValue;
+            } else if ([option isEqualToString:@"--rate"]) {
+                phase.messagesPerSecond = value.doubleValue;
+            } else if ([option isEqualToString:@"--size"]) {
+                NSArray<NSString *> *lengths = [value componentsSeparatedByString:@"-"];
+                phase.minimumLength = (NSUInteger)MAX(lengths.firstObject.integerValue, 0);
+                phase.maximumLength = MAX((NSUInteger)MAX(lengths.lastObject.integerValue, 0), phase.minimumLength);
+            } else if ([option isEqualToString:@"--binary"]) {
+                phase.binaryFraction = value.doubleValue;
+            } else if ([option isEqualToString:@"--script"]) {
+                scriptPath = value;
+            } else if ([option isEqualToString:@"--drain"]) {
+                drainDuration = value.doubleValue;
+            } else if ([option isEqualToString:@"--json"]) {
+                resultsPath = value;
+            } else if ([option isEqualToString:@"--histogram"]) {
+                histogramPath = value;
+            } else {
+                SRPrintUsage(argv[0]);
+                return 2;
+            }
+        }
+        if (!url) {
+            SRPrintUsage(argv[0]);
+            return 2;
+        }
+
+        NSArray<SRLoadPhase *> *phases = @[ phase ];
+        if (scriptPath) {
+            NSError *error = nil;
+            phases = [SRLoadPhase phasesWithContentsOfURL:[NSURL fileURLWithPath:scriptPath] error:&error];
+            if (!phases) {
+                fprintf(stderr, "Failed to read script: %s\n", error.localizedDescription.UTF8String);
+                return 2;
+            }
+        }
+
+        SRRaiseFileDescriptorLimit();
+
+        dispatch_group_t finishedGroup = dispatch_group_create();
+        NSMutableArray<SRLoadConnection *> *connections = [NSMutableArray arrayWithCapacity:connectionCount];
+        for (NSUInteger i = 0; i < connectionCount; i++) {
+            [connections addObject:[[SRLoadConnection alloc] initWithIdentifier:i URL:url phases:phases finishedGroup:finishedGroup]];
+        }
+
+        printf("Opening %lu connections to %s at %.0f per second\n", (unsigned long)connectionCount, url.absoluteString.UTF8String, rampRate);
+        uint64_t startTime = SRMonotonicTimeNanoseconds();
+        for (NSUInteger i = 0; i < connectionCount; i++) {
+            uint64_t openTime = startTime + (uint64_t)(i / rampRate * NSEC_PER_SEC);
+            uint64_t now = SRMonotonicTimeNanoseconds();
+            if (openTime > now) {
+                usleep((useconds_t)((openTime - now) / NSEC_PER_USEC));
+            }
+            [connections[i] start];
+        }
+
+        dispatch_group_wait(finishedGroup, DISPATCH_TIME_FOREVER);
+        [NSThread sleepForTimeInterval:drainDuration];
+        for (SRLoadConnection *connection in connections) {
+            [connection stop];
+        }
+        double elapsedSeconds = (double)(SRMonotonicTimeNanoseconds() - startTime) / NSEC_PER_SEC;
+
+        SRHdrHistogram *latencyHistogram = [[SRHdrHistogram alloc] initWithHighestTrackableValue:SRLoadHighestTrackableLatency];
+        SRHdrHistogram *connectHistogram = [[SRHdrHistogram alloc] initWithHighestTrackableValue:SRLoadHighestTrackableLatency];
+        NSMutableArray<NSDictionary *> *connectionStatistics = [NSMutableArray arrayWithCapacity:connectionCount];
+        uint64_t openedCount = 0;
+        uint64_t sentCount = 0;
+        uint64_t receivedCount = 0;
+        uint64_t errorCount = 0;
+        for (SRLoadConnection *connection in connections) {
+            NSDictionary *statistics = [connection statisticsAddingLatenciesToHistogram:latencyHistogram connectHistogram:connectHistogram];
+            [connectionStatistics addObject:statistics];
+            openedCount += [statistics[@"opened"] boolValue] ? 1 : 0;
+            sentCount += [statistics[@"messagesSent"] unsignedLongLongValue];
+            receivedCount += [statistics[@"messagesReceived"] unsignedLongLongValue];
+            errorCount += [statistics[@"errors"] unsignedLongLongValue];
+        }
+
+        printf("Opened %llu of %lu connections, %llu errors\n", openedCount, (unsigned long)connectionCount, errorCount);
+        printf("Sent %llu messages, received %llu in %.1f s\n", sentCount, receivedCount, elapsedSeconds);
+        printf("Connect  p50 %10.1f ms  p99 %10.1f ms  max %10.1f ms\n",
+               [connectHistogram valueAtPercentile:50] / 1000.0,
+               [connectHistogram valueAtPercentile:99] / 1000.0,
+               connectHistogram.maximumValue / 1000.0);
+        printf("Latency  p50 %10.1f ms  p99 %10.1f ms  p999 %10.1f ms  max %10.1f ms\n",
+               [latencyHistogram valueAtPercentile:50] / 1000.0,
+               [latencyHistogram valueAtPercentile:99] / 1000.0,
+               [latencyHistogram valueAtPercentile:99.9] / 1000.0,
+               latencyHistogram.maximumValue / 1000.0);
+
+        if (resultsPath) {
+            NSDictionary *results = @{
+                @"url" : url.absoluteString,
+                @"connectionCount" : @(connectionCount),
+                @"rampRate" : @(rampRate),
+                @"elapsedSeconds" : @(elapsedSeconds),
+                @"openedCount" : @(openedCount),
+                @"messagesSent" : @(sentCount),
+                @"messagesReceived" : @(receivedCount),
+                @"errors" : @(errorCount),
+                @"connectMicroseconds" : SRHistogramSummary(connectHistogram),
+                @"latencyMicroseconds" : SRHistogramSummary(latencyHistogram),
+                @"connections" : connectionStatistics,
+            };
+            NSError *error = nil;
+            NSData *data = [NSJSONSerialization dataWithJSONObject:results options:NSJSONWritingPrettyPrinted error:&error];
+            if (!data || ![data writeToFile:resultsPath options:NSDataWritingAtomic error:&error]) {
+                fprintf(stderr, "Failed to write results: %s\n", error.localizedDescription.UTF8String);
+                return 2;
+            }
+        }
+        if (histogramPath) {
+            NSError *error = nil;
+            NSString *distribution = [latencyHistogram percentileDistributionWithScale:1000.0];
+            if (![distribution writeToFile:histogramPath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+                fprintf(stderr, "Failed to write histogram: %s\n", error.localizedDescription.UTF8String);
+                return 2;
+            }
+        }
+
+        return (errorCount > 0 ? 1 : 0);
+    }
+}
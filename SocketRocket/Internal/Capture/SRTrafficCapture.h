@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// A capture file starts with the magic bytes `SRCP` and a little-endian `uint32_t` version,
+// followed by records of a little-endian header (`uint64_t` nanoseconds since the capture started,
+// `uint32_t` payload length, `uint8_t` type, 3 reserved bytes) and the payload.
+typedef NS_ENUM(uint8_t, SRTrafficCaptureRecordType) {
+    // Bytes as they were appended to the read buffer, including the handshake response.
+    SRTrafficCaptureRecordTypeReceived = 1,
+    // Whole frame as it was queued for writing.
+    SRTrafficCaptureRecordTypeSent = 2,
+    // Handshake response was parsed. Payload is a `uint64_t` number of received bytes that belong to the handshake.
+    SRTrafficCaptureRecordTypeOpen = 3,
+};
+
+typedef void (^SRTrafficCaptureRecordBlock)(SRTrafficCaptureRecordType type, uint64_t timestamp, NSData *payload, BOOL *stop);
+
+// Appends records to a capture file. Every record is written as it happens, so a capture is complete up to a crash of the app.
+// Writes only wait for the page cache, not for the disk. Must be used from a single queue at a time.
+@interface SRTrafficCapture : NSObject
+
+// Replaces the file at `url` if it exists.
+- (nullable instancetype)initWithURL:(NSURL *)url error:(NSError **)error;
+
+- (void)recordReceivedData:(dispatch_data_t)data;
+- (void)recordSentFrame:(NSData *)frameData;
+// `unreadLength` is the number of received bytes that are still in the read buffer after the handshake response.
+- (void)recordOpenWithUnreadLength:(uint64_t)unreadLength;
+
+@end
+
+// Calls `block` with every record in order. A record cut short at the end of the file is skipped.
+// Returns `NO` if the file can't be read or isn't a capture, `block` is never called then.
+extern BOOL SRTrafficCaptureEnumerateRecords(NSURL *url, NSError **error, SRTrafficCaptureRecordBlock block);
+
+NS_ASSUME_NONNULL_END
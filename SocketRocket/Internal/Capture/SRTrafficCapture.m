@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRTrafficCapture.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+
+#import "SRError.h"
+#import "SRLog.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const uint8_t SRTrafficCaptureMagic[4] = {'S', 'R', 'C', 'P'};
+static const uint32_t SRTrafficCaptureVersion = 1;
+
+typedef struct {
+    uint8_t magic[4];
+    uint32_t version;
+} SRTrafficCaptureFileHeader;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t length;
+    uint8_t type;
+    uint8_t reserved[3];
+} SRTrafficCaptureRecordHeader;
+
+static NSError *SRTrafficCaptureError(NSString *description)
+{
+    return SRErrorWithCodeDescription(2149, description);
+}
+
+static BOOL SRTrafficCaptureWriteAll(int fileDescriptor, const void *bytes, size_t length)
+{
+    while (length > 0) {
+        ssize_t writtenLength = write(fileDescriptor, bytes, length);
+        if (writtenLength < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        bytes = (const uint8_t *)bytes + writtenLength;
+        length -= (size_t)writtenLength;
+    }
+    return YES;
+}
+
+@implementation SRTrafficCapture {
+    int _fileDescriptor;
+    uint64_t _startTime;
+    uint64_t _receivedLength;
+    BOOL _failed;
+}
+
+- (nullable instancetype)initWithURL:(NSURL *)url error:(NSError **)error
+{
+    self = [super init];
+    if (!self) return self;
+
+    _fileDescriptor = open(url.fileSystemRepresentation, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (_fileDescriptor < 0) {
+        if (error) {
+            *error = SRTrafficCaptureError([NSString stringWithFormat:@"Unable to open capture file: %s.", strerror(errno)]);
+        }
+        return nil;
+    }
+
+    SRTrafficCaptureFileHeader header;
+    memcpy(header.magic, SRTrafficCaptureMagic, sizeof(header.magic));
+    header.version = OSSwapHostToLittleInt32(SRTrafficCaptureVersion);
+    if (!SRTrafficCaptureWriteAll(_fileDescriptor, &header, sizeof(header))) {
+        if (error) {
+            *error = SRTrafficCaptureError([NSString stringWithFormat:@"Unable to write capture file: %s.", strerror(errno)]);
+        }
+        return nil;
+    }
+
+    _startTime = SRMonotonicTimeNanoseconds();
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+}
+
+- (void)_recordType:(SRTrafficCaptureRecordType)type data:(dispatch_data_t)data
+{
+    if (_failed) {
+        return;
+    }
+
+    SRTrafficCaptureRecordHeader header = {0};
+    header.timestamp = OSSwapHostToLittleInt64(SRMonotonicTimeNanoseconds() - _startTime);
+    header.length = OSSwapHostToLittleInt32((uint32_t)dispatch_data_get_size(data));
+    header.type = type;
+
+    __block BOOL written = SRTrafficCaptureWriteAll(_fileDescriptor, &header, sizeof(header));
+    if (written) {
+        int fileDescriptor = _fileDescriptor;
+        dispatch_data_apply(data, ^bool(dispatch_data_t region, size_t offset, const void *buffer, size_t size) {
+            written = SRTrafficCaptureWriteAll(fileDescriptor, buffer, size);
+            return written;
+        });
+    }
+    if (!written) {
+        // The record is cut short, which readers treat as the end of the capture.
+        _failed = YES;
+        SRWarningLog(@"Stopped capturing traffic: %s", strerror(errno));
+    }
+}
+
+- (void)recordReceivedData:(dispatch_data_t)data
+{
+    _receivedLength += dispatch_data_get_size(data);
+    [self _recordType:SRTrafficCaptureRecordTypeReceived data:data];
+}
+
+- (void)recordSentFrame:(NSData *)frameData
+{
+    // Written right away, so the bytes don't need to outlive this call.
+    dispatch_data_t data = dispatch_data_create(frameData.bytes, frameData.length, nil, ^{});
+    [self _recordType:SRTrafficCaptureRecordTypeSent data:data];
+}
+
+- (void)recordOpenWithUnreadLength:(uint64_t)unreadLength
+{
+    uint64_t handshakeLength = OSSwapHostToLittleInt64(_receivedLength - unreadLength);
+    dispatch_data_t data = dispatch_data_create(&handshakeLength, sizeof(handshakeLength), nil, ^{});
+    [self _recordType:SRTrafficCaptureRecordTypeOpen data:data];
+}
+
+@end
+
+BOOL SRTrafficCaptureEnumerateRecords(NSURL *url, NSError **error, SRTrafficCaptureRecordBlock block)
+{
+    NSError *readError = nil;
+    NSData *capture = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:&readError];
+    if (!capture) {
+        if (error) {
+            *error = SRErrorWithCodeDescriptionUnderlyingError(2149, @"Unable to read capture file.", readError);
+        }
+        return NO;
+    }
+
+    SRTrafficCaptureFileHeader fileHeader;
+    if (capture.length < sizeof(fileHeader)) {
+        if (error) {
+            *error = SRTrafficCaptureError(@"Capture file is too short.");
+        }
+        return NO;
+    }
+    [capture getBytes:&fileHeader length:sizeof(fileHeader)];
+    if (memcmp(fileHeader.magic, SRTrafficCaptureMagic, sizeof(fileHeader.magic)) != 0 ||
+        OSSwapLittleToHostInt32(fileHeader.version) != SRTrafficCaptureVersion) {
+        if (error) {
+            *error = SRTrafficCaptureError(@"File is not a capture of a supported version.");
+        }
+        return NO;
+    }
+
+    NSUInteger offset = sizeof(fileHeader);
+    BOOL stop = NO;
+    while (!stop && capture.length - offset >= sizeof(SRTrafficCaptureRecordHeader)) {
+        SRTrafficCaptureRecordHeader header;
+        [capture getBytes:&header range:NSMakeRange(offset, sizeof(header))];
+        offset += sizeof(header);
+
+        uint32_t length = OSSwapLittleToHostInt32(header.length);
+        if (capture.length - offset < length) {
+            break;
+        }
+        @autoreleasepool {
+            NSData *payload = [capture subdataWithRange:NSMakeRange(offset, length)];
+            block((SRTrafficCaptureRecordType)header.type, OSSwapLittleToHostInt64(header.timestamp), payload, &stop);
+        }
+        offset += length;
+    }
+    return YES;
+}
+
+NS_ASSUME_NONNULL_END
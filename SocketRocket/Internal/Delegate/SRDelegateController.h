@@ -19,11 +19,15 @@ struct SRDelegateAvailableMethods {
     BOOL didReceiveMessage : 1;
     BOOL didReceiveMessageWithString : 1;
     BOOL didReceiveMessageWithData : 1;
+    BOOL didReceiveMessages : 1;
+    BOOL didReceiveDecodedMessage : 1;
+    BOOL didReceiveMessageWithMetadata : 1;
     BOOL didOpen : 1;
     BOOL didFailWithError : 1;
     BOOL didCloseWithCode : 1;
     BOOL didReceivePing : 1;
     BOOL didReceivePong : 1;
+    BOOL didReportMetrics : 1;
     BOOL shouldConvertTextFrameToString : 1;
 };
 
@@ -33,11 +37,15 @@ struct SRDelegateAvailableMethods {
     BOOL didReceiveMessage;
     BOOL didReceiveMessageWithString;
     BOOL didReceiveMessageWithData;
+    BOOL didReceiveMessages;
+    BOOL didReceiveDecodedMessage;
+    BOOL didReceiveMessageWithMetadata;
     BOOL didOpen;
     BOOL didFailWithError;
     BOOL didCloseWithCode;
     BOOL didReceivePing;
     BOOL didReceivePong;
+    BOOL didReportMetrics;
     BOOL shouldConvertTextFrameToString;
 };
 
@@ -54,12 +62,18 @@ typedef void(^SRDelegateBlock)(id<SRWebSocketDelegate> _Nullable delegate, SRDel
 
 @property (nullable, nonatomic, strong) dispatch_queue_t dispatchQueue;
 @property (nullable, nonatomic, strong) NSOperationQueue *operationQueue;
+// If `YES` - blocks are performed synchronously on the calling queue, ignoring `dispatchQueue` and `operationQueue`.
+@property (nonatomic, assign) BOOL performsInline;
+// Number of ordered lanes used by `performDelegateBlock:orderingKey:` on top of `dispatchQueue`. `0` disables keyed delivery.
+@property (nonatomic, assign) NSUInteger orderingLaneCount;
 
 ///--------------------------------------
 #pragma mark - Perform
 ///--------------------------------------
 
 - (void)performDelegateBlock:(SRDelegateBlock)block;
+// Blocks with equal keys are performed in order, others may run in parallel if `dispatchQueue` is concurrent.
+- (void)performDelegateBlock:(SRDelegateBlock)block orderingKey:(nullable id)key;
 - (void)performDelegateQueueBlock:(dispatch_block_t)block;
 
 @end
@@ -9,6 +9,9 @@
 
 #import "SRDelegateController.h"
 
+#import "SRKeyedDispatchQueue.h"
+#import "SRTrace.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface SRDelegateController ()
@@ -17,6 +20,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (atomic, assign, readwrite) SRDelegateAvailableMethods availableDelegateMethods;
 
+// Created lazily for the current `dispatchQueue` and `orderingLaneCount`, accessed only on `accessQueue`.
+@property (nullable, nonatomic, strong) SRKeyedDispatchQueue *keyedQueue;
+
 @end
 
 @implementation SRDelegateController
@@ -24,6 +30,8 @@ NS_ASSUME_NONNULL_BEGIN
 @synthesize delegate = _delegate;
 @synthesize dispatchQueue = _dispatchQueue;
 @synthesize operationQueue = _operationQueue;
+@synthesize performsInline = _performsInline;
+@synthesize orderingLaneCount = _orderingLaneCount;
 
 ///--------------------------------------
 #pragma mark - Init
@@ -53,11 +61,15 @@ NS_ASSUME_NONNULL_BEGIN
             .didReceiveMessage = [delegate respondsToSelector:@selector(webSocket:didReceiveMessage:)],
             .didReceiveMessageWithString = [delegate respondsToSelector:@selector(webSocket:didReceiveMessageWithString:)],
             .didReceiveMessageWithData = [delegate respondsToSelector:@selector(webSocket:didReceiveMessageWithData:)],
+            .didReceiveMessages = [delegate respondsToSelector:@selector(webSocket:didReceiveMessages:)],
+            .didReceiveDecodedMessage = [delegate respondsToSelector:@selector(webSocket:didReceiveDecodedMessage:)],
+            .didReceiveMessageWithMetadata = [delegate respondsToSelector:@selector(webSocket:didReceiveMessageWithMetadata:)],
             .didOpen = [delegate respondsToSelector:@selector(webSocketDidOpen:)],
             .didFailWithError = [delegate respondsToSelector:@selector(webSocket:didFailWithError:)],
             .didCloseWithCode = [delegate respondsToSelector:@selector(webSocket:didCloseWithCode:reason:wasClean:)],
             .didReceivePing = [delegate respondsToSelector:@selector(webSocket:didReceivePingWithData:)],
             .didReceivePong = [delegate respondsToSelector:@selector(webSocket:didReceivePong:)],
+            .didReportMetrics = [delegate respondsToSelector:@selector(webSocket:didReportMetrics:)],
             .shouldConvertTextFrameToString = [delegate respondsToSelector:@selector(webSocketShouldConvertTextFrameToString:)]
         };
     });
@@ -106,31 +118,146 @@ NS_ASSUME_NONNULL_BEGIN
     return queue;
 }
 
+- (void)setPerformsInline:(BOOL)performsInline
+{
+    dispatch_barrier_async(self.accessQueue, ^{
+        self->_performsInline = performsInline;
+    });
+}
+
+- (BOOL)performsInline
+{
+    __block BOOL performsInline = NO;
+    dispatch_sync(self.accessQueue, ^{
+        performsInline = self->_performsInline;
+    });
+    return performsInline;
+}
+
+- (void)setOrderingLaneCount:(NSUInteger)orderingLaneCount
+{
+    dispatch_barrier_async(self.accessQueue, ^{
+        self->_orderingLaneCount = orderingLaneCount;
+    });
+}
+
+- (NSUInteger)orderingLaneCount
+{
+    __block NSUInteger orderingLaneCount = 0;
+    dispatch_sync(self.accessQueue, ^{
+        orderingLaneCount = self->_orderingLaneCount;
+    });
+    return orderingLaneCount;
+}
+
 ///--------------------------------------
 #pragma mark - Perform
 ///--------------------------------------
 
 - (void)performDelegateBlock:(SRDelegateBlock)block
 {
+    SR_TRACE_BEGIN(DelegateDispatch);
     __block __strong id<SRWebSocketDelegate> delegate = nil;
     __block SRDelegateAvailableMethods availableMethods = {};
+    __block BOOL performsInline = NO;
+    __block dispatch_queue_t dispatchQueue = nil;
+    __block NSOperationQueue *operationQueue = nil;
+    // Single read of everything, since this runs for every message.
     dispatch_sync(self.accessQueue, ^{
         delegate = self->_delegate; // Not `OK` to go through `self`, since queue sync.
         availableMethods = self.availableDelegateMethods; // `OK` to call through `self`, since no queue sync.
+        performsInline = self->_performsInline;
+        dispatchQueue = self->_dispatchQueue;
+        operationQueue = self->_operationQueue;
     });
-    [self performDelegateQueueBlock:^{
+    [self _performBlock:^{
+        SR_TRACE_BEGIN(DelegateRun);
         block(delegate, availableMethods);
-    }];
+        SR_TRACE_END(DelegateRun, 0);
+    } inline:performsInline dispatchQueue:dispatchQueue operationQueue:operationQueue];
+    SR_TRACE_END(DelegateDispatch, 0);
 }
 
 - (void)performDelegateQueueBlock:(dispatch_block_t)block
 {
-    dispatch_queue_t dispatchQueue = self.dispatchQueue;
-    if (dispatchQueue) {
+    __block BOOL performsInline = NO;
+    __block dispatch_queue_t dispatchQueue = nil;
+    __block NSOperationQueue *operationQueue = nil;
+    dispatch_sync(self.accessQueue, ^{
+        performsInline = self->_performsInline;
+        dispatchQueue = self->_dispatchQueue;
+        operationQueue = self->_operationQueue;
+    });
+    [self _performBlock:block inline:performsInline dispatchQueue:dispatchQueue operationQueue:operationQueue];
+}
+
+- (void)_performBlock:(dispatch_block_t)block
+               inline:(BOOL)performsInline
+        dispatchQueue:(nullable dispatch_queue_t)dispatchQueue
+       operationQueue:(nullable NSOperationQueue *)operationQueue
+{
+    if (performsInline) {
+        block();
+    } else if (dispatchQueue) {
         dispatch_async(dispatchQueue, block);
     } else {
-        [self.operationQueue addOperationWithBlock:block];
+        [operationQueue addOperationWithBlock:block];
+    }
+}
+
+- (void)performDelegateBlock:(SRDelegateBlock)block orderingKey:(nullable id)key
+{
+    SR_TRACE_BEGIN(DelegateDispatch);
+    __block __strong id<SRWebSocketDelegate> delegate = nil;
+    __block SRDelegateAvailableMethods availableMethods = {};
+    __block SRKeyedDispatchQueue *keyedQueue = nil;
+    __block BOOL performsKeyed = NO;
+    __block BOOL performsInline = NO;
+    __block dispatch_queue_t dispatchQueue = nil;
+    __block NSOperationQueue *operationQueue = nil;
+    dispatch_sync(self.accessQueue, ^{
+        delegate = self->_delegate;
+        availableMethods = self.availableDelegateMethods;
+        performsInline = self->_performsInline;
+        dispatchQueue = self->_dispatchQueue;
+        operationQueue = self->_operationQueue;
+        // Keyed delivery needs a dispatch queue to target, everything else goes through the regular path.
+        performsKeyed = (!self->_performsInline && self->_dispatchQueue && self->_orderingLaneCount > 0);
+        if (self->_keyedQueue.targetQueue == self->_dispatchQueue && self->_keyedQueue.width == self->_orderingLaneCount) {
+            keyedQueue = self->_keyedQueue;
+        }
+    });
+    if (performsKeyed && !keyedQueue) {
+        keyedQueue = [self _updateKeyedQueue];
+    }
+
+    dispatch_block_t delegateBlock = ^{
+        SR_TRACE_BEGIN(DelegateRun);
+        block(delegate, availableMethods);
+        SR_TRACE_END(DelegateRun, 0);
+    };
+    if (keyedQueue) {
+        [keyedQueue dispatchAsyncWithKey:key block:delegateBlock];
+    } else {
+        [self _performBlock:delegateBlock inline:performsInline dispatchQueue:dispatchQueue operationQueue:operationQueue];
     }
+    SR_TRACE_END(DelegateDispatch, 0);
+}
+
+- (nullable SRKeyedDispatchQueue *)_updateKeyedQueue
+{
+    __block SRKeyedDispatchQueue *keyedQueue = nil;
+    dispatch_barrier_sync(self.accessQueue, ^{
+        if (self->_performsInline || !self->_dispatchQueue || self->_orderingLaneCount == 0) {
+            return;
+        }
+        if (self->_keyedQueue.targetQueue != self->_dispatchQueue || self->_keyedQueue.width != self->_orderingLaneCount) {
+            self->_keyedQueue = [[SRKeyedDispatchQueue alloc] initWithTargetQueue:self->_dispatchQueue
+                                                                            width:self->_orderingLaneCount];
+        }
+        keyedQueue = self->_keyedQueue;
+    });
+    return keyedQueue;
 }
 
 @end
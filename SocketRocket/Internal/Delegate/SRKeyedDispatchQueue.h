@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Runs blocks on a target queue, keeping blocks with equal keys in submission order.
+
+ Keys are hashed onto a fixed number of serial lanes that target the same queue,
+ so blocks with different keys run in parallel, as long as the target queue is concurrent.
+ Keys that share a lane are still ordered with each other, they only lose some parallelism.
+ */
+@interface SRKeyedDispatchQueue : NSObject
+
+@property (nonatomic, strong, readonly) dispatch_queue_t targetQueue;
+@property (nonatomic, assign, readonly) NSUInteger width;
+
+- (instancetype)initWithTargetQueue:(dispatch_queue_t)targetQueue width:(NSUInteger)width NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Submits a block for asynchronous execution. Blocks with a `nil` key are not ordered with anything.
+ */
+- (void)dispatchAsyncWithKey:(nullable id)key block:(dispatch_block_t)block;
+
+@end
+
+NS_ASSUME_NONNULL_END
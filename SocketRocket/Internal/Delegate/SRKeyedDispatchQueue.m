@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRKeyedDispatchQueue.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRKeyedDispatchQueue
+{
+    NSArray<dispatch_queue_t> *_lanes;
+}
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)initWithTargetQueue:(dispatch_queue_t)targetQueue width:(NSUInteger)width
+{
+    self = [super init];
+    if (!self) return self;
+
+    _targetQueue = targetQueue;
+    _width = MAX(width, 1);
+
+    NSMutableArray<dispatch_queue_t> *lanes = [NSMutableArray arrayWithCapacity:_width];
+    for (NSUInteger i = 0; i < _width; i++) {
+        dispatch_queue_t lane = dispatch_queue_create("com.facebook.socketrocket.delegate.lane", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(lane, targetQueue);
+        [lanes addObject:lane];
+    }
+    _lanes = [lanes copy];
+
+    return self;
+}
+
+///--------------------------------------
+#pragma mark - Dispatch
+///--------------------------------------
+
+- (void)dispatchAsyncWithKey:(nullable id)key block:(dispatch_block_t)block
+{
+    if (!key) {
+        dispatch_async(_targetQueue, block);
+        return;
+    }
+
+    // `hash` of small numbers and similar strings is often sequential or clustered, so spread it before picking a lane.
+    uint64_t hash = (uint64_t)[key hash] * 0x9E3779B97F4A7C15ULL;
+    dispatch_async(_lanes[(NSUInteger)((hash >> 32) % _width)], block);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -13,9 +13,14 @@
 
 #import "SRIOConsumer.h" // TODO: (nlutsenko) Convert to @class and constants file for block types
 
+@class SRMetricsRecorder;
+
 // This class is not thread-safe, and is expected to always be run on the same queue.
 @interface SRIOConsumerPool : NSObject
 
+// Consumers the pool has to create are counted in its allocation audit counters, if set.
+@property (nonatomic, strong) SRMetricsRecorder *metricsRecorder;
+
 - (instancetype)initWithBufferCapacity:(NSUInteger)poolSize;
 
 - (SRIOConsumer *)consumerWithScanner:(stream_scanner)scanner
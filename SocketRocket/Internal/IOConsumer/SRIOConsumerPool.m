@@ -11,6 +11,8 @@
 
 #import "SRIOConsumerPool.h"
 
+#import "SRAllocationAudit.h"
+
 @implementation SRIOConsumerPool {
     NSUInteger _poolSize;
     NSMutableArray<SRIOConsumer *> *_bufferedConsumers;
@@ -43,6 +45,9 @@
         [_bufferedConsumers removeLastObject];
     } else {
         consumer = [[SRIOConsumer alloc] init];
+        if (_metricsRecorder) {
+            SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, Consumer, consumer, 0);
+        }
     }
 
     [consumer resetWithScanner:scanner
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void(^SRDecodeCompletionHandler)(id _Nullable decodedMessage);
+
+// Decodes received messages in parallel on a background concurrent queue, while reporting them in the order they were received.
+// This class is thread-safe.
+@interface SRDecodePipeline : NSObject
+
+- (instancetype)initWithDecoder:(SRMessageDecoderBlock)decoder;
+
+// Completions are called one at a time on a private serial queue, in the order messages were submitted.
+- (void)decodeMessage:(id)message completion:(SRDecodeCompletionHandler)completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRDecodePipeline.h"
+
+#import "SRMutex.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SRDecodeSlot : NSObject
+{
+@public
+    id _Nullable _decodedMessage;
+    BOOL _decoded;
+    SRDecodeCompletionHandler _completion;
+}
+@end
+
+@implementation SRDecodeSlot
+@end
+
+@implementation SRDecodePipeline
+{
+    SRMessageDecoderBlock _decoder;
+    dispatch_queue_t _decodeQueue;
+    dispatch_queue_t _completionQueue;
+
+    SRMutex _mutex;
+    // Messages in the order they were submitted, until they are decoded and every message before them was completed.
+    NSMutableArray<SRDecodeSlot *> *_slots;
+}
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)initWithDecoder:(SRMessageDecoderBlock)decoder
+{
+    self = [super init];
+    if (!self) return self;
+
+    _decoder = [decoder copy];
+    _decodeQueue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    _completionQueue = dispatch_queue_create("com.facebook.socketrocket.decode.completion", DISPATCH_QUEUE_SERIAL);
+
+    _mutex = SRMutexInitRecursive();
+    _slots = [[NSMutableArray alloc] init];
+
+    return self;
+}
+
+- (void)dealloc
+{
+    SRMutexDestroy(_mutex);
+}
+
+///--------------------------------------
+#pragma mark - Decode
+///--------------------------------------
+
+- (void)decodeMessage:(id)message completion:(SRDecodeCompletionHandler)completion
+{
+    SRDecodeSlot *slot = [[SRDecodeSlot alloc] init];
+    slot->_completion = [completion copy];
+
+    SRMutexLock(_mutex);
+    [_slots addObject:slot];
+    SRMutexUnlock(_mutex);
+
+    SRMessageDecoderBlock decoder = _decoder;
+    dispatch_async(_decodeQueue, ^{
+        id decodedMessage = nil;
+        @autoreleasepool {
+            decodedMessage = decoder(message);
+        }
+
+        SRMutexLock(self->_mutex);
+        slot->_decodedMessage = decodedMessage;
+        slot->_decoded = YES;
+        [self _completeDecodedSlots];
+        SRMutexUnlock(self->_mutex);
+    });
+}
+
+- (void)_completeDecodedSlots
+{
+    // Completions are enqueued while holding the lock, which keeps them in order on the serial completion queue.
+    while (_slots.count > 0 && _slots[0]->_decoded) {
+        SRDecodeSlot *slot = _slots[0];
+        [_slots removeObjectAtIndex:0];
+
+        SRDecodeCompletionHandler completion = slot->_completion;
+        id decodedMessage = slot->_decodedMessage;
+        dispatch_async(_completionQueue, ^{
+            completion(decodedMessage);
+        });
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,31 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Outstanding request of the app for received messages.
+// This class is not thread-safe, and after creation is expected to always be used on the socket work queue.
+@interface SRPendingReceive : NSObject
+
+@property (nonatomic, assign, readonly) NSUInteger maximumCount;
+
+- (instancetype)initWithMaximumCount:(NSUInteger)maximumCount
+                               queue:(nullable dispatch_queue_t)queue
+                          completion:(SRReceiveCompletionHandler)completion;
+
+// Calls completion handler on the completion queue. Only the first call has any effect.
+- (void)completeWithMessages:(NSArray *)messages error:(nullable NSError *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
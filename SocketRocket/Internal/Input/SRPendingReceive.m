@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRPendingReceive.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRPendingReceive {
+    dispatch_queue_t _queue;
+    SRReceiveCompletionHandler _completion;
+}
+
+- (instancetype)initWithMaximumCount:(NSUInteger)maximumCount
+                               queue:(nullable dispatch_queue_t)queue
+                          completion:(SRReceiveCompletionHandler)completion
+{
+    self = [super init];
+    if (!self) return self;
+
+    _maximumCount = MAX(maximumCount, (NSUInteger)1);
+    _queue = queue ?: dispatch_get_main_queue();
+    _completion = [completion copy];
+
+    return self;
+}
+
+- (void)completeWithMessages:(NSArray *)messages error:(nullable NSError *)error
+{
+    SRReceiveCompletionHandler completion = _completion;
+    if (!completion) {
+        return;
+    }
+    _completion = nil;
+
+    dispatch_async(_queue, ^{
+        completion(messages, error);
+    });
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
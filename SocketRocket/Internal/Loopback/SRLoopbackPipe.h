@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// One direction of a loopback transport. Written bytes are split into chunks, each of which becomes readable
+// once the link had time to transmit it at `bandwidth` and `latency` passed.
+// This class is thread-safe. Handlers are called without the lock held, on the thread that caused the change or on a private queue.
+@interface SRLoopbackPipe : NSObject
+
+// `bandwidth` in bytes per second and `chunkLength` of `0` mean unlimited.
+// `capacity` limits the bytes written but not read yet, writes beyond it are refused until the reader catches up.
+- (instancetype)initWithBandwidth:(double)bandwidth
+                          latency:(NSTimeInterval)latency
+                      chunkLength:(NSUInteger)chunkLength
+                         capacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+// Called when a chunk becomes readable, or the writing end was closed.
+@property (nullable, atomic, copy) dispatch_block_t readableHandler;
+// Called when a write was refused before, and the reader made room since.
+@property (nullable, atomic, copy) dispatch_block_t writableHandler;
+
+@property (nonatomic, assign, readonly) BOOL hasBytesAvailable;
+@property (nonatomic, assign, readonly) BOOL hasSpaceAvailable;
+// Writing end was closed and everything was read.
+@property (nonatomic, assign, readonly, getter=isAtEnd) BOOL atEnd;
+// Reading end was closed, so nothing more can be written.
+@property (nonatomic, assign, readonly, getter=isReadingClosed) BOOL readingClosed;
+
+// Returns the number of bytes taken, `0` if the pipe is full, or `-1` if the reading end was closed.
+- (NSInteger)write:(const uint8_t *)bytes maxLength:(NSUInteger)length;
+// Returns at most the rest of the first readable chunk, or `0` if nothing is readable.
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length;
+
+- (void)closeWriting;
+- (void)closeReading;
+
+@end
+
+NS_ASSUME_NONNULL_END
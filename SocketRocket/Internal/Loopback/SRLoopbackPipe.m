@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRLoopbackPipe.h"
+
+#import "SRMutex.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SRLoopbackChunk : NSObject
+{
+@public
+    NSData *_data;
+    NSUInteger _offset;
+    uint64_t _readyTime;
+}
+@end
+
+@implementation SRLoopbackChunk
+@end
+
+@implementation SRLoopbackPipe {
+    double _bandwidth;
+    uint64_t _latency;
+    NSUInteger _chunkLength;
+    NSUInteger _capacity;
+
+    SRMutex _lock;
+    NSMutableArray<SRLoopbackChunk *> *_chunks;
+    NSUInteger _bufferedLength;
+    // Time the link is done transmitting everything written so far.
+    uint64_t _linkFreeTime;
+    BOOL _writeRefused;
+    BOOL _writingClosed;
+    BOOL _readingClosed;
+}
+
+- (instancetype)initWithBandwidth:(double)bandwidth
+                          latency:(NSTimeInterval)latency
+                      chunkLength:(NSUInteger)chunkLength
+                         capacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (!self) return self;
+
+    _bandwidth = bandwidth;
+    _latency = (uint64_t)(MAX(latency, 0) * NSEC_PER_SEC);
+    _chunkLength = chunkLength;
+    _capacity = MAX(capacity, 1);
+
+    _lock = SRMutexInitRecursive();
+    _chunks = [[NSMutableArray alloc] init];
+
+    return self;
+}
+
+- (void)dealloc
+{
+    SRMutexDestroy(_lock);
+}
+
+- (void)_notifyReadableAtTime:(uint64_t)readyTime
+{
+    uint64_t now = SRMonotonicTimeNanoseconds();
+    if (readyTime <= now) {
+        dispatch_block_t handler = self.readableHandler;
+        if (handler) {
+            handler();
+        }
+        return;
+    }
+    __weak typeof(self) wself = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(readyTime - now)), dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        dispatch_block_t handler = wself.readableHandler;
+        if (handler) {
+            handler();
+        }
+    });
+}
+
+- (NSInteger)write:(const uint8_t *)bytes maxLength:(NSUInteger)length
+{
+    NSMutableArray<NSNumber *> *readyTimes = [NSMutableArray array];
+
+    SRMutexLock(_lock);
+    if (_readingClosed || _writingClosed) {
+        SRMutexUnlock(_lock);
+        return -1;
+    }
+    NSUInteger acceptedLength = MIN(length, _capacity - MIN(_bufferedLength, _capacity));
+    _writeRefused = (acceptedLength < length);
+
+    uint64_t now = SRMonotonicTimeNanoseconds();
+    NSUInteger chunkLength = (_chunkLength > 0 ? _chunkLength : MAX(acceptedLength, (NSUInteger)1));
+    for (NSUInteger offset = 0; offset < acceptedLength; offset += chunkLength) {
+        SRLoopbackChunk *chunk = [[SRLoopbackChunk alloc] init];
+        chunk->_data = [NSData dataWithBytes:bytes + offset length:MIN(chunkLength, acceptedLength - offset)];
+
+        uint64_t transmitTime = (_bandwidth > 0 ? (uint64_t)(chunk->_data.length / _bandwidth * NSEC_PER_SEC) : 0);
+        _linkFreeTime = MAX(_linkFreeTime, now) + transmitTime;
+        chunk->_readyTime = _linkFreeTime + _latency;
+
+        [_chunks addObject:chunk];
+        [readyTimes addObject:@(chunk->_readyTime)];
+    }
+    _bufferedLength += acceptedLength;
+    SRMutexUnlock(_lock);
+
+    for (NSNumber *readyTime in readyTimes) {
+        [self _notifyReadableAtTime:readyTime.unsignedLongLongValue];
+    }
+    return (NSInteger)acceptedLength;
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length
+{
+    BOOL notifyWritable = NO;
+
+    SRMutexLock(_lock);
+    SRLoopbackChunk *chunk = _chunks.firstObject;
+    if (!chunk || chunk->_readyTime > SRMonotonicTimeNanoseconds()) {
+        SRMutexUnlock(_lock);
+        return 0;
+    }
+    NSUInteger readLength = MIN(length, chunk->_data.length - chunk->_offset);
+    memcpy(buffer, (const uint8_t *)chunk->_data.bytes + chunk->_offset, readLength);
+    chunk->_offset += readLength;
+    if (chunk->_offset == chunk->_data.length) {
+        [_chunks removeObjectAtIndex:0];
+    }
+    _bufferedLength -= readLength;
+    if (_writeRefused && readLength > 0) {
+        _writeRefused = NO;
+        notifyWritable = YES;
+    }
+    SRMutexUnlock(_lock);
+
+    if (notifyWritable) {
+        dispatch_block_t handler = self.writableHandler;
+        if (handler) {
+            handler();
+        }
+    }
+    return (NSInteger)readLength;
+}
+
+- (BOOL)hasBytesAvailable
+{
+    SRMutexLock(_lock);
+    SRLoopbackChunk *chunk = _chunks.firstObject;
+    BOOL hasBytesAvailable = (chunk && chunk->_readyTime <= SRMonotonicTimeNanoseconds());
+    SRMutexUnlock(_lock);
+    return hasBytesAvailable;
+}
+
+- (BOOL)hasSpaceAvailable
+{
+    SRMutexLock(_lock);
+    BOOL hasSpaceAvailable = (!_readingClosed && !_writingClosed && _bufferedLength < _capacity);
+    SRMutexUnlock(_lock);
+    return hasSpaceAvailable;
+}
+
+- (BOOL)isAtEnd
+{
+    SRMutexLock(_lock);
+    BOOL atEnd = (_writingClosed && _chunks.count == 0);
+    SRMutexUnlock(_lock);
+    return atEnd;
+}
+
+- (BOOL)isReadingClosed
+{
+    SRMutexLock(_lock);
+    BOOL readingClosed = _readingClosed;
+    SRMutexUnlock(_lock);
+    return readingClosed;
+}
+
+- (void)closeWriting
+{
+    SRMutexLock(_lock);
+    if (_writingClosed) {
+        SRMutexUnlock(_lock);
+        return;
+    }
+    _writingClosed = YES;
+    // The end arrives after everything that was written before it.
+    uint64_t readyTime = MAX(_linkFreeTime, SRMonotonicTimeNanoseconds()) + _latency;
+    SRMutexUnlock(_lock);
+
+    [self _notifyReadableAtTime:readyTime];
+}
+
+- (void)closeReading
+{
+    SRMutexLock(_lock);
+    _readingClosed = YES;
+    [_chunks removeAllObjects];
+    _bufferedLength = 0;
+    SRMutexUnlock(_lock);
+
+    dispatch_block_t handler = self.writableHandler;
+    if (handler) {
+        handler();
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+@class SRLoopbackPipe;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Streams over a loopback pipe, for code that expects a socket stream pair.
+// Events go to the delegate on the run loops the stream is scheduled in, like they do for CFNetwork streams.
+// `NSStreamEventOpenCompleted` is never sent, streams are handed over opened.
+
+@interface SRLoopbackInputStream : NSInputStream
+
+- (instancetype)initWithPipe:(SRLoopbackPipe *)pipe NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithData:(NSData *)data NS_UNAVAILABLE;
+- (instancetype)initWithURL:(NSURL *)url NS_UNAVAILABLE;
+
+@end
+
+@interface SRLoopbackOutputStream : NSOutputStream
+
+- (instancetype)initWithPipe:(SRLoopbackPipe *)pipe NS_DESIGNATED_INITIALIZER;
+- (instancetype)initToMemory NS_UNAVAILABLE;
+- (instancetype)initToBuffer:(uint8_t *)buffer capacity:(NSUInteger)capacity NS_UNAVAILABLE;
+- (instancetype)initWithURL:(NSURL *)url append:(BOOL)shouldAppend NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
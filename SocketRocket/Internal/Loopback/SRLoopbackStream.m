@@ -0,0 +1,353 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRLoopbackStream.h"
+
+#import "SRLoopbackPipe.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Sends `event` to the delegate of `stream` on the first run loop it is scheduled in, a stream reports each event once.
+static void SRLoopbackStreamPostEvent(NSStream *stream, NSArray<NSArray *> *runLoops, NSStreamEvent event)
+{
+    NSArray *runLoop = runLoops.firstObject;
+    if (!runLoop) {
+        return;
+    }
+    CFRunLoopRef cfRunLoop = [(NSRunLoop *)runLoop[0] getCFRunLoop];
+    CFRunLoopPerformBlock(cfRunLoop, (__bridge CFStringRef)runLoop[1], ^{
+        if (stream.streamStatus == NSStreamStatusClosed) {
+            return;
+        }
+        id<NSStreamDelegate> delegate = stream.delegate;
+        if ([delegate respondsToSelector:@selector(stream:handleEvent:)]) {
+            [delegate stream:stream handleEvent:event];
+        }
+    });
+    CFRunLoopWakeUp(cfRunLoop);
+}
+
+static NSError *SRLoopbackBrokenPipeError(void)
+{
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:EPIPE userInfo:nil];
+}
+
+///--------------------------------------
+#pragma mark - SRLoopbackInputStream
+///--------------------------------------
+
+@implementation SRLoopbackInputStream {
+    SRLoopbackPipe *_pipe;
+    __weak id<NSStreamDelegate> _delegate;
+    NSMutableDictionary<NSStreamPropertyKey, id> *_properties;
+
+    // Guarded by `self`.
+    NSStreamStatus _status;
+    NSMutableArray<NSArray *> *_runLoops; // [RunLoop, Mode]
+    BOOL _sentEnd;
+}
+
+- (instancetype)initWithPipe:(SRLoopbackPipe *)pipe
+{
+    self = [super init];
+    if (!self) return self;
+
+    _pipe = pipe;
+    _properties = [NSMutableDictionary dictionary];
+    _status = NSStreamStatusNotOpen;
+    _runLoops = [NSMutableArray array];
+
+    __weak typeof(self) wself = self;
+    _pipe.readableHandler = ^{
+        [wself _postAvailableEvent];
+    };
+
+    return self;
+}
+
+- (void)dealloc
+{
+    _pipe.readableHandler = nil;
+}
+
+- (void)_postAvailableEvent
+{
+    @synchronized(self) {
+        if (_status != NSStreamStatusOpen && _status != NSStreamStatusAtEnd) {
+            return;
+        }
+        if (_pipe.hasBytesAvailable) {
+            SRLoopbackStreamPostEvent(self, _runLoops, NSStreamEventHasBytesAvailable);
+        } else if (_pipe.atEnd && !_sentEnd) {
+            _sentEnd = YES;
+            _status = NSStreamStatusAtEnd;
+            SRLoopbackStreamPostEvent(self, _runLoops, NSStreamEventEndEncountered);
+        }
+    }
+}
+
+- (void)open
+{
+    @synchronized(self) {
+        if (_status != NSStreamStatusNotOpen) {
+            return;
+        }
+        _status = NSStreamStatusOpen;
+    }
+    [self _postAvailableEvent];
+}
+
+- (void)close
+{
+    @synchronized(self) {
+        if (_status == NSStreamStatusClosed) {
+            return;
+        }
+        _status = NSStreamStatusClosed;
+    }
+    _pipe.readableHandler = nil;
+    [_pipe closeReading];
+}
+
+- (nullable id<NSStreamDelegate>)delegate
+{
+    return _delegate ?: self;
+}
+
+- (void)setDelegate:(nullable id<NSStreamDelegate>)delegate
+{
+    _delegate = delegate;
+}
+
+- (NSStreamStatus)streamStatus
+{
+    @synchronized(self) {
+        return _status;
+    }
+}
+
+- (nullable NSError *)streamError
+{
+    return nil;
+}
+
+- (nullable id)propertyForKey:(NSStreamPropertyKey)key
+{
+    @synchronized(self) {
+        return _properties[key];
+    }
+}
+
+- (BOOL)setProperty:(nullable id)property forKey:(NSStreamPropertyKey)key
+{
+    @synchronized(self) {
+        _properties[key] = property;
+    }
+    return YES;
+}
+
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode
+{
+    @synchronized(self) {
+        [_runLoops addObject:@[ aRunLoop, mode ]];
+    }
+    // Whatever arrived before scheduling would be missed otherwise.
+    [self _postAvailableEvent];
+}
+
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode
+{
+    @synchronized(self) {
+        [_runLoops removeObject:@[ aRunLoop, mode ]];
+    }
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length
+{
+    NSStreamStatus status = self.streamStatus;
+    if (status == NSStreamStatusAtEnd) {
+        return 0;
+    }
+    if (status != NSStreamStatusOpen) {
+        return -1;
+    }
+    NSInteger bytesRead = [_pipe read:buffer maxLength:length];
+    // Readers stop once there are no bytes available, so the end has to be reported after the last read.
+    if (_pipe.atEnd) {
+        [self _postAvailableEvent];
+    }
+    return bytesRead;
+}
+
+- (BOOL)getBuffer:(uint8_t *_Nullable *_Nonnull)buffer length:(NSUInteger *)length
+{
+    return NO;
+}
+
+- (BOOL)hasBytesAvailable
+{
+    return (self.streamStatus == NSStreamStatusOpen && _pipe.hasBytesAvailable);
+}
+
+@end
+
+///--------------------------------------
+#pragma mark - SRLoopbackOutputStream
+///--------------------------------------
+
+@implementation SRLoopbackOutputStream {
+    SRLoopbackPipe *_pipe;
+    __weak id<NSStreamDelegate> _delegate;
+    NSMutableDictionary<NSStreamPropertyKey, id> *_properties;
+
+    // Guarded by `self`.
+    NSStreamStatus _status;
+    NSError *_error;
+    NSMutableArray<NSArray *> *_runLoops; // [RunLoop, Mode]
+}
+
+- (instancetype)initWithPipe:(SRLoopbackPipe *)pipe
+{
+    self = [super init];
+    if (!self) return self;
+
+    _pipe = pipe;
+    _properties = [NSMutableDictionary dictionary];
+    _status = NSStreamStatusNotOpen;
+    _runLoops = [NSMutableArray array];
+
+    __weak typeof(self) wself = self;
+    _pipe.writableHandler = ^{
+        [wself _postSpaceEvent];
+    };
+
+    return self;
+}
+
+- (void)dealloc
+{
+    _pipe.writableHandler = nil;
+}
+
+- (void)_postSpaceEvent
+{
+    @synchronized(self) {
+        if (_status != NSStreamStatusOpen) {
+            return;
+        }
+        if (_pipe.readingClosed) {
+            _status = NSStreamStatusError;
+            _error = SRLoopbackBrokenPipeError();
+            SRLoopbackStreamPostEvent(self, _runLoops, NSStreamEventErrorOccurred);
+        } else if (_pipe.hasSpaceAvailable) {
+            SRLoopbackStreamPostEvent(self, _runLoops, NSStreamEventHasSpaceAvailable);
+        }
+    }
+}
+
+- (void)open
+{
+    @synchronized(self) {
+        if (_status != NSStreamStatusNotOpen) {
+            return;
+        }
+        _status = NSStreamStatusOpen;
+    }
+    [self _postSpaceEvent];
+}
+
+- (void)close
+{
+    @synchronized(self) {
+        if (_status == NSStreamStatusClosed) {
+            return;
+        }
+        _status = NSStreamStatusClosed;
+    }
+    _pipe.writableHandler = nil;
+    [_pipe closeWriting];
+}
+
+- (nullable id<NSStreamDelegate>)delegate
+{
+    return _delegate ?: self;
+}
+
+- (void)setDelegate:(nullable id<NSStreamDelegate>)delegate
+{
+    _delegate = delegate;
+}
+
+- (NSStreamStatus)streamStatus
+{
+    @synchronized(self) {
+        return _status;
+    }
+}
+
+- (nullable NSError *)streamError
+{
+    @synchronized(self) {
+        return _error;
+    }
+}
+
+- (nullable id)propertyForKey:(NSStreamPropertyKey)key
+{
+    @synchronized(self) {
+        return _properties[key];
+    }
+}
+
+- (BOOL)setProperty:(nullable id)property forKey:(NSStreamPropertyKey)key
+{
+    @synchronized(self) {
+        _properties[key] = property;
+    }
+    return YES;
+}
+
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode
+{
+    @synchronized(self) {
+        [_runLoops addObject:@[ aRunLoop, mode ]];
+    }
+    [self _postSpaceEvent];
+}
+
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode
+{
+    @synchronized(self) {
+        [_runLoops removeObject:@[ aRunLoop, mode ]];
+    }
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length
+{
+    if (self.streamStatus != NSStreamStatusOpen) {
+        return -1;
+    }
+    NSInteger bytesWritten = [_pipe write:buffer maxLength:length];
+    if (bytesWritten == -1) {
+        @synchronized(self) {
+            _status = NSStreamStatusError;
+            _error = SRLoopbackBrokenPipeError();
+        }
+    }
+    return bytesWritten;
+}
+
+- (BOOL)hasSpaceAvailable
+{
+    return (self.streamStatus == NSStreamStatusOpen && _pipe.hasSpaceAvailable);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+#import <malloc/malloc.h>
+
+#import "SRMetricsRecorder.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Uncomment this line, or pass `-DSR_ALLOCATION_AUDIT_ENABLED`, to count heap allocations of the receive pipeline per stage.
+// When disabled, audit points compile to nothing and don't evaluate their arguments.
+//#define SR_ALLOCATION_AUDIT_ENABLED
+
+// Counts `pointer` as an allocation of `stage`, with the size the allocator reserved for it plus `copiedLength` bytes
+// it references in a separate buffer. Tagged pointers and static objects, like `dispatch_data_empty`, have no size and aren't counted.
+static inline void SRMetricsAuditAllocation(SRMetricsCounters *counters, SRAllocationStage stage, const void *_Nullable pointer, size_t copiedLength)
+{
+    size_t size = (pointer ? malloc_size(pointer) : 0);
+    if (size == 0) {
+        return;
+    }
+    SRMetricsAdd(&counters->allocations[stage], 1);
+    SRMetricsAdd(&counters->allocatedBytes[stage], size + copiedLength);
+}
+
+#ifdef SR_ALLOCATION_AUDIT_ENABLED
+
+#define SR_AUDIT_ALLOCATION(counters, stage, object, copiedLength) \
+    SRMetricsAuditAllocation((counters), SRAllocationStage##stage, (__bridge const void *)(object), (copiedLength))
+
+#else
+
+#define SR_AUDIT_ALLOCATION(counters, stage, object, copiedLength)
+
+#endif
+
+NS_ASSUME_NONNULL_END
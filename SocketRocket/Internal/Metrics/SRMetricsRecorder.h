@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+#import <stdatomic.h>
+
+#import "SRWebSocketMetrics+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Counters of a single socket. Most of them are written on the socket work queue, but delivered messages are counted
+// wherever the delegate handles them and handshake marks may come from any thread. Any thread may read them.
+typedef struct {
+    atomic_uint_fast64_t bytesReceived;
+    atomic_uint_fast64_t bytesSent;
+    atomic_uint_fast64_t framesReceived[16];
+    atomic_uint_fast64_t framesSent[16];
+    atomic_uint_fast64_t messagesDelivered;
+    atomic_uint_fast64_t fragmentsReassembled;
+    atomic_uint_fast64_t peakReadBufferLength;
+    atomic_uint_fast64_t peakOutputBufferLength;
+    atomic_uint_fast64_t peakFrameDataLength;
+    atomic_uint_fast64_t readCount;
+    atomic_uint_fast64_t writeCount;
+    atomic_uint_fast64_t handshake[SRHandshakeMarkCount];
+    atomic_uint_fast64_t allocations[SRAllocationStageCount];
+    atomic_uint_fast64_t allocatedBytes[SRAllocationStageCount];
+} SRMetricsCounters;
+
+static inline void SRMetricsAdd(atomic_uint_fast64_t *counter, uint64_t value)
+{
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+// Raises a peak to `value`. Doesn't assume a single writer, a failed exchange reloads the peak and retries while `value` is still higher.
+static inline void SRMetricsPeak(atomic_uint_fast64_t *counter, uint64_t value)
+{
+    uint_fast64_t peak = atomic_load_explicit(counter, memory_order_relaxed);
+    while (value > peak && !atomic_compare_exchange_weak_explicit(counter, &peak, value, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Records the current time for a phase of opening the socket. Phases may be recorded from any thread.
+extern void SRMetricsMarkHandshake(SRMetricsCounters *counters, SRHandshakeMark mark);
+
+// Owns the counters of a socket and keeps track of all of them for the process-wide aggregate.
+// Counters of deallocated recorders are folded into the aggregate, so it covers every socket the process ever had.
+@interface SRMetricsRecorder : NSObject
+{
+@public
+    SRMetricsCounters _counters;
+}
+
++ (SRWebSocketMetrics *)aggregateMetrics;
+
+- (SRWebSocketMetrics *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
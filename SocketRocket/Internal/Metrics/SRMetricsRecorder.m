@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRMetricsRecorder.h"
+
+#import "SRMutex.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static SRMutex SRMetricsRegistryMutex;
+static NSHashTable<SRMetricsRecorder *> *SRMetricsLiveRecorders;
+static SRMetricsValues SRMetricsRetiredValues;
+
+static void SRMetricsRegistryInit(void)
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        SRMetricsRegistryMutex = SRMutexInitRecursive();
+        SRMetricsLiveRecorders = [NSHashTable weakObjectsHashTable];
+    });
+}
+
+// Sums counters into `values`, keeping the maximum for peaks.
+static void SRMetricsAccumulate(SRMetricsValues *values, SRMetricsCounters *counters)
+{
+    values->bytesReceived += atomic_load_explicit(&counters->bytesReceived, memory_order_relaxed);
+    values->bytesSent += atomic_load_explicit(&counters->bytesSent, memory_order_relaxed);
+    for (size_t i = 0; i < 16; i++) {
+        values->framesReceived[i] += atomic_load_explicit(&counters->framesReceived[i], memory_order_relaxed);
+        values->framesSent[i] += atomic_load_explicit(&counters->framesSent[i], memory_order_relaxed);
+    }
+    values->messagesDelivered += atomic_load_explicit(&counters->messagesDelivered, memory_order_relaxed);
+    values->fragmentsReassembled += atomic_load_explicit(&counters->fragmentsReassembled, memory_order_relaxed);
+    values->peakReadBufferLength = MAX(values->peakReadBufferLength, atomic_load_explicit(&counters->peakReadBufferLength, memory_order_relaxed));
+    values->peakOutputBufferLength = MAX(values->peakOutputBufferLength, atomic_load_explicit(&counters->peakOutputBufferLength, memory_order_relaxed));
+    values->peakFrameDataLength = MAX(values->peakFrameDataLength, atomic_load_explicit(&counters->peakFrameDataLength, memory_order_relaxed));
+    values->readCount += atomic_load_explicit(&counters->readCount, memory_order_relaxed);
+    values->writeCount += atomic_load_explicit(&counters->writeCount, memory_order_relaxed);
+    for (size_t i = 0; i < SRAllocationStageCount; i++) {
+        values->allocations[i] += atomic_load_explicit(&counters->allocations[i], memory_order_relaxed);
+        values->allocatedBytes[i] += atomic_load_explicit(&counters->allocatedBytes[i], memory_order_relaxed);
+    }
+}
+
+void SRMetricsMarkHandshake(SRMetricsCounters *counters, SRHandshakeMark mark)
+{
+    atomic_store_explicit(&counters->handshake[mark], SRMonotonicTimeNanoseconds(), memory_order_relaxed);
+}
+
+@implementation SRMetricsRecorder
+
+///--------------------------------------
+#pragma mark - Init
+///--------------------------------------
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    SRMetricsRegistryInit();
+    SRMutexLock(SRMetricsRegistryMutex);
+    [SRMetricsLiveRecorders addObject:self];
+    SRMutexUnlock(SRMetricsRegistryMutex);
+
+    return self;
+}
+
+- (void)dealloc
+{
+    // Weak reference to `self` is already cleared, so the counters are briefly missing from the aggregate until here.
+    SRMutexLock(SRMetricsRegistryMutex);
+    SRMetricsAccumulate(&SRMetricsRetiredValues, &_counters);
+    SRMutexUnlock(SRMetricsRegistryMutex);
+}
+
+///--------------------------------------
+#pragma mark - Snapshot
+///--------------------------------------
+
+- (SRWebSocketMetrics *)metrics
+{
+    SRMetricsValues values = {0};
+    SRMetricsAccumulate(&values, &_counters);
+    // Timeline only makes sense per socket, so it isn't part of the accumulated values.
+    for (size_t i = 0; i < SRHandshakeMarkCount; i++) {
+        values.handshake[i] = atomic_load_explicit(&_counters.handshake[i], memory_order_relaxed);
+    }
+    return [[SRWebSocketMetrics alloc] initWithValues:&values];
+}
+
++ (SRWebSocketMetrics *)aggregateMetrics
+{
+    SRMetricsRegistryInit();
+
+    SRMutexLock(SRMetricsRegistryMutex);
+    SRMetricsValues values = SRMetricsRetiredValues;
+    for (SRMetricsRecorder *recorder in SRMetricsLiveRecorders) {
+        SRMetricsAccumulate(&values, &recorder->_counters);
+    }
+    SRMutexUnlock(SRMetricsRegistryMutex);
+
+    return [[SRWebSocketMetrics alloc] initWithValues:&values];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
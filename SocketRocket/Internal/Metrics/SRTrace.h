@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Uncomment this line to enable trace spans on the hot paths of the socket.
+// When disabled, trace points compile to nothing and don't evaluate their arguments.
+//#define SR_TRACE_ENABLED
+
+typedef NS_ENUM(uint16_t, SRTraceSpan) {
+    SRTraceSpanRead,
+    SRTraceSpanHeaderParse,
+    SRTraceSpanPayloadConsume,
+    SRTraceSpanUTF8Validation,
+    SRTraceSpanDelegateDispatch,
+    SRTraceSpanDelegateRun,
+    SRTraceSpanFrameBuild,
+    SRTraceSpanMask,
+    SRTraceSpanWrite,
+    SRTraceSpanCount
+};
+
+// Appends a finished span to the ring buffer of the current thread, overwriting the oldest span when it is full.
+// Never takes a lock, allocates only the first time it's called on a thread and no buffer of an exited thread is free.
+extern void SRTraceRecord(SRTraceSpan span, uint64_t startTime, uint64_t endTime, uint64_t byteCount);
+
+// Returns spans that are still in the ring buffers of all threads as Chrome trace-event JSON,
+// which can be loaded into `chrome://tracing` or Perfetto. Spans are not removed from the buffers.
+extern NSData *SRTraceCopyChromeTraceJSON(void);
+
+#ifdef SR_TRACE_ENABLED
+
+#define SR_TRACE_BEGIN(span) const uint64_t _SRTraceStart##span = SRMonotonicTimeNanoseconds()
+#define SR_TRACE_END(span, byteCount) SRTraceRecord(SRTraceSpan##span, _SRTraceStart##span, SRMonotonicTimeNanoseconds(), (byteCount))
+
+#else
+
+#define SR_TRACE_BEGIN(span)
+#define SR_TRACE_END(span, byteCount)
+
+#endif
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRTrace.h"
+
+#import <pthread.h>
+#import <stdatomic.h>
+#import <unistd.h>
+
+#import "SRThreadBuffer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Must be a power of two.
+static const uint64_t SRTraceBufferCapacity = 16 * 1024;
+
+static const char *const SRTraceSpanNames[SRTraceSpanCount] = {
+    [SRTraceSpanRead] = "read",
+    [SRTraceSpanHeaderParse] = "header parse",
+    [SRTraceSpanPayloadConsume] = "payload consume",
+    [SRTraceSpanUTF8Validation] = "UTF-8 validation",
+    [SRTraceSpanDelegateDispatch] = "delegate dispatch",
+    [SRTraceSpanDelegateRun] = "delegate run",
+    [SRTraceSpanFrameBuild] = "frame build",
+    [SRTraceSpanMask] = "mask",
+    [SRTraceSpanWrite] = "write",
+};
+
+typedef struct {
+    uint64_t startTime;
+    uint64_t endTime;
+    uint64_t byteCount;
+    SRTraceSpan span;
+} SRTraceEntry;
+
+// Single producer ring buffer, written only by the thread that owns it.
+typedef struct {
+    SRThreadBuffer base;
+    uint64_t threadID;
+    char threadName[64];
+    // First entry written by the current owner, earlier ones belong to a thread that exited.
+    atomic_uint_fast64_t ownerHead;
+    // Number of entries ever written, entry `i` lives at `i % SRTraceBufferCapacity`.
+    atomic_uint_fast64_t head;
+    SRTraceEntry entries[SRTraceBufferCapacity];
+} SRTraceBuffer;
+
+// Spans of an exited thread stay exported under its ID until another thread takes the buffer over.
+static void SRTraceBufferClaim(SRThreadBuffer *threadBuffer)
+{
+    SRTraceBuffer *buffer = (SRTraceBuffer *)threadBuffer;
+    pthread_threadid_np(NULL, &buffer->threadID);
+    pthread_getname_np(pthread_self(), buffer->threadName, sizeof(buffer->threadName));
+    atomic_store_explicit(&buffer->ownerHead, atomic_load_explicit(&buffer->head, memory_order_relaxed), memory_order_release);
+}
+
+static SRThreadBufferList SRTraceBuffers = SRThreadBufferListInitializer(SRTraceBuffer, SRTraceBufferClaim, NULL);
+
+void SRTraceRecord(SRTraceSpan span, uint64_t startTime, uint64_t endTime, uint64_t byteCount)
+{
+    SRTraceBuffer *buffer = (SRTraceBuffer *)SRThreadBufferListCurrentBuffer(&SRTraceBuffers);
+    if (!buffer) {
+        return;
+    }
+
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    buffer->entries[head & (SRTraceBufferCapacity - 1)] = (SRTraceEntry){startTime, endTime, byteCount, span};
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+static void SRTraceAppendJSONString(NSMutableData *json, const char *string)
+{
+    [json appendBytes:"\"" length:1];
+    for (const char *c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            [json appendBytes:"\\" length:1];
+        }
+        if ((unsigned char)*c >= 0x20) {
+            [json appendBytes:c length:1];
+        }
+    }
+    [json appendBytes:"\"" length:1];
+}
+
+static void SRTraceAppendFormat(NSMutableData *json, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void SRTraceAppendFormat(NSMutableData *json, const char *format, ...)
+{
+    char line[256];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+    [json appendBytes:line length:MIN((size_t)MAX(length, 0), sizeof(line) - 1)];
+}
+
+NSData *SRTraceCopyChromeTraceJSON(void)
+{
+    NSMutableData *json = [NSMutableData data];
+    const int pid = getpid();
+    BOOL first = YES;
+
+    SRTraceEntry *entries = malloc(sizeof(SRTraceEntry) * SRTraceBufferCapacity);
+
+    SRTraceAppendFormat(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (SRThreadBuffer *threadBuffer = SRThreadBufferListFirstBuffer(&SRTraceBuffers); threadBuffer; threadBuffer = threadBuffer->next) {
+        SRTraceBuffer *buffer = (SRTraceBuffer *)threadBuffer;
+        uint64_t ownerHead = atomic_load_explicit(&buffer->ownerHead, memory_order_acquire);
+        uint64_t threadID = buffer->threadID;
+        SRTraceAppendFormat(json, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%llu,\"args\":{\"name\":",
+                            (first ? "" : ","), pid, threadID);
+        SRTraceAppendJSONString(json, (buffer->threadName[0] ? buffer->threadName : "SocketRocket"));
+        SRTraceAppendFormat(json, "}}");
+        first = NO;
+
+        uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        uint64_t tail = MAX(ownerHead, (head > SRTraceBufferCapacity ? head - SRTraceBufferCapacity : 0));
+        for (uint64_t i = tail; i < head; i++) {
+            entries[i - tail] = buffer->entries[i & (SRTraceBufferCapacity - 1)];
+        }
+
+        // Owner thread keeps writing while we copy, entries it could have reached since are discarded.
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t currentHead = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+        uint64_t validTail = (currentHead >= SRTraceBufferCapacity ? currentHead - SRTraceBufferCapacity + 1 : 0);
+        if (atomic_load_explicit(&buffer->ownerHead, memory_order_relaxed) != ownerHead) {
+            // Another thread took the buffer over, the copied entries may be attributed to the wrong thread.
+            continue;
+        }
+
+        for (uint64_t i = MAX(tail, validTail); i < head; i++) {
+            SRTraceEntry entry = entries[i - tail];
+            SRTraceAppendFormat(json, ",{\"name\":\"%s\",\"cat\":\"SocketRocket\",\"ph\":\"X\",\"pid\":%d,\"tid\":%llu,"
+                                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu}}",
+                                SRTraceSpanNames[entry.span], pid, threadID,
+                                entry.startTime / 1000.0, (entry.endTime - entry.startTime) / 1000.0, entry.byteCount);
+        }
+    }
+    SRTraceAppendFormat(json, "]}");
+
+    free(entries);
+    return json;
+}
+
+NS_ASSUME_NONNULL_END
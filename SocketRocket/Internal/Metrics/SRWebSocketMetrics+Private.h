@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <SocketRocket/SRWebSocketMetrics.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Phases of opening a socket, in the order of `SRHandshakeTimeline` fields.
+typedef NS_ENUM(NSUInteger, SRHandshakeMark) {
+    SRHandshakeMarkOpen,
+    SRHandshakeMarkPACFetchStart,
+    SRHandshakeMarkPACFetchEnd,
+    SRHandshakeMarkPACEvaluationStart,
+    SRHandshakeMarkPACEvaluationEnd,
+    SRHandshakeMarkConnectStart,
+    SRHandshakeMarkConnectEnd,
+    SRHandshakeMarkProxyConnectStart,
+    SRHandshakeMarkProxyConnectEnd,
+    SRHandshakeMarkTLSStart,
+    SRHandshakeMarkTLSEnd,
+    SRHandshakeMarkTrustEvaluationEnd,
+    SRHandshakeMarkUpgradeRequest,
+    SRHandshakeMarkHeadersComplete,
+    SRHandshakeMarkCount
+};
+
+// Plain copy of `SRMetricsCounters`, indexes of frame counters are opcodes.
+typedef struct {
+    uint64_t bytesReceived;
+    uint64_t bytesSent;
+    uint64_t framesReceived[16];
+    uint64_t framesSent[16];
+    uint64_t messagesDelivered;
+    uint64_t fragmentsReassembled;
+    uint64_t peakReadBufferLength;
+    uint64_t peakOutputBufferLength;
+    uint64_t peakFrameDataLength;
+    uint64_t readCount;
+    uint64_t writeCount;
+    uint64_t handshake[SRHandshakeMarkCount];
+    uint64_t allocations[SRAllocationStageCount];
+    uint64_t allocatedBytes[SRAllocationStageCount];
+} SRMetricsValues;
+
+@interface SRWebSocketMetrics ()
+
+- (instancetype)initWithValues:(const SRMetricsValues *)values;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Ordered queue of unframed messages, where a newer message replaces the queued one with the same key.
+// Replaced message keeps the position of the original one, so a frequently updated key doesn't starve others.
+// This class is not thread-safe, and is expected to always be run on the same queue.
+@interface SRConflationQueue : NSObject
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+// Returns `YES` if an older message with the same key was replaced.
+- (BOOL)enqueueMessage:(id)message forKey:(NSString *)key;
+- (nullable id)dequeueMessage;
+
+- (void)removeAllMessages;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRConflationQueue.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRConflationQueue {
+    NSMutableArray<NSString *> *_keys;
+    NSMutableDictionary<NSString *, id> *_messages;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _keys = [[NSMutableArray alloc] init];
+    _messages = [[NSMutableDictionary alloc] init];
+
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return _keys.count;
+}
+
+- (BOOL)enqueueMessage:(id)message forKey:(NSString *)key
+{
+    BOOL replaced = (_messages[key] != nil);
+    if (!replaced) {
+        key = [key copy];
+        [_keys addObject:key];
+    }
+    _messages[key] = message;
+    return replaced;
+}
+
+- (nullable id)dequeueMessage
+{
+    NSString *key = _keys.firstObject;
+    if (!key) {
+        return nil;
+    }
+    [_keys removeObjectAtIndex:0];
+
+    id message = _messages[key];
+    [_messages removeObjectForKey:key];
+    return message;
+}
+
+- (void)removeAllMessages
+{
+    [_keys removeAllObjects];
+    [_messages removeAllObjects];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,27 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Pool of reusable buffers for outgoing frames.
+// This class is thread-safe, since buffers are returned once the output stream is done with them,
+// which can happen on any thread.
+@interface SRFrameBufferPool : NSObject
+
+- (instancetype)initWithBufferCapacity:(NSUInteger)poolSize maximumBufferLength:(NSUInteger)maximumBufferLength;
+
+// Returns a buffer that is at least `length` bytes long, or `nil` if it can't be allocated. Contents of the buffer are undefined.
+- (nullable NSMutableData *)bufferWithMinimumLength:(NSUInteger)length;
+- (void)returnBuffer:(NSMutableData *)buffer;
+
+@end
+
+NS_ASSUME_NONNULL_END
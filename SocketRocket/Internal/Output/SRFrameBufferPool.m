@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRFrameBufferPool.h"
+
+#import "SRMutex.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRFrameBufferPool {
+    SRMutex _lock;
+    NSUInteger _poolSize;
+    NSUInteger _maximumBufferLength;
+    NSMutableArray<NSMutableData *> *_bufferedBuffers;
+}
+
+- (instancetype)initWithBufferCapacity:(NSUInteger)poolSize maximumBufferLength:(NSUInteger)maximumBufferLength
+{
+    self = [super init];
+    if (!self) return self;
+
+    _lock = SRMutexInitRecursive();
+    _poolSize = poolSize;
+    _maximumBufferLength = maximumBufferLength;
+    _bufferedBuffers = [NSMutableArray arrayWithCapacity:poolSize];
+
+    return self;
+}
+
+- (instancetype)init
+{
+    return [self initWithBufferCapacity:8 maximumBufferLength:64 * 1024];
+}
+
+- (void)dealloc
+{
+    SRMutexDestroy(_lock);
+}
+
+- (nullable NSMutableData *)bufferWithMinimumLength:(NSUInteger)length
+{
+    // Such a buffer is never pooled, and allocating it reports a failure instead of raising like growing a pooled one would.
+    if (length > _maximumBufferLength) {
+        return [[NSMutableData alloc] initWithLength:length];
+    }
+
+    NSMutableData *buffer = nil;
+
+    SRMutexLock(_lock);
+    buffer = [_bufferedBuffers lastObject];
+    if (buffer) {
+        [_bufferedBuffers removeLastObject];
+    }
+    SRMutexUnlock(_lock);
+
+    if (!buffer) {
+        return [[NSMutableData alloc] initWithLength:length];
+    }
+    // Never shrink, since a reused buffer is only as useful as the memory it still holds on to.
+    if (buffer.length < length) {
+        buffer.length = length;
+    }
+    return buffer;
+}
+
+- (void)returnBuffer:(NSMutableData *)buffer
+{
+    if (buffer.length > _maximumBufferLength) {
+        return;
+    }
+
+    SRMutexLock(_lock);
+    if (_bufferedBuffers.count < _poolSize) {
+        [_bufferedBuffers addObject:buffer];
+    }
+    SRMutexUnlock(_lock);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
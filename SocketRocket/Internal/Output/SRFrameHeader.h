@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SRConstants.h"
+
+@class SRFrameBufferPool;
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const uint8_t SRFinMask          = 0x80;
+static const uint8_t SROpCodeMask       = 0x0F;
+static const uint8_t SRRsvMask          = 0x70;
+static const uint8_t SRMaskMask         = 0x80;
+static const uint8_t SRPayloadLenMask   = 0x7F;
+
+// Largest header of a masked client frame: 2 bytes + 8 bytes of extended payload length + 4 bytes of masking key.
+static const size_t SRFrameHeaderMaxLength = 14;
+
+// Number of bytes of the extended payload length that follow the first 2 bytes of a frame header with a 7-bit `payloadLength`.
+static inline size_t SRFrameHeaderExtendedLengthSize(uint8_t payloadLength)
+{
+    if (payloadLength == 126) {
+        return sizeof(uint16_t);
+    } else if (payloadLength == 127) {
+        return sizeof(uint64_t);
+    }
+    return 0;
+}
+
+// Reads the big-endian extended payload length, `bytes` must hold `SRFrameHeaderExtendedLengthSize(payloadLength)` bytes.
+static inline uint64_t SRFrameHeaderReadExtendedLength(const void *bytes, uint8_t payloadLength)
+{
+    if (payloadLength == 126) {
+        uint16_t length = 0;
+        memcpy(&length, bytes, sizeof(uint16_t));
+        return CFSwapInt16BigToHost(length);
+    } else if (payloadLength == 127) {
+        uint64_t length = 0;
+        memcpy(&length, bytes, sizeof(uint64_t));
+        return CFSwapInt64BigToHost(length);
+    }
+    return payloadLength;
+}
+
+// Length of the header of a masked, final client frame with a given payload length.
+extern size_t SRFrameHeaderLength(uint64_t payloadLength);
+
+// Writes the header of a masked, final client frame into `buffer`, including a freshly generated masking key,
+// which always occupies the last 4 bytes of the header.
+// `buffer` must have room for at least `SRFrameHeaderLength(payloadLength)` bytes. Returns number of bytes written.
+extern size_t SRFrameHeaderWrite(uint8_t *buffer, SROpCode opCode, uint64_t payloadLength);
+extern size_t SRFrameHeaderWriteWithMaskKey(uint8_t *buffer, SROpCode opCode, uint64_t payloadLength, const uint8_t *maskKey);
+
+// Creates a complete masked frame with a copy of `payload`. Returns `nil` if the frame can't be allocated.
+extern NSData *_Nullable SRFrameDataCreate(SROpCode opCode, NSData *payload);
+
+// Creates a frame in a pooled buffer from a payload split into multiple parts.
+// Each part is masked straight into the frame buffer, without concatenating the parts first.
+// Returns `nil` if the frame can't be allocated.
+extern NSData *_Nullable SRFrameDataCreateWithParts(SROpCode opCode, NSArray<NSData *> *parts, SRFrameBufferPool *bufferPool);
+extern NSData *_Nullable SRFrameDataCreateWithDispatchData(SROpCode opCode, dispatch_data_t payload, SRFrameBufferPool *bufferPool);
+
+// Creates a frame in a pooled buffer by encoding `string` as UTF-8 directly into it and masking it in the same pass.
+// Returns `nil` if `string` is `nil`, can't be encoded as UTF-8 or the frame can't be allocated.
+extern NSData *_Nullable SRFrameDataCreateWithString(SROpCode opCode, NSString *_Nullable string, SRFrameBufferPool *bufferPool);
+
+NS_ASSUME_NONNULL_END
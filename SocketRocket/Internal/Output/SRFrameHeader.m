@@ -0,0 +1,214 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRFrameHeader.h"
+
+#import "SRFrameBufferPool.h"
+#import "SRRandom.h"
+#import "SRSIMDHelpers.h"
+#import "SRTrace.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+size_t SRFrameHeaderLength(uint64_t payloadLength)
+{
+    size_t length = 2 + sizeof(uint32_t);
+    if (payloadLength >= 126) {
+        length += (payloadLength <= UINT16_MAX ? sizeof(uint16_t) : sizeof(uint64_t));
+    }
+    return length;
+}
+
+size_t SRFrameHeaderWrite(uint8_t *buffer, SROpCode opCode, uint64_t payloadLength)
+{
+    uint8_t maskKey[sizeof(uint32_t)];
+    SRRandomBytes(maskKey, sizeof(maskKey));
+    return SRFrameHeaderWriteWithMaskKey(buffer, opCode, payloadLength, maskKey);
+}
+
+size_t SRFrameHeaderWriteWithMaskKey(uint8_t *buffer, SROpCode opCode, uint64_t payloadLength, const uint8_t *maskKey)
+{
+    // set fin
+    buffer[0] = SRFinMask | opCode;
+
+    // set the mask and header
+    buffer[1] = SRMaskMask;
+
+    size_t headerLength = 2;
+
+    if (payloadLength < 126) {
+        buffer[1] |= payloadLength;
+    } else if (payloadLength <= UINT16_MAX) {
+        buffer[1] |= 126;
+
+        uint16_t declaredPayloadLength = CFSwapInt16HostToBig((uint16_t)payloadLength);
+        memcpy(buffer + headerLength, &declaredPayloadLength, sizeof(declaredPayloadLength));
+        headerLength += sizeof(declaredPayloadLength);
+    } else {
+        buffer[1] |= 127;
+
+        uint64_t declaredPayloadLength = CFSwapInt64HostToBig(payloadLength);
+        memcpy(buffer + headerLength, &declaredPayloadLength, sizeof(declaredPayloadLength));
+        headerLength += sizeof(declaredPayloadLength);
+    }
+
+    memcpy(buffer + headerLength, maskKey, sizeof(uint32_t));
+    headerLength += sizeof(uint32_t);
+
+    return headerLength;
+}
+
+NSData *_Nullable SRFrameDataCreate(SROpCode opCode, NSData *payload)
+{
+    size_t payloadLength = payload.length;
+
+    NSMutableData *frameData = [[NSMutableData alloc] initWithLength:payloadLength + SRFrameHeaderMaxLength];
+    if (!frameData) {
+        return nil;
+    }
+    uint8_t *frameBuffer = (uint8_t *)frameData.mutableBytes;
+
+    size_t headerLength = SRFrameHeaderWrite(frameBuffer, opCode, payloadLength);
+
+    // Copy and mask the buffer
+    uint8_t *payloadBuffer = frameBuffer + headerLength;
+    memcpy(payloadBuffer, payload.bytes, payloadLength);
+    SR_TRACE_BEGIN(Mask);
+    SRMaskBytesSIMD(payloadBuffer, payloadLength, payloadBuffer - sizeof(uint32_t));
+    SR_TRACE_END(Mask, payloadLength);
+
+    frameData.length = headerLength + payloadLength;
+    return frameData;
+}
+
+// Masks a region of the payload that starts `offset` bytes into it, copying it into `payloadBuffer`.
+static void SRFrameMaskCopyRegion(uint8_t *payloadBuffer, size_t offset, const void *bytes, size_t length, const uint8_t *maskKey)
+{
+    uint8_t regionMaskKey[sizeof(uint32_t)];
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+        regionMaskKey[i] = maskKey[(offset + i) % sizeof(uint32_t)];
+    }
+    SR_TRACE_BEGIN(Mask);
+    SRMaskCopyBytesSIMD(payloadBuffer + offset, bytes, length, regionMaskKey);
+    SR_TRACE_END(Mask, length);
+}
+
+static NSData *_Nullable SRFrameDataCreateWithRegions(SROpCode opCode,
+                                                      size_t payloadLength,
+                                                      SRFrameBufferPool *bufferPool,
+                                                      void (^enumerateRegions)(void (^copyRegion)(const void *bytes, size_t length)))
+{
+    NSMutableData *buffer = [bufferPool bufferWithMinimumLength:SRFrameHeaderMaxLength + payloadLength];
+    if (!buffer) {
+        return nil;
+    }
+    uint8_t *frameBuffer = (uint8_t *)buffer.mutableBytes;
+
+    size_t headerLength = SRFrameHeaderWrite(frameBuffer, opCode, payloadLength);
+    uint8_t *payloadBuffer = frameBuffer + headerLength;
+    const uint8_t *maskKey = payloadBuffer - sizeof(uint32_t);
+
+    __block size_t offset = 0;
+    enumerateRegions(^(const void *bytes, size_t length) {
+        SRFrameMaskCopyRegion(payloadBuffer, offset, bytes, length, maskKey);
+        offset += length;
+    });
+    NSCAssert(offset == payloadLength, @"Payload changed while it was being framed.");
+
+    return [[NSData alloc] initWithBytesNoCopy:frameBuffer length:headerLength + payloadLength deallocator:^(void *bytes, NSUInteger length) {
+        [bufferPool returnBuffer:buffer];
+    }];
+}
+
+NSData *_Nullable SRFrameDataCreateWithParts(SROpCode opCode, NSArray<NSData *> *parts, SRFrameBufferPool *bufferPool)
+{
+    size_t payloadLength = 0;
+    for (NSData *part in parts) {
+        payloadLength += part.length;
+    }
+
+    return SRFrameDataCreateWithRegions(opCode, payloadLength, bufferPool, ^(void (^copyRegion)(const void *, size_t)) {
+        for (NSData *part in parts) {
+            // Parts backed by `dispatch_data_t` may be discontiguous, `bytes` would flatten them into a copy.
+            [part enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+                copyRegion(bytes, byteRange.length);
+            }];
+        }
+    });
+}
+
+NSData *_Nullable SRFrameDataCreateWithDispatchData(SROpCode opCode, dispatch_data_t payload, SRFrameBufferPool *bufferPool)
+{
+    return SRFrameDataCreateWithRegions(opCode, dispatch_data_get_size(payload), bufferPool, ^(void (^copyRegion)(const void *, size_t)) {
+        dispatch_data_apply(payload, ^bool(dispatch_data_t region, size_t offset, const void *buffer, size_t size) {
+            copyRegion(buffer, size);
+            return true;
+        });
+    });
+}
+
+NSData *_Nullable SRFrameDataCreateWithString(SROpCode opCode, NSString *_Nullable string, SRFrameBufferPool *bufferPool)
+{
+    if (!string) {
+        return nil;
+    }
+    CFStringRef cfString = (__bridge CFStringRef)string;
+
+    // ASCII-backed strings expose their storage, which is already valid UTF-8 of a known length.
+    const char *asciiBytes = CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+    if (asciiBytes) {
+        size_t length = (size_t)CFStringGetLength(cfString);
+        return SRFrameDataCreateWithRegions(opCode, length, bufferPool, ^(void (^copyRegion)(const void *, size_t)) {
+            copyRegion(asciiBytes, length);
+        });
+    }
+
+    // Otherwise encode in small chunks that stay in cache and mask each of them into the frame buffer,
+    // leaving room for the largest header in front of the payload, since the encoded length isn't known yet.
+    NSUInteger maximumLength = [string maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *buffer = [bufferPool bufferWithMinimumLength:SRFrameHeaderMaxLength + maximumLength];
+    if (!buffer) {
+        return nil;
+    }
+    uint8_t *payloadBuffer = (uint8_t *)buffer.mutableBytes + SRFrameHeaderMaxLength;
+
+    uint8_t maskKey[sizeof(uint32_t)];
+    SRRandomBytes(maskKey, sizeof(maskKey));
+
+    uint8_t chunk[4096];
+    size_t payloadLength = 0;
+    NSRange remainingRange = NSMakeRange(0, string.length);
+    while (remainingRange.length > 0) {
+        NSUInteger usedLength = 0;
+        BOOL encoded = [string getBytes:chunk
+                              maxLength:sizeof(chunk)
+                             usedLength:&usedLength
+                               encoding:NSUTF8StringEncoding
+                                options:0
+                                  range:remainingRange
+                         remainingRange:&remainingRange];
+        // Encoding stops in front of characters UTF-8 can't represent, such as unpaired surrogates.
+        if (!encoded || usedLength == 0) {
+            [bufferPool returnBuffer:buffer];
+            return nil;
+        }
+        SRFrameMaskCopyRegion(payloadBuffer, payloadLength, chunk, usedLength, maskKey);
+        payloadLength += usedLength;
+    }
+
+    size_t headerLength = SRFrameHeaderLength(payloadLength);
+    uint8_t *frameBuffer = payloadBuffer - headerLength;
+    SRFrameHeaderWriteWithMaskKey(frameBuffer, opCode, payloadLength, maskKey);
+
+    return [[NSData alloc] initWithBytesNoCopy:frameBuffer length:headerLength + payloadLength deallocator:^(void *bytes, NSUInteger length) {
+        [bufferPool returnBuffer:buffer];
+    }];
+}
+
+NS_ASSUME_NONNULL_END
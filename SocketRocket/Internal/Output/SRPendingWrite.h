@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Tracks a single outgoing frame until its last byte is handed to the output stream.
+// This class is not thread-safe, and after creation is expected to always be used on the socket work queue.
+@interface SRPendingWrite : NSObject
+
+// Range of the frame in the output stream, counting from the first byte ever written by the socket.
+@property (nonatomic, assign) uint64_t startOffset;
+@property (nonatomic, assign) uint64_t endOffset;
+
+@property (nonatomic, assign, readonly) SRSendTimestamps timestamps;
+
+// Records enqueue time as the time of creation.
+- (instancetype)initWithQueue:(nullable dispatch_queue_t)queue completion:(SRSendCompletionHandler)completion;
+
+- (void)markFirstByteWrittenAtTime:(uint64_t)time;
+- (void)markLastByteWrittenAtTime:(uint64_t)time;
+
+// Calls completion handler on the completion queue. Only the first call has any effect.
+- (void)completeWithError:(nullable NSError *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRPendingWrite.h"
+
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRPendingWrite {
+    dispatch_queue_t _queue;
+    SRSendCompletionHandler _completion;
+}
+
+- (instancetype)initWithQueue:(nullable dispatch_queue_t)queue completion:(SRSendCompletionHandler)completion
+{
+    self = [super init];
+    if (!self) return self;
+
+    _queue = queue ?: dispatch_get_main_queue();
+    _completion = [completion copy];
+    _timestamps.enqueueTime = SRMonotonicTimeNanoseconds();
+
+    return self;
+}
+
+- (void)markFirstByteWrittenAtTime:(uint64_t)time
+{
+    if (_timestamps.firstByteTime == 0) {
+        _timestamps.firstByteTime = time;
+    }
+}
+
+- (void)markLastByteWrittenAtTime:(uint64_t)time
+{
+    [self markFirstByteWrittenAtTime:time];
+    _timestamps.lastByteTime = time;
+}
+
+- (void)completeWithError:(nullable NSError *)error
+{
+    SRSendCompletionHandler completion = _completion;
+    if (!completion) {
+        return;
+    }
+    _completion = nil;
+
+    SRSendTimestamps timestamps = _timestamps;
+    dispatch_async(_queue, ^{
+        completion(timestamps, error);
+    });
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
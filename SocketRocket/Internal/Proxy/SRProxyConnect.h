@@ -11,6 +11,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class SRMetricsRecorder;
+
 typedef void(^SRProxyConnectCompletion)(NSError *_Nullable error,
                                         NSInputStream *_Nullable readStream,
                                         NSOutputStream *_Nullable writeStream);
@@ -19,6 +21,9 @@ typedef void(^SRProxyConnectCompletion)(NSError *_Nullable error,
 
 - (instancetype)initWithURL:(NSURL *)url;
 
+// Receives the timestamps of proxy resolution, connecting and the proxy `CONNECT` request.
+@property (nullable, nonatomic, strong) SRMetricsRecorder *metricsRecorder;
+
 - (void)openNetworkStreamWithCompletion:(SRProxyConnectCompletion)completion;
 
 @end
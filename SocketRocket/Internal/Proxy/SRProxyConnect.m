@@ -13,6 +13,7 @@
 #import "SRConstants.h"
 #import "SRError.h"
 #import "SRLog.h"
+#import "SRMetricsRecorder.h"
 #import "SRURLUtilities.h"
 
 @interface SRProxyConnect() <NSStreamDelegate>
@@ -209,15 +210,25 @@
     }
 }
 
+- (void)_markHandshake:(SRHandshakeMark)mark
+{
+    SRMetricsRecorder *recorder = self.metricsRecorder;
+    if (recorder) {
+        SRMetricsMarkHandshake(&recorder->_counters, mark);
+    }
+}
+
 - (void)_fetchPAC:(NSURL *)PACurl withProxySettings:(NSDictionary *)proxySettings
 {
     SRDebugLog(@"SRWebSocket fetchPAC:%@", PACurl);
+    [self _markHandshake:SRHandshakeMarkPACFetchStart];
 
     if ([PACurl isFileURL]) {
         NSError *error = nil;
         NSString *script = [NSString stringWithContentsOfURL:PACurl
                                                 usedEncoding:NULL
                                                        error:&error];
+        [self _markHandshake:SRHandshakeMarkPACFetchEnd];
 
         if (error) {
             [self _openConnection];
@@ -239,6 +250,7 @@
     NSURLSession *session = [NSURLSession sharedSession];
     [[session dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
         __strong typeof(wself) sself = wself;
+        [sself _markHandshake:SRHandshakeMarkPACFetchEnd];
         if (!error) {
             NSString *script = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
             [sself _runPACScript:script withProxySettings:proxySettings];
@@ -271,7 +283,9 @@
     else
         httpURL = [NSURL URLWithString:[NSString stringWithFormat:@"http://%@", _url.host]];
 
+    [self _markHandshake:SRHandshakeMarkPACEvaluationStart];
     NSArray *proxies = CFBridgingRelease(CFNetworkCopyProxiesForAutoConfigurationScript((__bridge CFStringRef)script,(__bridge CFURLRef)httpURL, &err));
+    [self _markHandshake:SRHandshakeMarkPACEvaluationEnd];
     if (!err && [proxies count] > 0) {
         NSDictionary *settings = [proxies objectAtIndex:0];
         NSString *proxyType = settings[(NSString *)kCFProxyTypeKey];
@@ -282,6 +296,7 @@
 
 - (void)_openConnection
 {
+    [self _markHandshake:SRHandshakeMarkConnectStart];
     [self _initializeStreams];
 
     [self.inputStream scheduleInRunLoop:[NSRunLoop SR_networkRunLoop]
@@ -341,6 +356,7 @@
     switch (eventCode) {
         case NSStreamEventOpenCompleted: {
             if (aStream == self.inputStream) {
+                [self _markHandshake:SRHandshakeMarkConnectEnd];
                 if (_httpProxyHost) {
                     [self _proxyDidConnect];
                 } else {
@@ -369,6 +385,7 @@
 - (void)_proxyDidConnect
 {
     SRDebugLog(@"Proxy Connected");
+    [self _markHandshake:SRHandshakeMarkProxyConnectStart];
     uint32_t port = _url.port.unsignedIntValue;
     if (port == 0) {
         port = (_connectionRequiresSSL ? 443 : 80);
@@ -434,10 +451,11 @@
 
 - (void)_proxyHTTPHeadersDidFinish
 {
+    [self _markHandshake:SRHandshakeMarkProxyConnectEnd];
     NSInteger responseCode = CFHTTPMessageGetResponseStatusCode(_receivedHTTPHeaders);
 
     if (responseCode >= 299) {
-        SRDebugLog(@"Connect to Proxy Request failed with response code %d", responseCode);
+        SRWarningLog(@"Connect to Proxy Request failed with response code %d", (int)responseCode);
         NSError *error = SRHTTPErrorWithCodeDescription(responseCode, 2132,
                                                         [NSString stringWithFormat:@"Received bad response code from proxy server: %d.",
                                                          (int)responseCode]);
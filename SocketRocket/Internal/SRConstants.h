@@ -20,6 +20,11 @@ typedef NS_ENUM(uint8_t, SROpCode)
     // B-F reserved.
 };
 
+/**
+ GUID the peer appends to `Sec-WebSocket-Key` before hashing it into `Sec-WebSocket-Accept`.
+ */
+extern NSString *const SRWebSocketAppendToSecKeyString;
+
 /**
  Default buffer size that is used for reading/writing to streams.
  */
@@ -9,6 +9,8 @@
 
 #import "SRConstants.h"
 
+NSString *const SRWebSocketAppendToSecKeyString = @"258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
 size_t SRDefaultBufferSize(void) {
     static size_t size;
     static dispatch_once_t onceToken;
@@ -0,0 +1,23 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <SocketRocket/SRLoopbackTransport.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SRLoopbackTransport ()
+
+// Builds the link with the current configuration, starts the server and returns the client end as opened streams.
+// Can only be called once.
+- (void)openClientInputStream:(NSInputStream *_Nullable *_Nonnull)inputStream
+                 outputStream:(NSOutputStream *_Nullable *_Nonnull)outputStream;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,27 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <SocketRocket/SRMessage.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SRMessage ()
+
+- (instancetype)initWithPayload:(id)payload
+                         opCode:(SRMessageOpCode)opCode
+                  payloadLength:(NSUInteger)payloadLength
+                     frameCount:(NSUInteger)frameCount
+                     compressed:(BOOL)compressed
+                  firstByteTime:(uint64_t)firstByteTime
+                   lastByteTime:(uint64_t)lastByteTime
+                     queuedTime:(uint64_t)queuedTime;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,31 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <SocketRocket/SRMessageBuilder.h>
+
+#import "SRConstants.h"
+
+@class SRFrameBufferPool;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SRMessageBuilder ()
+
+@property (nonatomic, assign, readonly, getter=isFinished) BOOL finished;
+
+- (instancetype)initWithBufferPool:(SRFrameBufferPool *)bufferPool capacity:(NSUInteger)capacity;
+
+// Writes the frame header in front of the payload and masks the payload in place.
+// Returns frame data that hands the buffer back to the pool once released, or `nil` if the buffer couldn't be allocated.
+// Can only be called once.
+- (nullable NSData *)finishFrameWithOpCode:(SROpCode)opCode;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Handle of a timer scheduled on `SRTimerWheel`.
+@interface SRTimerWheelTimer : NSObject
+
+@property (atomic, assign, readonly, getter=isCancelled) BOOL cancelled;
+
+@end
+
+// Hierarchical timer wheel that drives timers of all sockets from a single dispatch timer on a private queue,
+// instead of a kernel timer per socket. Scheduling and cancelling a timer is O(1).
+// Timers fire no earlier than their delay, rounded up to the tick interval.
+// This class is thread-safe.
+@interface SRTimerWheel : NSObject
+
++ (instancetype)sharedWheel;
+
+- (instancetype)initWithTickInterval:(NSTimeInterval)tickInterval NS_DESIGNATED_INITIALIZER;
+
+// Block is called asynchronously on `queue`.
+- (SRTimerWheelTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block;
+
+// If called on the queue the timer was scheduled with - the block is guaranteed not to be called afterwards.
+- (void)cancelTimer:(nullable SRTimerWheelTimer *)timer;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,254 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRTimerWheel.h"
+
+#import "SRMutex.h"
+#import "SRTime.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// The first level has a slot per tick, every next level has a slot per full turn of the previous one.
+// With 10ms ticks the levels cover 2.56 seconds, 2.7 minutes, 2.9 hours and 7.8 days.
+// Longer timers wait in the furthest slot of the top level and are put back in whenever it cascades.
+static const NSUInteger SRTimerWheelFirstLevelBits = 8;
+static const NSUInteger SRTimerWheelLevelBits = 6;
+static const NSUInteger SRTimerWheelLevelCount = 4;
+
+static inline NSUInteger SRTimerWheelLevelShift(NSUInteger level)
+{
+    return (level == 0 ? 0 : SRTimerWheelFirstLevelBits + (level - 1) * SRTimerWheelLevelBits);
+}
+
+static inline NSUInteger SRTimerWheelLevelSlotCount(NSUInteger level)
+{
+    return (NSUInteger)1 << (level == 0 ? SRTimerWheelFirstLevelBits : SRTimerWheelLevelBits);
+}
+
+@interface SRTimerWheelTimer ()
+
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nullable, nonatomic, copy) dispatch_block_t block;
+
+// Tick the timer expires at and the slot of the wheel it is in, which is earlier for timers beyond the range of the wheel.
+@property (nonatomic, assign) uint64_t expirationTick;
+@property (nonatomic, assign) NSUInteger level;
+@property (nonatomic, assign) NSUInteger slot;
+
+@property (atomic, assign, readwrite, getter=isCancelled) BOOL cancelled;
+
+@end
+
+@implementation SRTimerWheelTimer
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue block:(dispatch_block_t)block
+{
+    self = [super init];
+    if (!self) return self;
+
+    _queue = queue;
+    _block = [block copy];
+
+    return self;
+}
+
+- (void)fire
+{
+    dispatch_async(_queue, ^{
+        if (self.cancelled) {
+            return;
+        }
+        dispatch_block_t block = self.block;
+        self.block = nil;
+        if (block) {
+            block();
+        }
+    });
+}
+
+@end
+
+@implementation SRTimerWheel {
+    SRMutex _lock;
+    dispatch_queue_t _queue;
+    dispatch_source_t _Nullable _tickSource;
+
+    uint64_t _tickInterval;
+    uint64_t _currentTick;
+    // Time tick 0 was due at, every next tick is due an interval later.
+    uint64_t _originTime;
+    NSArray<NSArray<NSMutableSet<SRTimerWheelTimer *> *> *> *_levels;
+    NSUInteger _timerCount;
+}
+
++ (instancetype)sharedWheel
+{
+    static SRTimerWheel *wheel;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        wheel = [[SRTimerWheel alloc] initWithTickInterval:0.01];
+    });
+    return wheel;
+}
+
+- (instancetype)initWithTickInterval:(NSTimeInterval)tickInterval
+{
+    self = [super init];
+    if (!self) return self;
+
+    _lock = SRMutexInitRecursive();
+    _queue = dispatch_queue_create("com.facebook.socketrocket.timerwheel", DISPATCH_QUEUE_SERIAL);
+    _tickInterval = (uint64_t)(tickInterval * NSEC_PER_SEC);
+
+    NSMutableArray<NSArray<NSMutableSet<SRTimerWheelTimer *> *> *> *levels = [NSMutableArray arrayWithCapacity:SRTimerWheelLevelCount];
+    for (NSUInteger level = 0; level < SRTimerWheelLevelCount; level++) {
+        NSUInteger slotCount = SRTimerWheelLevelSlotCount(level);
+        NSMutableArray<NSMutableSet<SRTimerWheelTimer *> *> *slots = [NSMutableArray arrayWithCapacity:slotCount];
+        for (NSUInteger i = 0; i < slotCount; i++) {
+            [slots addObject:[NSMutableSet set]];
+        }
+        [levels addObject:slots];
+    }
+    _levels = levels;
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_tickSource) {
+        dispatch_source_cancel(_tickSource);
+    }
+    SRMutexDestroy(_lock);
+}
+
+#pragma mark - Timers
+
+- (SRTimerWheelTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block
+{
+    SRTimerWheelTimer *timer = [[SRTimerWheelTimer alloc] initWithQueue:queue block:block];
+
+    uint64_t delayInterval = (uint64_t)(MAX(delay, 0.0) * NSEC_PER_SEC);
+
+    SRMutexLock(_lock);
+    if (!_tickSource) {
+        [self _startTicking];
+    }
+    // Expire at the first tick that is due after the deadline. Counting from when ticks are due rather than from
+    // the current tick doesn't fire early, when the current tick is partially elapsed or ticks are processed late.
+    uint64_t deadline = SRMonotonicTimeNanoseconds() + delayInterval - _originTime;
+    timer.expirationTick = MAX((deadline + _tickInterval - 1) / _tickInterval, _currentTick + 1);
+    [self _insertTimer:timer];
+    _timerCount++;
+    SRMutexUnlock(_lock);
+
+    return timer;
+}
+
+- (void)cancelTimer:(nullable SRTimerWheelTimer *)timer
+{
+    if (!timer) {
+        return;
+    }
+    timer.cancelled = YES;
+
+    SRMutexLock(_lock);
+    NSMutableSet<SRTimerWheelTimer *> *slot = _levels[timer.level][timer.slot];
+    if ([slot containsObject:timer]) {
+        [slot removeObject:timer];
+        _timerCount--;
+    }
+    SRMutexUnlock(_lock);
+}
+
+// Puts the timer on the lowest level that can hold its remaining delay.
+- (void)_insertTimer:(SRTimerWheelTimer *)timer
+{
+    uint64_t maximumDelay = ((uint64_t)1 << (SRTimerWheelLevelShift(SRTimerWheelLevelCount - 1) + SRTimerWheelLevelBits)) - 1;
+    uint64_t delay = MIN(timer.expirationTick - _currentTick, maximumDelay);
+    uint64_t slotTick = _currentTick + delay;
+
+    NSUInteger level = 0;
+    while (level < SRTimerWheelLevelCount - 1 &&
+           delay >= ((uint64_t)1 << SRTimerWheelLevelShift(level + 1))) {
+        level++;
+    }
+
+    timer.level = level;
+    timer.slot = (NSUInteger)(slotTick >> SRTimerWheelLevelShift(level)) & (SRTimerWheelLevelSlotCount(level) - 1);
+    [_levels[level][timer.slot] addObject:timer];
+}
+
+#pragma mark - Ticking
+
+- (void)_startTicking
+{
+    _originTime = SRMonotonicTimeNanoseconds() - _currentTick * _tickInterval;
+    _tickSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+    dispatch_source_set_timer(_tickSource, dispatch_time(DISPATCH_TIME_NOW, (int64_t)_tickInterval), _tickInterval, _tickInterval / 10);
+
+    __weak typeof(self) wself = self;
+    dispatch_source_t tickSource = _tickSource;
+    dispatch_source_set_event_handler(_tickSource, ^{
+        // Ticks that were missed while the process was busy are coalesced into a single event.
+        [wself _advanceTicks:dispatch_source_get_data(tickSource)];
+    });
+    dispatch_resume(_tickSource);
+}
+
+- (void)_advanceTicks:(unsigned long)tickCount
+{
+    NSMutableArray<SRTimerWheelTimer *> *expiredTimers = [NSMutableArray array];
+
+    SRMutexLock(_lock);
+    for (unsigned long i = 0; i < tickCount && _timerCount > 0; i++) {
+        _currentTick++;
+
+        // Once a level completes a turn, move timers from the next slot of the level above down to where they belong now.
+        for (NSUInteger level = 1; level < SRTimerWheelLevelCount; level++) {
+            if ((_currentTick & (((uint64_t)1 << SRTimerWheelLevelShift(level)) - 1)) != 0) {
+                break;
+            }
+            NSUInteger slotIndex = (NSUInteger)(_currentTick >> SRTimerWheelLevelShift(level)) & (SRTimerWheelLevelSlotCount(level) - 1);
+            NSMutableSet<SRTimerWheelTimer *> *slot = _levels[level][slotIndex];
+            if (slot.count == 0) {
+                continue;
+            }
+            NSArray<SRTimerWheelTimer *> *cascadingTimers = slot.allObjects;
+            [slot removeAllObjects];
+            for (SRTimerWheelTimer *timer in cascadingTimers) {
+                [self _insertTimer:timer];
+            }
+        }
+
+        // Every timer in the current slot of the first level expires now.
+        NSMutableSet<SRTimerWheelTimer *> *slot = _levels[0][(NSUInteger)_currentTick & (SRTimerWheelLevelSlotCount(0) - 1)];
+        if (slot.count == 0) {
+            continue;
+        }
+        [expiredTimers addObjectsFromArray:slot.allObjects];
+        _timerCount -= slot.count;
+        [slot removeAllObjects];
+    }
+
+    // Don't keep waking up while there is nothing to fire.
+    if (_timerCount == 0 && _tickSource) {
+        dispatch_source_cancel(_tickSource);
+        _tickSource = nil;
+    }
+    SRMutexUnlock(_lock);
+
+    for (SRTimerWheelTimer *timer in expiredTimers) {
+        [timer fire];
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -8,13 +8,50 @@
 //
 
 #import <Foundation/Foundation.h>
+#import <stdatomic.h>
+
+#import <SocketRocket/SRWebSocket.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
 // Uncomment this line to enable debug logging
 //#define SR_DEBUG_LOG_ENABLED
 
-extern void SRErrorLog(NSString *format, ...);
-extern void SRDebugLog(NSString *format, ...);
+// Most verbose level that is compiled in, call sites of more verbose levels are removed entirely.
+#ifndef SR_LOG_LEVEL_MAXIMUM
+#ifdef SR_DEBUG_LOG_ENABLED
+#define SR_LOG_LEVEL_MAXIMUM SRLogLevelDebug
+#else
+#define SR_LOG_LEVEL_MAXIMUM SRLogLevelInfo
+#endif
+#endif
+
+extern atomic_int SRLogRuntimeLevel;
+
+static inline BOOL SRLogLevelEnabled(SRLogLevel level)
+{
+    return (level <= SR_LOG_LEVEL_MAXIMUM && level <= atomic_load_explicit(&SRLogRuntimeLevel, memory_order_relaxed));
+}
+
+// Formats the message and queues it for the sink. Use the macros below, which skip evaluating the arguments when the level is disabled.
+extern void SRLogWrite(SRLogLevel level, NSString *format, ...);
+
+// Hands all messages queued so far to the sink before returning.
+extern void SRLogFlush(void);
+
+extern void SRLogSetSink(SRLogSink _Nullable sink);
+extern SRLogSink _Nullable SRLogGetSink(void);
+
+#define SRLogWithLevel(level, format, ...) \
+    do { \
+        if (SRLogLevelEnabled(level)) { \
+            SRLogWrite((level), (format), ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define SRErrorLog(format, ...) SRLogWithLevel(SRLogLevelError, format, ##__VA_ARGS__)
+#define SRWarningLog(format, ...) SRLogWithLevel(SRLogLevelWarning, format, ##__VA_ARGS__)
+#define SRInfoLog(format, ...) SRLogWithLevel(SRLogLevelInfo, format, ##__VA_ARGS__)
+#define SRDebugLog(format, ...) SRLogWithLevel(SRLogLevelDebug, format, ##__VA_ARGS__)
 
 NS_ASSUME_NONNULL_END
@@ -9,25 +9,193 @@
 
 #import "SRLog.h"
 
+#import "SRThreadBuffer.h"
+#import "SRTime.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
-extern void SRErrorLog(NSString *format, ...)
+atomic_int SRLogRuntimeLevel = SRLogLevelError;
+
+// Must be a power of two.
+static const uint64_t SRLogBufferCapacity = 64 * 1024;
+// Longer messages are truncated, so that a single message can't take over the buffer.
+static const size_t SRLogMaximumMessageLength = 8 * 1024;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t length;
+    uint32_t level;
+} SRLogRecordHeader;
+
+// Single producer, single consumer byte ring of records, written only by the thread that owns it and read only on the drain queue.
+typedef struct {
+    SRThreadBuffer base;
+    atomic_uint_fast64_t head;
+    atomic_uint_fast64_t tail;
+    atomic_uint_fast64_t droppedCount;
+    uint8_t bytes[SRLogBufferCapacity];
+} SRLogBuffer;
+
+// Accessed only on the drain queue.
+static SRLogSink _Nullable SRLogSinkBlock;
+
+static dispatch_queue_t SRLogDrainQueue(void);
+static dispatch_source_t SRLogDrainSource(void);
+
+// Ring keeps its position when another thread takes it over, so records left by the exited thread are still drained first.
+static void SRLogBufferRelease(SRThreadBuffer *buffer)
+{
+    dispatch_source_merge_data(SRLogDrainSource(), 1);
+}
+
+static SRThreadBufferList SRLogBuffers = SRThreadBufferListInitializer(SRLogBuffer, NULL, SRLogBufferRelease);
+
+static void SRLogBufferCopyIn(SRLogBuffer *buffer, uint64_t position, const void *bytes, size_t length)
 {
-    __block va_list arg_list;
-    va_start (arg_list, format);
+    size_t offset = position & (SRLogBufferCapacity - 1);
+    size_t firstLength = MIN(length, SRLogBufferCapacity - offset);
+    memcpy(buffer->bytes + offset, bytes, firstLength);
+    memcpy(buffer->bytes, (const uint8_t *)bytes + firstLength, length - firstLength);
+}
+
+static void SRLogBufferCopyOut(SRLogBuffer *buffer, uint64_t position, void *bytes, size_t length)
+{
+    size_t offset = position & (SRLogBufferCapacity - 1);
+    size_t firstLength = MIN(length, SRLogBufferCapacity - offset);
+    memcpy(bytes, buffer->bytes + offset, firstLength);
+    memcpy((uint8_t *)bytes + firstLength, buffer->bytes, length - firstLength);
+}
+
+static size_t SRLogRecordLength(uint32_t messageLength)
+{
+    // Keep headers aligned, so they never straddle the end of the ring in an odd way.
+    return (sizeof(SRLogRecordHeader) + messageLength + 7) & ~(size_t)7;
+}
+
+void SRLogWrite(SRLogLevel level, NSString *format, ...)
+{
+    va_list arguments;
+    va_start(arguments, format);
+    NSString *message = [[NSString alloc] initWithFormat:format arguments:arguments];
+    va_end(arguments);
+
+    uint8_t messageBytes[SRLogMaximumMessageLength];
+    NSUInteger messageLength = 0;
+    [message getBytes:messageBytes
+            maxLength:sizeof(messageBytes)
+           usedLength:&messageLength
+             encoding:NSUTF8StringEncoding
+              options:0
+                range:NSMakeRange(0, message.length)
+       remainingRange:NULL];
+
+    SRLogBuffer *buffer = (SRLogBuffer *)SRThreadBufferListCurrentBuffer(&SRLogBuffers);
+    if (!buffer) {
+        return;
+    }
 
-    NSString *formattedString = [[NSString alloc] initWithFormat:format arguments:arg_list];
+    SRLogRecordHeader header = {SRMonotonicTimeNanoseconds(), (uint32_t)messageLength, (uint32_t)level};
+    size_t recordLength = SRLogRecordLength(header.length);
 
-    va_end(arg_list);
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+    if (SRLogBufferCapacity - (head - tail) < recordLength) {
+        // Never wait for the drain queue, losing a message is better than stalling the socket.
+        atomic_fetch_add_explicit(&buffer->droppedCount, 1, memory_order_relaxed);
+    } else {
+        SRLogBufferCopyIn(buffer, head, &header, sizeof(header));
+        SRLogBufferCopyIn(buffer, head + sizeof(header), messageBytes, header.length);
+        atomic_store_explicit(&buffer->head, head + recordLength, memory_order_release);
+    }
 
-    NSLog(@"[SocketRocket] %@", formattedString);
+    dispatch_source_merge_data(SRLogDrainSource(), 1);
+}
+
+static void SRLogEmit(SRLogLevel level, NSString *message)
+{
+    if (SRLogSinkBlock) {
+        SRLogSinkBlock(level, message);
+    } else {
+        NSLog(@"[SocketRocket] %@", message);
+    }
+}
+
+static void SRLogDrain(void)
+{
+    uint8_t messageBytes[SRLogMaximumMessageLength];
+
+    for (SRThreadBuffer *threadBuffer = SRThreadBufferListFirstBuffer(&SRLogBuffers); threadBuffer; threadBuffer = threadBuffer->next) {
+        SRLogBuffer *buffer = (SRLogBuffer *)threadBuffer;
+        uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+        while (tail < head) {
+            SRLogRecordHeader header;
+            SRLogBufferCopyOut(buffer, tail, &header, sizeof(header));
+            SRLogBufferCopyOut(buffer, tail + sizeof(header), messageBytes, header.length);
+            tail += SRLogRecordLength(header.length);
+
+            NSString *message = [[NSString alloc] initWithBytes:messageBytes length:header.length encoding:NSUTF8StringEncoding];
+            SRLogEmit((SRLogLevel)header.level, message ?: @"");
+        }
+        atomic_store_explicit(&buffer->tail, tail, memory_order_release);
+
+        uint64_t droppedCount = atomic_exchange_explicit(&buffer->droppedCount, 0, memory_order_relaxed);
+        if (droppedCount > 0) {
+            SRLogEmit(SRLogLevelWarning, [NSString stringWithFormat:@"Dropped %llu log messages, the log buffer was full.", droppedCount]);
+        }
+    }
+}
+
+static dispatch_queue_t SRLogDrainQueue(void)
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dispatch_queue_attr_t attributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+        queue = dispatch_queue_create("com.facebook.SocketRocket.log", attributes);
+    });
+    return queue;
+}
+
+static dispatch_source_t SRLogDrainSource(void)
+{
+    static dispatch_source_t source;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // Wake-ups coalesce, so a burst of messages is drained in one go.
+        source = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_OR, 0, 0, SRLogDrainQueue());
+        dispatch_source_set_event_handler(source, ^{
+            SRLogDrain();
+        });
+        dispatch_resume(source);
+    });
+    return source;
+}
+
+void SRLogFlush(void)
+{
+    dispatch_sync(SRLogDrainQueue(), ^{
+        SRLogDrain();
+    });
+}
+
+void SRLogSetSink(SRLogSink _Nullable sink)
+{
+    sink = [sink copy];
+    dispatch_sync(SRLogDrainQueue(), ^{
+        // Messages queued before the change still go to the previous sink.
+        SRLogDrain();
+        SRLogSinkBlock = sink;
+    });
 }
 
-extern void SRDebugLog(NSString *format, ...)
+SRLogSink _Nullable SRLogGetSink(void)
 {
-#ifdef SR_DEBUG_LOG_ENABLED
-    SRErrorLog(tag, format);
-#endif
+    __block SRLogSink sink = nil;
+    dispatch_sync(SRLogDrainQueue(), ^{
+        sink = SRLogSinkBlock;
+    });
+    return sink;
 }
 
 NS_ASSUME_NONNULL_END
@@ -12,5 +12,6 @@
 NS_ASSUME_NONNULL_BEGIN
 
 extern NSData *SRRandomData(NSUInteger length);
+extern void SRRandomBytes(void *bytes, size_t length);
 
 NS_ASSUME_NONNULL_END
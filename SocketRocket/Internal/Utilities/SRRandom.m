@@ -20,11 +20,16 @@ NSData *SRRandomData(NSUInteger length)
         [NSException raise:NSInternalInconsistencyException format:@"Failed to allocate random data"];
     }
     
-    int result = SecRandomCopyBytes(kSecRandomDefault, data.length, data.mutableBytes);
+    SRRandomBytes(data.mutableBytes, data.length);
+    return data;
+}
+
+void SRRandomBytes(void *bytes, size_t length)
+{
+    int result = SecRandomCopyBytes(kSecRandomDefault, length, bytes);
     if (result != errSecSuccess) {
         [NSException raise:NSInternalInconsistencyException format:@"Failed to generate random bytes with OSStatus: %d", result];
     }
-    return data;
 }
 
 NS_ASSUME_NONNULL_END
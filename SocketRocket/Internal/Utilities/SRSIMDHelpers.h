@@ -17,3 +17,13 @@
  @param maskKey The mask to XOR with MUST be of length sizeof(uint32_t).
  */
 void SRMaskBytesSIMD(uint8_t *bytes, size_t length, uint8_t *maskKey);
+
+/**
+ Copy bytes into a destination buffer, masking them using XOR via SIMD in the same pass.
+
+ @param destination The buffer to write masked bytes to. MUST NOT overlap with `source`.
+ @param source      The bytes to mask.
+ @param length      The number of bytes to copy and mask.
+ @param maskKey The mask to XOR with MUST be of length sizeof(uint32_t).
+ */
+void SRMaskCopyBytesSIMD(uint8_t *destination, const uint8_t *source, size_t length, uint8_t *maskKey);
@@ -17,8 +17,16 @@ static void SRMaskBytesManual(uint8_t *bytes, size_t length, uint8_t *maskKey) {
     }
 }
 
+static void SRMaskCopyBytesManual(uint8_t *destination, const uint8_t *source, size_t length, uint8_t *maskKey) {
+    for (size_t i = 0; i < length; i++) {
+        destination[i] = source[i] ^ maskKey[i % sizeof(uint32_t)];
+    }
+}
+
 /**
- Right-shift the elements of a vector, circularly.
+ Left-shift the elements of a vector, circularly.
+ Element `i` of the result is element `i + by` of the input, so a mask pattern that starts `by` bytes before
+ the vector lines up with the bytes covered by the vector.
 
  @param vector The vector to circular shift.
  @param by     The number of elements to shift by.
@@ -32,8 +40,8 @@ static uint8x32_t SRShiftVector(uint8x32_t vector, size_t by) {
     uint8_t *vectorPointer = (uint8_t *)&vector;
     uint8_t *vectorCopyPointer = (uint8_t *)&vectorCopy;
 
-    memmove(vectorPointer + by, vectorPointer, sizeof(vector) - by);
-    memcpy(vectorPointer, vectorCopyPointer + (sizeof(vector) - by), by);
+    memcpy(vectorPointer, vectorCopyPointer + by, sizeof(vector) - by);
+    memcpy(vectorPointer + (sizeof(vector) - by), vectorCopyPointer, by);
 
     return vector;
 }
@@ -71,3 +79,38 @@ void SRMaskBytesSIMD(uint8_t *bytes, size_t length, uint8_t *maskKey) {
     // Use the shifted mask for the final manual part.
     SRMaskBytesManual(bytes + manualStartOffset, manualLength, (uint8_t *) &maskVector);
 }
+
+void SRMaskCopyBytesSIMD(uint8_t *destination, const uint8_t *source, size_t length, uint8_t *maskKey) {
+    // Align on the destination, since source regions can start anywhere.
+    size_t alignmentBytes = _Alignof(uint8x32_t) - ((uintptr_t)destination % _Alignof(uint8x32_t));
+    if (alignmentBytes == _Alignof(uint8x32_t)) {
+        alignmentBytes = 0;
+    }
+
+    if (alignmentBytes > length || (length - alignmentBytes) < sizeof(uint8x32_t)) {
+        SRMaskCopyBytesManual(destination, source, length, maskKey);
+        return;
+    }
+
+    size_t vectorLength = (length - alignmentBytes) / sizeof(uint8x32_t);
+    size_t manualStartOffset = alignmentBytes + (vectorLength * sizeof(uint8x32_t));
+    size_t manualLength = length - manualStartOffset;
+
+    uint8x32_t *vector = (uint8x32_t *)(destination + alignmentBytes);
+    const uint8_t *sourceVector = source + alignmentBytes;
+    uint8x32_t maskVector = { };
+
+    memset_pattern4(&maskVector, maskKey, sizeof(uint8x32_t));
+    maskVector = SRShiftVector(maskVector, alignmentBytes);
+
+    SRMaskCopyBytesManual(destination, source, alignmentBytes, maskKey);
+
+    for (size_t vectorIndex = 0; vectorIndex < vectorLength; vectorIndex++) {
+        uint8x32_t sourceValue;
+        memcpy(&sourceValue, sourceVector + (vectorIndex * sizeof(uint8x32_t)), sizeof(uint8x32_t));
+        vector[vectorIndex] = sourceValue ^ maskVector;
+    }
+
+    // Use the shifted mask for the final manual part.
+    SRMaskCopyBytesManual(destination + manualStartOffset, source + manualStartOffset, manualLength, (uint8_t *) &maskVector);
+}
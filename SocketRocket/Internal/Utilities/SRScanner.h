@@ -0,0 +1,17 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Returns the length of the prefix of `data` that ends with the first occurrence of `bytes`, or `0` if there is none.
+extern size_t SRScanUntilBytes(NSData *data, const void *bytes, size_t length);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRScanner.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+size_t SRScanUntilBytes(NSData *data, const void *bytes, size_t length)
+{
+    size_t found_size = 0;
+    size_t match_count = 0;
+
+    size_t size = data.length;
+    const unsigned char *buffer = data.bytes;
+    for (size_t i = 0; i < size; i++ ) {
+        if (buffer[i] == ((const unsigned char *)bytes)[match_count]) {
+            match_count += 1;
+            if (match_count == length) {
+                found_size = i + 1;
+                break;
+            }
+        } else {
+            match_count = 0;
+        }
+    }
+    return found_size;
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <pthread.h>
+#import <stdatomic.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef struct SRThreadBufferList SRThreadBufferList;
+
+// Every per-thread buffer starts with this header, followed by the fields of its list.
+typedef struct SRThreadBuffer {
+    // Set once when the buffer is published, buffers are never removed from the list.
+    struct SRThreadBuffer *_Nullable next;
+    SRThreadBufferList *list;
+    // Cleared when the owning thread exits, after which another thread can claim the buffer.
+    atomic_bool inUse;
+} SRThreadBuffer;
+
+typedef void (*SRThreadBufferHandler)(SRThreadBuffer *buffer);
+
+// Lock-free list of buffers, each owned by a single thread at a time.
+// Buffers of exited threads are reused by new threads instead of being freed,
+// so the list can be walked without a lock and holds as many buffers as there were live threads at once.
+struct SRThreadBufferList {
+    size_t bufferSize;
+    // Called on the claiming thread before it uses a new or reused buffer.
+    SRThreadBufferHandler _Nullable claimHandler;
+    // Called on the exiting thread, before the buffer can be claimed by another one.
+    SRThreadBufferHandler _Nullable releaseHandler;
+
+    _Atomic(SRThreadBuffer *) buffers;
+    pthread_key_t key;
+    dispatch_once_t keyOnceToken;
+};
+
+#define SRThreadBufferListInitializer(type, claim, release) { .bufferSize = sizeof(type), .claimHandler = (claim), .releaseHandler = (release) }
+
+// Returns the buffer owned by the current thread, claiming a free one or allocating a new one the first time.
+// Never takes a lock. Returns `NULL` only if a new buffer couldn't be allocated.
+extern SRThreadBuffer *_Nullable SRThreadBufferListCurrentBuffer(SRThreadBufferList *list);
+
+// First buffer of the list, including free ones, follow `next` for the others.
+extern SRThreadBuffer *_Nullable SRThreadBufferListFirstBuffer(SRThreadBufferList *list);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRThreadBuffer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Destructor of the thread specific key, runs on the exiting thread.
+static void SRThreadBufferRelease(void *value)
+{
+    SRThreadBuffer *buffer = value;
+    if (buffer->list->releaseHandler) {
+        buffer->list->releaseHandler(buffer);
+    }
+    // Publishes everything the exiting thread wrote to the next owner.
+    atomic_store_explicit(&buffer->inUse, false, memory_order_release);
+}
+
+static SRThreadBuffer *_Nullable SRThreadBufferClaim(SRThreadBufferList *list)
+{
+    for (SRThreadBuffer *buffer = SRThreadBufferListFirstBuffer(list); buffer; buffer = buffer->next) {
+        bool inUse = false;
+        if (!atomic_load_explicit(&buffer->inUse, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&buffer->inUse, &inUse, true, memory_order_acquire, memory_order_relaxed)) {
+            return buffer;
+        }
+    }
+
+    SRThreadBuffer *buffer = calloc(1, list->bufferSize);
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->list = list;
+    atomic_init(&buffer->inUse, true);
+
+    SRThreadBuffer *next = atomic_load_explicit(&list->buffers, memory_order_relaxed);
+    do {
+        buffer->next = next;
+    } while (!atomic_compare_exchange_weak_explicit(&list->buffers, &next, buffer, memory_order_release, memory_order_relaxed));
+    return buffer;
+}
+
+SRThreadBuffer *_Nullable SRThreadBufferListCurrentBuffer(SRThreadBufferList *list)
+{
+    dispatch_once(&list->keyOnceToken, ^{
+        pthread_key_create(&list->key, SRThreadBufferRelease);
+    });
+
+    SRThreadBuffer *buffer = pthread_getspecific(list->key);
+    if (buffer) {
+        return buffer;
+    }
+
+    buffer = SRThreadBufferClaim(list);
+    if (!buffer) {
+        return NULL;
+    }
+    if (list->claimHandler) {
+        list->claimHandler(buffer);
+    }
+    pthread_setspecific(list->key, buffer);
+    return buffer;
+}
+
+SRThreadBuffer *_Nullable SRThreadBufferListFirstBuffer(SRThreadBufferList *list)
+{
+    return atomic_load_explicit(&list->buffers, memory_order_acquire);
+}
+
+NS_ASSUME_NONNULL_END
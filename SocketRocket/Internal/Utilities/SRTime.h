@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Returns current time in nanoseconds from a monotonic clock that doesn't advance while the system is asleep.
+// Same clock as `clock_gettime_nsec_np(CLOCK_UPTIME_RAW)`.
+extern uint64_t SRMonotonicTimeNanoseconds(void);
+
+NS_ASSUME_NONNULL_END
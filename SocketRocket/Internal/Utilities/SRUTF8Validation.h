@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Returns the length of the longest prefix of `data` that is valid UTF-8, leaving out a code point that is cut off at the end,
+// or `-1` if `data` contains invalid UTF-8.
+extern int32_t SRValidUTF8Length(NSData *data);
+
+NS_ASSUME_NONNULL_END
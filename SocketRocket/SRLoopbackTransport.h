@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A `SRLoopbackTransport` connects a `SRWebSocket` to a minimal WebSocket server running in the same process,
+ passing bytes through memory instead of a socket. Assign it to `-[SRWebSocket loopbackTransport]` before calling `open`.
+
+ The link between the two ends can be shaped with `bandwidth`, `latency` and `chunkLength`, so tests and benchmarks
+ see the same deterministic delivery on every run, and measure the cost of the library without the network stack.
+
+ By default the server echoes every message back with the same type. It answers pings, and echoes the close frame before closing.
+ A transport carries a single connection. This class is thread-safe, but the link has to be configured before the socket opens.
+ */
+@interface SRLoopbackTransport : NSObject
+
+/**
+ Bytes per second the link transmits in each direction, `0` for unlimited. Default: `0`.
+ */
+@property (atomic, assign) double bandwidth;
+
+/**
+ Seconds it takes bytes to arrive at the other end once transmitted. Default: `0`.
+ */
+@property (atomic, assign) NSTimeInterval latency;
+
+/**
+ Largest number of bytes a single read returns, mimicking segments of a network connection, `0` for unlimited. Default: `0`.
+ Every write is split into chunks of this length, each of which arrives on its own.
+ */
+@property (atomic, assign) NSUInteger chunkLength;
+
+/**
+ Number of bytes each direction holds before writing blocks, like a socket buffer. Default: 1 MB.
+ */
+@property (atomic, assign) NSUInteger bufferLength;
+
+/**
+ Called on a private serial queue with every message the server receives, as `NSString` for text and `NSData` for binary messages.
+ When set, messages are no longer echoed, use `sendString:` and `sendData:` to reply. Default: `nil`.
+ */
+@property (nullable, atomic, copy) void (^messageHandler)(id message);
+
+/**
+ Number of messages the server received so far.
+ */
+@property (atomic, assign, readonly) NSUInteger receivedMessageCount;
+
+/**
+ Sends a text message from the server. Messages sent before the connection opened follow the handshake response.
+
+ @param string Text of the message.
+ */
+- (void)sendString:(NSString *)string;
+
+/**
+ Sends a binary message from the server. Messages sent before the connection opened follow the handshake response.
+
+ @param data Payload of the message.
+ */
+- (void)sendData:(NSData *)data;
+
+/**
+ Starts the closing handshake from the server. The connection is closed once the socket replied.
+
+ @param code   Close status code.
+ @param reason Optional reason of the close.
+ */
+- (void)closeWithCode:(NSInteger)code reason:(nullable NSString *)reason;
+
+@end
+
+NS_ASSUME_NONNULL_END
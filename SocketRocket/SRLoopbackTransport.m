@@ -0,0 +1,377 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRLoopbackTransport+Private.h"
+
+#import "SRConstants.h"
+#import "SRHash.h"
+#import "SRLog.h"
+#import "SRLoopbackPipe.h"
+#import "SRLoopbackStream.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const NSUInteger SRLoopbackDefaultBufferLength = 1024 * 1024;
+
+// Not part of `SROpCode`, since the socket tracks continuations separately.
+static const uint8_t SRLoopbackOpCodeContinuation = 0x0;
+
+@interface SRLoopbackTransport ()
+
+@property (atomic, assign, readwrite) NSUInteger receivedMessageCount;
+
+@end
+
+@implementation SRLoopbackTransport {
+    dispatch_queue_t _queue;
+
+    // Everything below is accessed only on `_queue`.
+    SRLoopbackPipe *_clientToServerPipe;
+    SRLoopbackPipe *_serverToClientPipe;
+
+    NSMutableData *_inputBuffer;
+    NSUInteger _inputOffset;
+    NSMutableData *_outputBuffer;
+    NSUInteger _outputOffset;
+    // Frames sent before the handshake finished, they follow the response.
+    NSMutableData *_pendingFrames;
+
+    BOOL _opened;
+    BOOL _sentClose;
+    BOOL _closeWhenFlushed;
+    BOOL _outputClosed;
+
+    uint8_t _messageOpCode;
+    NSMutableData *_Nullable _messageData;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _bufferLength = SRLoopbackDefaultBufferLength;
+    _queue = dispatch_queue_create("com.facebook.socketrocket.loopback", DISPATCH_QUEUE_SERIAL);
+
+    _inputBuffer = [NSMutableData data];
+    _outputBuffer = [NSMutableData data];
+    _pendingFrames = [NSMutableData data];
+
+    return self;
+}
+
+- (void)openClientInputStream:(NSInputStream *_Nullable *_Nonnull)inputStream
+                 outputStream:(NSOutputStream *_Nullable *_Nonnull)outputStream
+{
+    __block SRLoopbackPipe *clientToServerPipe = nil;
+    __block SRLoopbackPipe *serverToClientPipe = nil;
+    dispatch_sync(_queue, ^{
+        NSAssert(!self->_clientToServerPipe, @"Cannot open a SRLoopbackTransport more than once.");
+
+        self->_clientToServerPipe = [[SRLoopbackPipe alloc] initWithBandwidth:self.bandwidth
+                                                                      latency:self.latency
+                                                                  chunkLength:self.chunkLength
+                                                                     capacity:self.bufferLength];
+        self->_serverToClientPipe = [[SRLoopbackPipe alloc] initWithBandwidth:self.bandwidth
+                                                                      latency:self.latency
+                                                                  chunkLength:self.chunkLength
+                                                                     capacity:self.bufferLength];
+
+        __weak typeof(self) wself = self;
+        dispatch_queue_t queue = self->_queue;
+        self->_clientToServerPipe.readableHandler = ^{
+            dispatch_async(queue, ^{
+                [wself _readInput];
+            });
+        };
+        self->_serverToClientPipe.writableHandler = ^{
+            dispatch_async(queue, ^{
+                [wself _flushOutput];
+            });
+        };
+
+        clientToServerPipe = self->_clientToServerPipe;
+        serverToClientPipe = self->_serverToClientPipe;
+    });
+
+    NSInputStream *clientInputStream = [[SRLoopbackInputStream alloc] initWithPipe:serverToClientPipe];
+    NSOutputStream *clientOutputStream = [[SRLoopbackOutputStream alloc] initWithPipe:clientToServerPipe];
+    [clientInputStream open];
+    [clientOutputStream open];
+
+    *inputStream = clientInputStream;
+    *outputStream = clientOutputStream;
+}
+
+///--------------------------------------
+#pragma mark - Sending
+///--------------------------------------
+
+- (void)sendString:(NSString *)string
+{
+    NSData *payload = [string dataUsingEncoding:NSUTF8StringEncoding];
+    dispatch_async(_queue, ^{
+        [self _writeFrameWithOpCode:SROpCodeTextFrame payload:payload];
+    });
+}
+
+- (void)sendData:(NSData *)data
+{
+    NSData *payload = [data copy];
+    dispatch_async(_queue, ^{
+        [self _writeFrameWithOpCode:SROpCodeBinaryFrame payload:payload];
+    });
+}
+
+- (void)closeWithCode:(NSInteger)code reason:(nullable NSString *)reason
+{
+    NSMutableData *payload = [NSMutableData dataWithLength:sizeof(uint16_t)];
+    ((uint16_t *)payload.mutableBytes)[0] = CFSwapInt16HostToBig((uint16_t)code);
+    if (reason) {
+        [payload appendData:[reason dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    dispatch_async(_queue, ^{
+        [self _writeFrameWithOpCode:SROpCodeConnectionClose payload:payload];
+    });
+}
+
+- (void)_writeFrameWithOpCode:(uint8_t)opCode payload:(NSData *)payload
+{
+    if (_sentClose) {
+        return;
+    }
+    if (opCode == SROpCodeConnectionClose) {
+        _sentClose = YES;
+    }
+
+    // Frames from the server are never masked.
+    uint8_t header[10];
+    size_t headerLength = 2;
+    uint64_t payloadLength = payload.length;
+    header[0] = 0x80 | opCode;
+    if (payloadLength < 126) {
+        header[1] = (uint8_t)payloadLength;
+    } else if (payloadLength <= UINT16_MAX) {
+        header[1] = 126;
+        header[2] = (uint8_t)(payloadLength >> 8);
+        header[3] = (uint8_t)payloadLength;
+        headerLength = 4;
+    } else {
+        header[1] = 127;
+        for (size_t i = 0; i < 8; i++) {
+            header[2 + i] = (uint8_t)(payloadLength >> (56 - 8 * i));
+        }
+        headerLength = 10;
+    }
+
+    NSMutableData *frames = (_opened ? _outputBuffer : _pendingFrames);
+    [frames appendBytes:header length:headerLength];
+    [frames appendData:payload];
+    if (_opened) {
+        [self _flushOutput];
+    }
+}
+
+- (void)_flushOutput
+{
+    while (!_outputClosed && _outputOffset < _outputBuffer.length) {
+        NSInteger bytesWritten = [_serverToClientPipe write:(const uint8_t *)_outputBuffer.bytes + _outputOffset
+                                                  maxLength:_outputBuffer.length - _outputOffset];
+        if (bytesWritten == -1) {
+            // The socket closed its end, nobody is left to read the rest.
+            _outputClosed = YES;
+        } else if (bytesWritten == 0) {
+            return;
+        }
+        _outputOffset += MAX(bytesWritten, 0);
+    }
+
+    _outputBuffer.length = 0;
+    _outputOffset = 0;
+    if (_closeWhenFlushed && !_outputClosed) {
+        _outputClosed = YES;
+        [_serverToClientPipe closeWriting];
+    }
+}
+
+- (void)_closeOutputWhenFlushed
+{
+    _closeWhenFlushed = YES;
+    [self _flushOutput];
+}
+
+///--------------------------------------
+#pragma mark - Receiving
+///--------------------------------------
+
+- (void)_readInput
+{
+    uint8_t buffer[SRDefaultBufferSize()];
+    NSInteger bytesRead = 0;
+    while ((bytesRead = [_clientToServerPipe read:buffer maxLength:SRDefaultBufferSize()]) > 0) {
+        [_inputBuffer appendBytes:buffer length:bytesRead];
+    }
+
+    if (!_closeWhenFlushed && !_outputClosed) {
+        if (_opened || [self _readHandshake]) {
+            while ([self _readFrame]) {}
+        }
+    }
+    if (_inputOffset > 0) {
+        [_inputBuffer replaceBytesInRange:NSMakeRange(0, _inputOffset) withBytes:NULL length:0];
+        _inputOffset = 0;
+    }
+
+    if (_clientToServerPipe.atEnd) {
+        [self _closeOutputWhenFlushed];
+    }
+}
+
+- (BOOL)_readHandshake
+{
+    NSData *terminator = [NSData dataWithBytes:"\r\n\r\n" length:4];
+    NSRange terminatorRange = [_inputBuffer rangeOfData:terminator options:0 range:NSMakeRange(0, _inputBuffer.length)];
+    if (terminatorRange.location == NSNotFound) {
+        return NO;
+    }
+    _inputOffset = NSMaxRange(terminatorRange);
+
+    CFHTTPMessageRef request = CFHTTPMessageCreateEmpty(NULL, YES);
+    CFHTTPMessageAppendBytes(request, _inputBuffer.bytes, _inputOffset);
+    NSString *key = CFBridgingRelease(CFHTTPMessageCopyHeaderFieldValue(request, CFSTR("Sec-WebSocket-Key")));
+    NSString *protocols = CFBridgingRelease(CFHTTPMessageCopyHeaderFieldValue(request, CFSTR("Sec-WebSocket-Protocol")));
+    CFRelease(request);
+
+    if (!key) {
+        SRWarningLog(@"Loopback server received an upgrade request without Sec-WebSocket-Key.");
+        [_outputBuffer appendData:[@"HTTP/1.1 400 Bad Request\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+        [self _closeOutputWhenFlushed];
+        return NO;
+    }
+
+    NSString *accept = SRBase64EncodedStringFromData(SRSHA1HashFromString([key stringByAppendingString:SRWebSocketAppendToSecKeyString]));
+    NSMutableString *response = [NSMutableString stringWithFormat:@"HTTP/1.1 101 Switching Protocols\r\n"
+                                                                  "Upgrade: websocket\r\n"
+                                                                  "Connection: Upgrade\r\n"
+                                                                  "Sec-WebSocket-Accept: %@\r\n", accept];
+    NSString *protocol = [[protocols componentsSeparatedByString:@","].firstObject
+                          stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    if (protocol.length > 0) {
+        [response appendFormat:@"Sec-WebSocket-Protocol: %@\r\n", protocol];
+    }
+    [response appendString:@"\r\n"];
+
+    [_outputBuffer appendData:[response dataUsingEncoding:NSUTF8StringEncoding]];
+    [_outputBuffer appendData:_pendingFrames];
+    _pendingFrames.length = 0;
+    _opened = YES;
+    [self _flushOutput];
+    return YES;
+}
+
+- (BOOL)_readFrame
+{
+    const uint8_t *bytes = (const uint8_t *)_inputBuffer.bytes + _inputOffset;
+    NSUInteger availableLength = _inputBuffer.length - _inputOffset;
+    if (availableLength < 2) {
+        return NO;
+    }
+
+    BOOL fin = (bytes[0] & 0x80) != 0;
+    uint8_t opCode = bytes[0] & 0x0F;
+    BOOL masked = (bytes[1] & 0x80) != 0;
+    uint64_t payloadLength = bytes[1] & 0x7F;
+    NSUInteger headerLength = 2;
+    if (payloadLength == 126) {
+        if (availableLength < 4) {
+            return NO;
+        }
+        payloadLength = ((uint64_t)bytes[2] << 8) | bytes[3];
+        headerLength = 4;
+    } else if (payloadLength == 127) {
+        if (availableLength < 10) {
+            return NO;
+        }
+        payloadLength = 0;
+        for (size_t i = 0; i < 8; i++) {
+            payloadLength = (payloadLength << 8) | bytes[2 + i];
+        }
+        headerLength = 10;
+    }
+    const uint8_t *maskKey = bytes + headerLength;
+    if (masked) {
+        headerLength += 4;
+    }
+    if (availableLength < headerLength || availableLength - headerLength < payloadLength) {
+        return NO;
+    }
+
+    NSMutableData *payload = [NSMutableData dataWithBytes:bytes + headerLength length:(NSUInteger)payloadLength];
+    if (masked) {
+        uint8_t *payloadBytes = payload.mutableBytes;
+        for (NSUInteger i = 0; i < payload.length; i++) {
+            payloadBytes[i] ^= maskKey[i % 4];
+        }
+    }
+    _inputOffset += headerLength + (NSUInteger)payloadLength;
+
+    [self _handleFrameWithOpCode:opCode fin:fin payload:payload];
+    return (!_closeWhenFlushed && !_outputClosed);
+}
+
+- (void)_handleFrameWithOpCode:(uint8_t)opCode fin:(BOOL)fin payload:(NSMutableData *)payload
+{
+    switch (opCode) {
+        case SROpCodeTextFrame:
+        case SROpCodeBinaryFrame:
+            _messageOpCode = opCode;
+            _messageData = payload;
+            break;
+        case SRLoopbackOpCodeContinuation:
+            [_messageData appendData:payload];
+            break;
+        case SROpCodePing:
+            [self _writeFrameWithOpCode:SROpCodePong payload:payload];
+            return;
+        case SROpCodeConnectionClose:
+            // Echoes the status code, unless the server started closing.
+            [self _writeFrameWithOpCode:SROpCodeConnectionClose payload:payload];
+            [self _closeOutputWhenFlushed];
+            return;
+        default:
+            return;
+    }
+
+    if (fin && _messageData) {
+        NSData *messageData = _messageData;
+        _messageData = nil;
+        [self _didReceiveMessageWithOpCode:_messageOpCode data:messageData];
+    }
+}
+
+- (void)_didReceiveMessageWithOpCode:(uint8_t)opCode data:(NSData *)data
+{
+    self.receivedMessageCount += 1;
+
+    void (^messageHandler)(id message) = self.messageHandler;
+    if (!messageHandler) {
+        [self _writeFrameWithOpCode:opCode payload:data];
+        return;
+    }
+
+    if (opCode == SROpCodeTextFrame) {
+        messageHandler([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"");
+    } else {
+        messageHandler(data);
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Type of a received message, with the values of the corresponding web socket opcodes.
+ */
+typedef NS_ENUM(uint8_t, SRMessageOpCode) {
+    SRMessageOpCodeText = 0x1,
+    SRMessageOpCodeBinary = 0x2,
+};
+
+/**
+ A `SRMessage` is a received message together with metadata about how and when it arrived,
+ reported via `-[SRWebSocketDelegate webSocket:didReceiveMessageWithMetadata:]`.
+
+ All times are in nanoseconds from the monotonic clock used by `clock_gettime_nsec_np(CLOCK_UPTIME_RAW)`,
+ same as `SRSendTimestamps`. This class is immutable and thread-safe.
+ */
+@interface SRMessage : NSObject
+
+/**
+ Payload of the message. Either an `NSString` or `NSData`, following `webSocketShouldConvertTextFrameToString:` for text messages.
+ */
+@property (nonatomic, strong, readonly) id payload;
+
+/**
+ Opcode of the first frame of the message.
+ */
+@property (nonatomic, assign, readonly) SRMessageOpCode opCode;
+
+/**
+ Length of the payload in bytes, as received over the wire.
+ */
+@property (nonatomic, assign, readonly) NSUInteger payloadLength;
+
+/**
+ Number of frames the message was fragmented into. `1` for messages that were not fragmented.
+ */
+@property (nonatomic, assign, readonly) NSUInteger frameCount;
+
+/**
+ Whether the message was compressed by a negotiated extension. Always `NO`, since no extensions are negotiated yet.
+ */
+@property (nonatomic, assign, readonly, getter=isCompressed) BOOL compressed;
+
+/**
+ Time when the socket read the bytes that contained the first frame header of the message.
+ */
+@property (nonatomic, assign, readonly) uint64_t firstByteTime;
+
+/**
+ Time when the socket read the bytes that completed the message.
+ */
+@property (nonatomic, assign, readonly) uint64_t lastByteTime;
+
+/**
+ Time when the message was queued to the delegate.
+ */
+@property (nonatomic, assign, readonly) uint64_t queuedTime;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRMessage.h"
+#import "SRMessage+Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRMessage
+
+- (instancetype)initWithPayload:(id)payload
+                         opCode:(SRMessageOpCode)opCode
+                  payloadLength:(NSUInteger)payloadLength
+                     frameCount:(NSUInteger)frameCount
+                     compressed:(BOOL)compressed
+                  firstByteTime:(uint64_t)firstByteTime
+                   lastByteTime:(uint64_t)lastByteTime
+                     queuedTime:(uint64_t)queuedTime
+{
+    self = [super init];
+    if (!self) return self;
+
+    _payload = payload;
+    _opCode = opCode;
+    _payloadLength = payloadLength;
+    _frameCount = frameCount;
+    _compressed = compressed;
+    _firstByteTime = firstByteTime;
+    _lastByteTime = lastByteTime;
+    _queuedTime = queuedTime;
+
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p, opCode: %d, payloadLength: %lu, frameCount: %lu>",
+            NSStringFromClass([self class]), self, self.opCode, (unsigned long)self.payloadLength, (unsigned long)self.frameCount];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A `SRMessageBuilder` lets you write the payload of an outgoing message directly into the frame buffer,
+ avoiding the intermediate `NSData` and the copy into the frame that `sendData:error:` does.
+
+ Builders are created with `-[SRWebSocket messageBuilderWithCapacity:]` and sent with `-[SRWebSocket sendMessageFromBuilder:error:]`.
+ A builder can be sent only once. This class is not thread-safe.
+ */
+@interface SRMessageBuilder : NSObject
+
+/**
+ Whether the message is sent as a text frame. Default: `NO`.
+ If `YES` - the payload must be valid UTF-8, since it is not validated before sending.
+ */
+@property (nonatomic, assign, getter=isText) BOOL text;
+
+/**
+ Length of the payload in bytes. Setting a bigger length grows the payload, leaving the new bytes undefined.
+ */
+@property (nonatomic, assign) NSUInteger length;
+
+/**
+ Pointer to the start of the payload. Changing `length` or appending bytes may invalidate a previously returned pointer.
+ `NULL` if the buffer for the requested length couldn't be allocated. Such a builder ignores further writes,
+ and sending it fails with `SRStatusCodeMessageTooBig`.
+ */
+@property (nullable, nonatomic, assign, readonly) void *mutableBytes NS_RETURNS_INNER_POINTER;
+
+/**
+ Appends bytes to the end of the payload.
+
+ @param bytes  Bytes to append.
+ @param length Number of bytes to append.
+ */
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ Unavailable initializer. Please use `-[SRWebSocket messageBuilderWithCapacity:]`.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Unavailable constructor. Please use `-[SRWebSocket messageBuilderWithCapacity:]`.
+ */
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRMessageBuilder.h"
+#import "SRMessageBuilder+Private.h"
+
+#import "SRFrameBufferPool.h"
+#import "SRFrameHeader.h"
+#import "SRSIMDHelpers.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRMessageBuilder {
+    SRFrameBufferPool *_bufferPool;
+
+    // Payload starts at `SRFrameHeaderMaxLength`, leaving room for the largest possible header in front of it.
+    NSMutableData *_buffer;
+}
+
+@synthesize length = _length;
+
+- (instancetype)initWithBufferPool:(SRFrameBufferPool *)bufferPool capacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (!self) return self;
+
+    _bufferPool = bufferPool;
+    // Without a buffer `mutableBytes` is `NULL`, writes are ignored and sending the builder fails.
+    if (capacity <= NSUIntegerMax - SRFrameHeaderMaxLength) {
+        _buffer = [bufferPool bufferWithMinimumLength:SRFrameHeaderMaxLength + capacity];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    // Builder was abandoned without sending.
+    if (_buffer) {
+        [_bufferPool returnBuffer:_buffer];
+    }
+}
+
+///--------------------------------------
+#pragma mark - Accessors
+///--------------------------------------
+
+- (void)setLength:(NSUInteger)length
+{
+    NSAssert(!_finished, @"Cannot modify SRMessageBuilder after it was sent.");
+
+    if (!_buffer || length > NSUIntegerMax - SRFrameHeaderMaxLength) {
+        [self _fail];
+        return;
+    }
+    NSUInteger bufferLength = SRFrameHeaderMaxLength + length;
+    if (_buffer.length < bufferLength) {
+        _buffer.length = bufferLength;
+    }
+    _length = length;
+}
+
+- (nullable void *)mutableBytes
+{
+    if (!_buffer) {
+        return NULL;
+    }
+    return (uint8_t *)_buffer.mutableBytes + SRFrameHeaderMaxLength;
+}
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length
+{
+    NSUInteger offset = _length;
+    if (length > NSUIntegerMax - offset) {
+        [self _fail];
+    } else {
+        self.length = offset + length;
+    }
+    if (!_buffer) {
+        return;
+    }
+    memcpy((uint8_t *)self.mutableBytes + offset, bytes, length);
+}
+
+///--------------------------------------
+#pragma mark - Frame
+///--------------------------------------
+
+// Drops the buffer, the builder ignores writes from now on and sending it fails.
+- (void)_fail
+{
+    if (_buffer) {
+        [_bufferPool returnBuffer:_buffer];
+        _buffer = nil;
+    }
+}
+
+- (nullable NSData *)finishFrameWithOpCode:(SROpCode)opCode
+{
+    NSAssert(!_finished, @"Cannot send SRMessageBuilder more than once.");
+    _finished = YES;
+    if (!_buffer) {
+        return nil;
+    }
+
+    uint8_t *payload = self.mutableBytes;
+    size_t headerLength = SRFrameHeaderLength(_length);
+    uint8_t *frame = payload - headerLength;
+
+    SRFrameHeaderWrite(frame, opCode, _length);
+    SRMaskBytesSIMD(payload, _length, payload - sizeof(uint32_t));
+
+    NSMutableData *buffer = _buffer;
+    SRFrameBufferPool *bufferPool = _bufferPool;
+    _buffer = nil;
+
+    return [[NSData alloc] initWithBytesNoCopy:frame length:headerLength + _length deallocator:^(void *bytes, NSUInteger length) {
+        [bufferPool returnBuffer:buffer];
+    }];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -11,6 +11,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import <SocketRocket/SRWebSocketMetrics.h>
+
 NS_ASSUME_NONNULL_BEGIN
 
 typedef NS_ENUM(NSInteger, SRReadyState) {
@@ -44,8 +46,72 @@ typedef NS_ENUM(NSInteger, SRStatusCode) {
     // 4000-4999: Available for use by applications.
 };
 
+/**
+ Timestamps describing how an outgoing message moved through the socket.
+
+ All values are in nanoseconds from the monotonic clock used by `clock_gettime_nsec_np(CLOCK_UPTIME_RAW)`.
+ A value of `0` means that the message never reached the corresponding stage.
+ */
+typedef struct {
+    /** Time when the message was passed to one of the `send` methods. */
+    uint64_t enqueueTime;
+    /** Time when the first byte of the frame was written to the output stream. */
+    uint64_t firstByteTime;
+    /** Time when the last byte of the frame was written to the output stream. */
+    uint64_t lastByteTime;
+} SRSendTimestamps;
+
+/**
+ Block that is called once an outgoing message was fully written to the output stream, or failed to be written.
+
+ @param timestamps Timestamps of the message lifetime.
+ @param error      `nil` if the message was fully written, otherwise - an error describing why it wasn't.
+ */
+typedef void(^SRSendCompletionHandler)(SRSendTimestamps timestamps, NSError *_Nullable error);
+
+/**
+ Block that is called with messages requested by `-[SRWebSocket receiveMessagesWithMaximumCount:completionQueue:completion:]`.
+
+ @param messages Received messages, in order. Each one is either a `String` for a text frame or `NSData` for a binary frame.
+ Empty only if `error` is set.
+ @param error    `nil` if messages were received, otherwise - an error describing why no more messages will be received.
+ */
+typedef void(^SRReceiveCompletionHandler)(NSArray *messages, NSError *_Nullable error);
+
+/**
+ Block that returns the ordering key of a received message, an `NSString` for text messages and `NSData` for data messages.
+ Messages with equal keys (per `isEqual:` and `hash`) are reported in order. A `nil` key means the message isn't ordered with anything.
+ */
+typedef id _Nullable (^SRMessageOrderingKeyBlock)(id message);
+
+/**
+ Block that decodes a received message into an app object, called on a background concurrent queue.
+
+ @param message Received message. An `NSString` for text messages, unless `decodesTextMessagesAsData` is enabled,
+ and `NSData` for data messages.
+
+ @return Decoded object to report via `webSocket:didReceiveDecodedMessage:`, or `nil` to drop the message.
+ */
+typedef id _Nullable (^SRMessageDecoderBlock)(id message);
+
+typedef NS_ENUM(NSInteger, SRLogLevel) {
+    SRLogLevelNone = 0,
+    SRLogLevelError,
+    SRLogLevelWarning,
+    SRLogLevelInfo,
+    SRLogLevelDebug,
+};
+
+/**
+ Block that receives log messages of SocketRocket, called serially on a background queue.
+ */
+typedef void(^SRLogSink)(SRLogLevel level, NSString *message);
+
 @class SRWebSocket;
 @class SRSecurityPolicy;
+@class SRMessage;
+@class SRMessageBuilder;
+@class SRLoopbackTransport;
 
 /**
  Error domain used for errors reported by SRWebSocket.
@@ -89,6 +155,79 @@ extern NSString *const SRHTTPResponseErrorKey;
  */
 @property (nullable, nonatomic, strong) NSOperationQueue *delegateOperationQueue;
 
+/**
+ Whether delegate methods are called inline on the internal serial queue of the socket,
+ skipping the hop to `delegateDispatchQueue` or `delegateOperationQueue`. Default: `NO`.
+
+ This mode is meant for delegates that are already thread-safe and need the lowest latency. When enabled:
+ - Delegate methods are called one at a time, in order, on a private queue. Never on the main queue.
+ - The socket doesn't read or write while a delegate method runs, so it must return quickly.
+ - Sending and closing from a delegate method is safe. These calls are asynchronous and take effect after it returns.
+ - Delegate methods must not synchronously wait for anything that needs this socket to make progress, that deadlocks.
+ */
+@property (nonatomic, assign) BOOL callsDelegateInline;
+
+/**
+ Maximum number of messages reported in a single call to `webSocket:didReceiveMessages:`. Default: `256`.
+ */
+@property (nonatomic, assign) NSUInteger maximumMessageBatchCount;
+
+/**
+ Maximum total length in bytes of messages reported in a single call to `webSocket:didReceiveMessages:`.
+ A single message that is longer than this is still delivered, in a batch of its own. Default: `1 MB`.
+ */
+@property (nonatomic, assign) NSUInteger maximumMessageBatchLength;
+
+/**
+ Block that is called on the internal serial queue of the socket with every received message, to get its ordering key.
+ If set, messages are reported through `concurrentDeliveryWidth` serial lanes that target `delegateDispatchQueue`:
+ messages with equal keys are reported in order, while messages with different keys are reported in parallel
+ when `delegateDispatchQueue` is a concurrent queue. Default: `nil`.
+
+ Other delegate methods are not ordered relative to messages reported in parallel.
+ Not used for `webSocket:didReceiveMessages:`, with `delegateOperationQueue` or when `callsDelegateInline` is enabled.
+ The block must be fast and must not call into the socket. Set this before opening the socket.
+ */
+@property (nullable, nonatomic, copy) SRMessageOrderingKeyBlock messageOrderingKeyBlock;
+
+/**
+ Number of serial lanes that keys returned by `messageOrderingKeyBlock` are spread over,
+ which is the maximum number of messages reported at the same time. Default: number of active processors.
+ */
+@property (nonatomic, assign) NSUInteger concurrentDeliveryWidth;
+
+/**
+ Block that decodes every received message on a background concurrent queue, before it is reported to the delegate.
+ Decoded messages are reported one by one via `webSocket:didReceiveDecodedMessage:`, in the order they were received,
+ or per key when `messageOrderingKeyBlock` is set. Default: `nil`.
+
+ Not used when `receivesMessagesOnDemand` is enabled. Messages that are still being decoded
+ might be reported after `webSocket:didFailWithError:` or `webSocket:didCloseWithCode:reason:wasClean:`.
+ When `callsDelegateInline` is enabled, decoded messages are reported on the queue of the socket too,
+ one delegate call at a time with all other delegate methods.
+ Set this before opening the socket.
+ */
+@property (nullable, nonatomic, copy) SRMessageDecoderBlock messageDecoderBlock;
+
+/**
+ Whether text messages are passed to `messageDecoderBlock` as raw `NSData`, skipping creation of an `NSString`.
+ The decoder is then responsible for validating UTF-8 of text messages. Default: `NO`.
+ */
+@property (nonatomic, assign) BOOL decodesTextMessagesAsData;
+
+/**
+ Time in seconds to wait for the server to close the connection after a close frame was sent, before failing the socket.
+ `0` waits indefinitely. Default: `0`.
+ */
+@property (nonatomic, assign) NSTimeInterval closeTimeout;
+
+/**
+ Time in seconds without receiving any data from an open connection, before failing the socket.
+ `0` disables the timeout. Default: `0`.
+ Timeouts of all sockets, including the opening timeout set by `timeoutInterval` of the request, are driven by a single shared timer.
+ */
+@property (nonatomic, assign) NSTimeInterval idleTimeout;
+
 /**
  Current ready state of the socket. Default: `SR_CONNECTING`.
 
@@ -272,6 +411,7 @@ extern NSString *const SRHTTPResponseErrorKey;
 
 /**
  Send a UTF-8 String to the server.
+ Strings that can't be encoded as UTF-8, such as ones with unpaired surrogates, are not sent.
 
  @param string String to send.
  @param error  On input, a pointer to variable for an `NSError` object.
@@ -306,6 +446,414 @@ extern NSString *const SRHTTPResponseErrorKey;
  */
 - (BOOL)sendDataNoCopy:(nullable NSData *)data error:(NSError **)error NS_SWIFT_NAME(send(dataNoCopy:));
 
+/**
+ Send binary data split into multiple parts to the server as a single message.
+ Parts are masked directly into the outgoing frame, without concatenating them first.
+ The parts are consumed before this method returns, so they can be reused right after it.
+
+ @param parts Parts of the message to send, in order.
+ @param error On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the message was scheduled to send, otherwise - `NO`.
+ */
+- (BOOL)sendDataParts:(NSArray<NSData *> *)parts error:(NSError **)error NS_SWIFT_NAME(send(dataParts:));
+
+/**
+ Send binary data split into multiple parts to the server as a single message and get notified once it was handed to the output stream.
+
+ @param parts           Parts of the message to send, in order. They are consumed before this method returns.
+ @param completionQueue Queue to call `completion` on. If `nil` - main queue is used.
+ @param completion      Block to call once the last byte of the message was written to the output stream,
+ or the socket was closed before that happened.
+ @param error           On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the message was scheduled to send, otherwise - `NO`. If `NO` is returned - `completion` is never called.
+ */
+- (BOOL)sendDataParts:(NSArray<NSData *> *)parts
+      completionQueue:(nullable dispatch_queue_t)completionQueue
+           completion:(nullable SRSendCompletionHandler)completion
+                error:(NSError **)error NS_SWIFT_NAME(send(dataParts:completionQueue:completion:));
+
+/**
+ Send binary data to the server, masking every region of a possibly discontiguous `dispatch_data_t` directly into the outgoing frame.
+
+ @param data  Data to send.
+ @param error On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the message was scheduled to send, otherwise - `NO`.
+ */
+- (BOOL)sendDispatchData:(dispatch_data_t)data error:(NSError **)error NS_SWIFT_NAME(send(dispatchData:));
+
+/**
+ Send a possibly discontiguous `dispatch_data_t` to the server and get notified once it was handed to the output stream.
+
+ @param data            Data to send.
+ @param completionQueue Queue to call `completion` on. If `nil` - main queue is used.
+ @param completion      Block to call once the last byte of the message was written to the output stream,
+ or the socket was closed before that happened.
+ @param error           On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the message was scheduled to send, otherwise - `NO`. If `NO` is returned - `completion` is never called.
+ */
+- (BOOL)sendDispatchData:(dispatch_data_t)data
+         completionQueue:(nullable dispatch_queue_t)completionQueue
+              completion:(nullable SRSendCompletionHandler)completion
+                   error:(NSError **)error NS_SWIFT_NAME(send(dispatchData:completionQueue:completion:));
+
+/**
+ Send a UTF-8 String to the server and get notified once it was handed to the output stream.
+
+ @param string          String to send.
+ @param completionQueue Queue to call `completion` on. If `nil` - main queue is used.
+ @param completion      Block to call once the last byte of the message was written to the output stream,
+ or the socket was closed before that happened.
+ @param error           On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the string was scheduled to send, otherwise - `NO`. If `NO` is returned - `completion` is never called.
+ */
+- (BOOL)sendString:(NSString *)string
+   completionQueue:(nullable dispatch_queue_t)completionQueue
+        completion:(nullable SRSendCompletionHandler)completion
+             error:(NSError **)error NS_SWIFT_NAME(send(string:completionQueue:completion:));
+
+/**
+ Send binary data to the server and get notified once it was handed to the output stream.
+ If `data` is `nil` - nothing is written and `completion` is called with an error.
+
+ @param data            Data to send.
+ @param completionQueue Queue to call `completion` on. If `nil` - main queue is used.
+ @param completion      Block to call once the last byte of the message was written to the output stream,
+ or the socket was closed before that happened.
+ @param error           On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the data was scheduled to send, otherwise - `NO`. If `NO` is returned - `completion` is never called.
+ */
+- (BOOL)sendData:(nullable NSData *)data
+ completionQueue:(nullable dispatch_queue_t)completionQueue
+      completion:(nullable SRSendCompletionHandler)completion
+           error:(NSError **)error NS_SWIFT_NAME(send(data:completionQueue:completion:));
+
+///--------------------------------------
+#pragma mark Send Using Builder
+///--------------------------------------
+
+/**
+ Creates a builder that lets you write the payload of a message directly into a pooled frame buffer.
+ Frame header space is reserved in front of the payload, so sending the builder doesn't copy the payload.
+
+ @param capacity Expected length of the payload in bytes. The builder grows past it if needed.
+
+ @return A new message builder. Send it with `sendMessageFromBuilder:error:`.
+ */
+- (SRMessageBuilder *)messageBuilderWithCapacity:(NSUInteger)capacity;
+
+/**
+ Send a message that was written into a builder created by `messageBuilderWithCapacity:`.
+ The payload is masked in place, so the builder can't be used after calling this method.
+
+ @param builder Builder with the payload to send.
+ @param error   On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the message was scheduled to send, otherwise - `NO`.
+ If the builder couldn't allocate its buffer, the error code is `SRStatusCodeMessageTooBig` and the connection is closed with it.
+ */
+- (BOOL)sendMessageFromBuilder:(SRMessageBuilder *)builder error:(NSError **)error NS_SWIFT_NAME(send(builder:));
+
+/**
+ Send a message that was written into a builder created by `messageBuilderWithCapacity:`
+ and get notified once it was handed to the output stream.
+
+ @param builder         Builder with the payload to send.
+ @param completionQueue Queue to call `completion` on. If `nil` - main queue is used.
+ @param completion      Block to call once the last byte of the message was written to the output stream,
+ or the socket was closed before that happened.
+ @param error           On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the message was scheduled to send, otherwise - `NO`. If `NO` is returned - `completion` is never called.
+ */
+- (BOOL)sendMessageFromBuilder:(SRMessageBuilder *)builder
+               completionQueue:(nullable dispatch_queue_t)completionQueue
+                    completion:(nullable SRSendCompletionHandler)completion
+                         error:(NSError **)error NS_SWIFT_NAME(send(builder:completionQueue:completion:));
+
+///--------------------------------------
+#pragma mark Send Conflated
+///--------------------------------------
+
+/**
+ Number of messages sent with a conflation key that were replaced by a newer message with the same key before being sent.
+
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) uint64_t conflatedMessageCount;
+
+/**
+ Number of messages sent with a conflation key that were written to the output buffer.
+
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) uint64_t conflationSentMessageCount;
+
+/**
+ Send a UTF-8 String to the server, replacing any unsent message with the same conflation key.
+
+ Conflated messages are held back until the socket has drained its output buffer,
+ so only the latest message for each key is sent when the connection can't keep up.
+ Conflated messages are sent in the order their keys were first enqueued,
+ but are not ordered relative to messages sent without a conflation key.
+ Any conflated messages still held back when the socket starts closing are discarded.
+
+ @param string        String to send.
+ @param conflationKey Key identifying which queued message this one supersedes.
+ @param error         On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the string was scheduled to send, otherwise - `NO`.
+ */
+- (BOOL)sendString:(NSString *)string conflationKey:(NSString *)conflationKey error:(NSError **)error NS_SWIFT_NAME(send(string:conflationKey:));
+
+/**
+ Send binary data to the server, replacing any unsent message with the same conflation key.
+
+ See `sendString:conflationKey:error:` for conflation and ordering rules.
+
+ @param data          Data to send.
+ @param conflationKey Key identifying which queued message this one supersedes.
+ @param error         On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the data was scheduled to send, otherwise - `NO`.
+ */
+- (BOOL)sendData:(NSData *)data conflationKey:(NSString *)conflationKey error:(NSError **)error NS_SWIFT_NAME(send(data:conflationKey:));
+
+///--------------------------------------
+#pragma mark Receive On Demand
+///--------------------------------------
+
+/**
+ Whether received messages are kept by the socket until requested with `receiveMessagesWithMaximumCount:completionQueue:completion:`,
+ instead of being reported to the delegate. Set this before opening the socket. Default: `NO`.
+
+ While more than `maximumReceiveBacklogLength` bytes are waiting to be requested, the socket stops reading from the network,
+ so TCP flow control pushes back on the server.
+ */
+@property (nonatomic, assign) BOOL receivesMessagesOnDemand;
+
+/**
+ Number of received bytes the socket buffers before it stops reading from the network. Default: `1 MB`.
+ */
+@property (nonatomic, assign) NSUInteger maximumReceiveBacklogLength;
+
+/**
+ Number of received bytes that weren't handed to the app yet, including bytes that were read but not decoded into messages.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSUInteger receiveBacklogLength;
+
+/**
+ Requests received messages when `receivesMessagesOnDemand` is enabled.
+ Completion is called once at least one message is available, with up to `maximumCount` messages.
+ Outstanding requests are completed in the order they were made.
+ After the socket closes, requests are completed with the remaining messages and then with an error.
+
+ @param maximumCount    Maximum number of messages to pass to `completion`.
+ @param completionQueue Queue to call `completion` on. If `nil` - main queue is used.
+ @param completion      Block to call with received messages.
+ */
+- (void)receiveMessagesWithMaximumCount:(NSUInteger)maximumCount
+                        completionQueue:(nullable dispatch_queue_t)completionQueue
+                             completion:(SRReceiveCompletionHandler)completion
+    NS_SWIFT_NAME(receiveMessages(maximumCount:completionQueue:completion:));
+
+///--------------------------------------
+#pragma mark Receive Flow Control
+///--------------------------------------
+
+/**
+ Number of bytes in messages that were dispatched to the delegate but not handled yet,
+ at which the socket stops reading from the network until the delegate catches up. `0` means no limit. Default: `16 MB`.
+ */
+@property (nonatomic, assign) NSUInteger maximumDelegateBacklogLength;
+
+/**
+ Number of messages that were dispatched to the delegate but not handled yet,
+ at which the socket stops reading from the network until the delegate catches up. `0` means no limit. Default: `0`.
+ */
+@property (nonatomic, assign) NSUInteger maximumDelegateBacklogCount;
+
+/**
+ Number of bytes in messages that were dispatched to the delegate but not handled yet.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSUInteger delegateBacklogLength;
+
+/**
+ Number of messages that were dispatched to the delegate but not handled yet.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSUInteger delegateBacklogCount;
+
+/**
+ Number of times the socket stopped reading from the network, because either the delegate or on demand receive backlog was full.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSUInteger readPauseCount;
+
+/**
+ Total time in seconds the socket didn't read from the network because of a full receive backlog, including the current pause.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval readPausedDuration;
+
+///--------------------------------------
+#pragma mark Keepalive
+///--------------------------------------
+
+/**
+ Interval in seconds between keepalive pings that are sent while the socket is open. `0` disables keepalive pings. Default: `0`.
+ Pings of all sockets are driven by a single shared timer. Pongs to keepalive pings are not reported to the delegate.
+ */
+@property (nonatomic, assign) NSTimeInterval pingInterval;
+
+/**
+ Time in seconds to wait for a pong to a keepalive ping, before the connection is considered dead and the socket fails. Default: `10`.
+ */
+@property (nonatomic, assign) NSTimeInterval pongTimeout;
+
+/**
+ Smoothed round trip time in seconds, measured with keepalive pings. `0` until the first pong is received.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval smoothedRoundTripTime;
+
+/**
+ Lowest round trip time in seconds, measured with keepalive pings. `0` until the first pong is received.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval minimumRoundTripTime;
+
+/**
+ Smoothed mean deviation of the round trip time in seconds, measured with keepalive pings. `0` until the first pong is received.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval roundTripTimeJitter;
+
+///--------------------------------------
+#pragma mark Metrics
+///--------------------------------------
+
+/**
+ Snapshot of the counters of this socket. Counters are cheap to update, so they are always collected.
+ This property is thread-safe.
+ */
+@property (nonatomic, strong, readonly) SRWebSocketMetrics *metrics;
+
+/**
+ Snapshot of the counters of all sockets in the process, including sockets that were already deallocated.
+ This property is thread-safe.
+ */
+@property (class, nonatomic, strong, readonly) SRWebSocketMetrics *aggregateMetrics;
+
+/**
+ Spans of the hot paths of all sockets in the process (reading, frame parsing, UTF-8 validation, delegate dispatch, framing, masking, writing)
+ as Chrome trace-event JSON, which can be opened in `chrome://tracing` or Perfetto.
+ Each thread keeps only its most recent spans. Spans are recorded only when SocketRocket is built with `SR_TRACE_ENABLED` defined,
+ otherwise the trace is empty.
+ This property is thread-safe.
+ */
+@property (class, nonatomic, copy, readonly) NSData *traceEventJSONData;
+
+/**
+ Timestamps of the phases of opening this socket, the same as `metrics.handshakeTimeline`.
+ Phases are recorded as they happen, so the timeline of a socket that is still connecting is partial.
+ This property is thread-safe.
+ */
+@property (nonatomic, assign, readonly) SRHandshakeTimeline handshakeTimeline;
+
+/**
+ Interval in seconds between reports of `metrics` via `webSocket:didReportMetrics:` while the socket is open.
+ `0` disables reporting. Default: `0`.
+ */
+@property (nonatomic, assign) NSTimeInterval metricsReportingInterval;
+
+///--------------------------------------
+#pragma mark Logging
+///--------------------------------------
+
+/**
+ Most verbose level of messages that are logged. Default: `SRLogLevelError`.
+
+ Messages are formatted only if their level is enabled, then queued and handed to `logSink` on a background queue,
+ so logging never blocks the socket. `SRLogLevelDebug` messages are compiled in only when SocketRocket is built with `SR_DEBUG_LOG_ENABLED` defined.
+ This property is thread-safe.
+ */
+@property (class, nonatomic, assign) SRLogLevel logLevel;
+
+/**
+ Receives every logged message. `nil` logs messages via `NSLog`. Default: `nil`.
+ This property is thread-safe.
+ */
+@property (class, nullable, nonatomic, copy) SRLogSink logSink;
+
+///--------------------------------------
+#pragma mark Traffic Capture
+///--------------------------------------
+
+/**
+ File to record the traffic of this socket to: every chunk of bytes read from the network, including the handshake response,
+ and every frame sent, each with a timestamp. The file is replaced when the socket opens. Must be set before calling `open`. Default: `nil`.
+ Records are appended as they happen, so the capture of an app that crashed is complete up to the crash.
+ */
+@property (nullable, nonatomic, copy) NSURL *captureFileURL;
+
+/**
+ Feeds the bytes received in a capture written via `captureFileURL` through the frame parser of this socket, without a network connection.
+ The socket reports opening, messages and closing to the delegate as if it received the bytes from a server. Frames it sends are dropped.
+ Must be called instead of `open` and blocks until the whole capture was fed.
+
+ @param url           URL of the capture file.
+ @param recordedSpeed `YES` to feed the bytes with the delays they were received with, `NO` to feed them as fast as possible.
+ @param error         On input, a pointer to variable for an `NSError` object.
+ If an error occurs, this pointer is set to an `NSError` object containing information about the error.
+ You may specify `nil` to ignore the error information.
+
+ @return `YES` if the capture was replayed, `NO` if it couldn't be read or doesn't contain an opened connection.
+ */
+- (BOOL)replayCaptureFromURL:(NSURL *)url atRecordedSpeed:(BOOL)recordedSpeed error:(NSError **)error;
+
+///--------------------------------------
+#pragma mark Loopback
+///--------------------------------------
+
+/**
+ In-process server to connect to instead of the host in the URL. The socket talks to it through memory,
+ without DNS, proxies, TLS or a network connection, which makes tests and benchmarks independent of a real server.
+ Must be set before calling `open`. Default: `nil`.
+ */
+@property (nullable, nonatomic, strong) SRLoopbackTransport *loopbackTransport;
+
+///--------------------------------------
+#pragma mark Ping
+///--------------------------------------
+
 /**
  Send Ping message to the server with optional data.
 
@@ -359,6 +907,39 @@ extern NSString *const SRHTTPResponseErrorKey;
  */
 - (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data;
 
+/**
+ Called with all messages that were received from a web socket since the previous call, in the order they were received.
+ If implemented - this method is called instead of the other methods for receiving messages.
+
+ Messages decoded from a single read of the socket are delivered together, up to `maximumMessageBatchCount` messages
+ or `maximumMessageBatchLength` bytes per call. A batch never waits for more data to arrive.
+
+ @param webSocket An instance of `SRWebSocket` that received messages.
+ @param messages  Received messages. Each one is either a `String` or `NSData`,
+ following `webSocketShouldConvertTextFrameToString:` for text frames.
+ */
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessages:(NSArray *)messages;
+
+/**
+ Called with a message decoded by `messageDecoderBlock`.
+ If `messageDecoderBlock` is set - this method is called instead of the other methods for receiving messages,
+ falling back to `webSocket:didReceiveMessage:` if it's not implemented.
+
+ @param webSocket An instance of `SRWebSocket` that received a message.
+ @param message   Object returned by `messageDecoderBlock`.
+ */
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveDecodedMessage:(id)message;
+
+/**
+ Called when a message was received from a web socket, together with metadata about how and when it arrived.
+ If implemented - this method is called instead of the other methods for receiving messages,
+ except `webSocket:didReceiveDecodedMessage:` when `messageDecoderBlock` is set.
+
+ @param webSocket An instance of `SRWebSocket` that received a message.
+ @param message   Received message with its metadata.
+ */
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithMetadata:(SRMessage *)message;
+
 #pragma mark Status & Connection
 
 /**
@@ -402,6 +983,14 @@ extern NSString *const SRHTTPResponseErrorKey;
  */
 - (void)webSocket:(SRWebSocket *)webSocket didReceivePong:(nullable NSData *)pongData;
 
+/**
+ Called periodically with a snapshot of the counters of the socket, when `metricsReportingInterval` is set.
+
+ @param webSocket An instance of `SRWebSocket` that reported metrics.
+ @param metrics   Snapshot of the counters of the socket.
+ */
+- (void)webSocket:(SRWebSocket *)webSocket didReportMetrics:(SRWebSocketMetrics *)metrics;
+
 /**
  Sent before reporting a text frame to be able to configure if it shuold be convert to a UTF-8 String or passed as `NSData`.
  If the method is not implemented - it will always convert text frames to String.
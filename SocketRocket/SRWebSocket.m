@@ -11,15 +11,8 @@
 
 #import "SRWebSocket.h"
 
-#if __has_include(<unicode/utf8.h>)
-#define HAS_ICU
-#endif
-
-#ifdef HAS_ICU
-#import <unicode/utf8.h>
-#endif
-
 #import <libkern/OSAtomic.h>
+#import <stdatomic.h>
 
 #import "SRDelegateController.h"
 #import "SRIOConsumer.h"
@@ -34,8 +27,25 @@
 #import "SRHTTPConnectMessage.h"
 #import "SRRandom.h"
 #import "SRLog.h"
+#import "SRLoopbackTransport+Private.h"
 #import "SRMutex.h"
 #import "SRSIMDHelpers.h"
+#import "SRDecodePipeline.h"
+#import "SRPendingReceive.h"
+#import "SRPendingWrite.h"
+#import "SRConflationQueue.h"
+#import "SRFrameHeader.h"
+#import "SRFrameBufferPool.h"
+#import "SRMessage+Private.h"
+#import "SRMessageBuilder+Private.h"
+#import "SRAllocationAudit.h"
+#import "SRMetricsRecorder.h"
+#import "SRTime.h"
+#import "SRTimerWheel.h"
+#import "SRTrafficCapture.h"
+#import "SRScanner.h"
+#import "SRTrace.h"
+#import "SRUTF8Validation.h"
 #import "NSURLRequest+SRWebSocketPrivate.h"
 #import "NSRunLoop+SRWebSocketPrivate.h"
 #import "SRConstants.h"
@@ -60,10 +70,6 @@ typedef struct {
     uint64_t payload_length;
 } frame_header;
 
-static NSString *const SRWebSocketAppendToSecKeyString = @"258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-
-static inline int32_t validate_dispatch_data_partial_string(NSData *data);
-
 static uint8_t const SRWebSocketProtocolVersion = 13;
 
 NSString *const SRWebSocketErrorDomain = @"SRWebSocketErrorDomain";
@@ -99,6 +105,59 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
     dispatch_data_t _outputBuffer;
     NSUInteger _outputBufferOffset;
 
+    // Total number of bytes ever added to `_outputBuffer` and written from it to the output stream.
+    uint64_t _outputBytesEnqueued;
+    uint64_t _outputBytesWritten;
+    NSMutableArray<SRPendingWrite *> *_pendingWrites;
+
+    SRConflationQueue *_conflationQueue;
+    BOOL _isPumpingConflationQueue;
+    atomic_uint_fast64_t _conflatedMessageCount;
+    atomic_uint_fast64_t _conflationSentMessageCount;
+
+    SRFrameBufferPool *_frameBufferPool;
+
+    SRTimerWheelTimer *_openTimeoutTimer;
+    SRTimerWheelTimer *_closeTimeoutTimer;
+    SRTimerWheelTimer *_idleTimeoutTimer;
+    uint64_t _lastReadTime;
+    uint64_t _currentMessageFirstByteTime;
+    uint64_t _currentMessageLastByteTime;
+
+    SRMetricsRecorder *_metricsRecorder;
+    SRTimerWheelTimer *_metricsReportTimer;
+    SRTimerWheelTimer *_keepalivePingTimer;
+    SRTimerWheelTimer *_keepalivePongTimer;
+    atomic_uint_fast64_t _smoothedRoundTripTime;
+    atomic_uint_fast64_t _minimumRoundTripTime;
+    atomic_uint_fast64_t _roundTripTimeJitter;
+
+    // Messages waiting to be requested when `receivesMessagesOnDemand` is enabled.
+    NSMutableArray *_receivedMessages;
+    NSMutableArray<NSNumber *> *_receivedMessageLengths;
+    NSUInteger _receivedMessagesLength;
+    NSMutableArray<SRPendingReceive *> *_pendingReceives;
+    atomic_uint_fast64_t _receiveBacklogLength;
+
+    // Messages that were dispatched to the delegate, but not handled yet.
+    atomic_uint_fast64_t _delegateBacklogLength;
+    atomic_uint_fast64_t _delegateBacklogCount;
+
+    // Created with the first message to decode, when `messageDecoderBlock` is set.
+    SRDecodePipeline *_decodePipeline;
+
+    // Set while reading from the network is paused because of a full receive backlog.
+    atomic_bool _readingPaused;
+    atomic_uint_fast64_t _readPauseCount;
+    atomic_uint_fast64_t _readPauseStartTime;
+    atomic_uint_fast64_t _readPausedDuration;
+
+    // Messages waiting to be reported via `webSocket:didReceiveMessages:`.
+    // `_messageBatchFrames` holds frame data of text messages and `NSNull` for binary ones.
+    NSMutableArray *_messageBatch;
+    NSMutableArray *_messageBatchFrames;
+    NSUInteger _messageBatchLength;
+
     uint8_t _currentFrameOpcode;
     size_t _currentFrameCount;
     size_t _readOpCount;
@@ -138,6 +197,11 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 
     // proxy support
     SRProxyConnect *_proxyConnect;
+
+    // Set when `captureFileURL` is, records everything received and sent.
+    SRTrafficCapture *_capture;
+    // Set while a capture is replayed, there are no streams then and written data is dropped.
+    BOOL _replaying;
 }
 
 @synthesize readyState = _readyState;
@@ -168,15 +232,33 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
     dispatch_queue_set_specific(_workQueue, (__bridge void *)self, (__bridge void *)(_workQueue), NULL);
 
     _delegateController = [[SRDelegateController alloc] init];
+    _delegateController.orderingLaneCount = [NSProcessInfo processInfo].activeProcessorCount;
 
     _readBuffer = dispatch_data_empty;
     _outputBuffer = dispatch_data_empty;
+    _pendingWrites = [[NSMutableArray alloc] init];
+    _conflationQueue = [[SRConflationQueue alloc] init];
+    _frameBufferPool = [[SRFrameBufferPool alloc] init];
+
+    _pongTimeout = 10.0;
+
+    _metricsRecorder = [[SRMetricsRecorder alloc] init];
+
+    _receivedMessages = [[NSMutableArray alloc] init];
+    _receivedMessageLengths = [[NSMutableArray alloc] init];
+    _pendingReceives = [[NSMutableArray alloc] init];
+    _maximumReceiveBacklogLength = 1024 * 1024;
+    _maximumDelegateBacklogLength = 16 * 1024 * 1024;
+
+    _maximumMessageBatchCount = 256;
+    _maximumMessageBatchLength = 1024 * 1024;
 
     _currentFrameData = [[NSMutableData alloc] init];
 
     _consumers = [[NSMutableArray alloc] init];
 
     _consumerPool = [[SRIOConsumerPool alloc] init];
+    _consumerPool.metricsRecorder = _metricsRecorder;
 
     _scheduledRunloops = [[NSMutableSet alloc] init];
 
@@ -316,9 +398,9 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
     _selfRetain = self;
 
     if (_urlRequest.timeoutInterval > 0) {
-        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_urlRequest.timeoutInterval * NSEC_PER_SEC));
+        // Covers connecting, proxy negotiation and the opening handshake.
         __weak typeof(self) wself = self;
-        dispatch_after(popTime, dispatch_get_main_queue(), ^{
+        _openTimeoutTimer = [[SRTimerWheel sharedWheel] scheduleTimerWithDelay:_urlRequest.timeoutInterval queue:_workQueue block:^{
             __strong SRWebSocket *sself = wself;
             if (!sself) {
                 return;
@@ -327,10 +409,30 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
                 NSError *error = SRErrorWithDomainCodeDescription(NSURLErrorDomain, NSURLErrorTimedOut, @"Timed out connecting to server.");
                 [sself _failWithError:error];
             }
-        });
+        }];
+    }
+
+    if (_captureFileURL) {
+        NSError *captureError = nil;
+        _capture = [[SRTrafficCapture alloc] initWithURL:_captureFileURL error:&captureError];
+        if (!_capture) {
+            SRWarningLog(@"Not capturing traffic: %@", captureError.localizedDescription);
+        }
+    }
+
+    SRMetricsMarkHandshake(&_metricsRecorder->_counters, SRHandshakeMarkOpen);
+    if (_loopbackTransport) {
+        // There is no TLS between the ends of a loopback transport, whatever the scheme of the URL.
+        _requestRequiresSSL = NO;
+        NSInputStream *readStream = nil;
+        NSOutputStream *writeStream = nil;
+        [_loopbackTransport openClientInputStream:&readStream outputStream:&writeStream];
+        [self _connectionDoneWithError:nil readStream:readStream writeStream:writeStream];
+        return;
     }
 
     _proxyConnect = [[SRProxyConnect alloc] initWithURL:_url];
+    _proxyConnect.metricsRecorder = _metricsRecorder;
 
     __weak typeof(self) wself = self;
     [_proxyConnect openNetworkStreamWithCompletion:^(NSError *error, NSInputStream *readStream, NSOutputStream *writeStream) {
@@ -349,6 +451,9 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
         _inputStream.delegate = self;
         _outputStream.delegate = self;
         [self _updateSecureStreamOptions];
+        if (_requestRequiresSSL) {
+            SRMetricsMarkHandshake(&_metricsRecorder->_counters, SRHandshakeMarkTLSStart);
+        }
 
         if (!_scheduledRunloops.count) {
             [self scheduleInRunLoop:[NSRunLoop SR_networkRunLoop] forMode:NSDefaultRunLoopMode];
@@ -385,9 +490,10 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 
 - (void)_HTTPHeadersDidFinish
 {
+    SRMetricsMarkHandshake(&_metricsRecorder->_counters, SRHandshakeMarkHeadersComplete);
     NSInteger responseCode = CFHTTPMessageGetResponseStatusCode(_receivedHTTPHeaders);
     if (responseCode >= 400) {
-        SRDebugLog(@"Request failed with response code %d", responseCode);
+        SRWarningLog(@"Request failed with response code %d", (int)responseCode);
         NSError *error = SRHTTPErrorWithCodeDescription(responseCode, 2132,
                                                         [NSString stringWithFormat:@"Received bad response code from server: %d.",
                                                          (int)responseCode]);
@@ -413,12 +519,20 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
         _protocol = negotiatedProtocol;
     }
 
+    [_capture recordOpenWithUnreadLength:[self _undecodedLength]];
     self.readyState = SR_OPEN;
 
     if (!_didFail) {
         [self _readFrameNew];
     }
 
+    [[SRTimerWheel sharedWheel] cancelTimer:_openTimeoutTimer];
+    _openTimeoutTimer = nil;
+    _lastReadTime = SRMonotonicTimeNanoseconds();
+    [self _scheduleIdleTimeoutWithDelay:_idleTimeout];
+    [self _scheduleKeepalivePing];
+    [self _scheduleMetricsReport];
+
     [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
         if (availableMethods.didOpen) {
             [delegate webSocketDidOpen:self];
@@ -468,6 +582,7 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
     CFRelease(message);
 
     [self _writeData:messageData];
+    SRMetricsMarkHandshake(&_metricsRecorder->_counters, SRHandshakeMarkUpgradeRequest);
     [self _readHTTPHeader];
 }
 
@@ -555,18 +670,18 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 
 
         [sself _sendFrameWithOpcode:SROpCodeConnectionClose data:payload];
+        [sself _scheduleCloseTimeout];
     });
 }
 
 - (void)_closeWithProtocolError:(NSString *)message
 {
-    // Need to shunt this on the _callbackQueue first to see if they received any messages
-    [self.delegateController performDelegateQueueBlock:^{
-        [self closeWithCode:SRStatusCodeProtocolError reason:message];
-        dispatch_async(self->_workQueue, ^{
-            [self closeConnection];
-        });
-    }];
+    // Close right away, instead of waiting for the delegate queue. Callbacks for messages received before
+    // are already enqueued on it, so the delegate still sees them before the close.
+    [self closeWithCode:SRStatusCodeProtocolError reason:message];
+    dispatch_async(_workQueue, ^{
+        [self closeConnection];
+    });
 }
 
 - (void)_failWithError:(NSError *)error
@@ -574,6 +689,9 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
     dispatch_async(_workQueue, ^{
         if (self.readyState != SR_CLOSED) {
             self->_failed = YES;
+            [self _flushMessageBatch];
+            [self _cancelTimers];
+            SRWarningLog(@"Failing with error %@", error.localizedDescription);
             [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
                 if (availableMethods.didFailWithError) {
                     [delegate webSocket:self didFailWithError:error];
@@ -582,31 +700,106 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 
             self.readyState = SR_CLOSED;
 
-            SRDebugLog(@"Failing with error %@", error.localizedDescription);
-
+            [self _failPendingWritesWithUnderlyingError:error];
+            [self _completePendingReceives];
             [self closeConnection];
             [self _scheduleCleanup];
         }
     });
 }
 
+static NSError *SRPendingWriteError(NSError *_Nullable underlyingError)
+{
+    NSInteger code = 2146;
+    NSString *description = @"Socket was closed before the message was written.";
+    return (underlyingError ?
+            SRErrorWithCodeDescriptionUnderlyingError(code, description, underlyingError) :
+            SRErrorWithCodeDescription(code, description));
+}
+
 - (void)_writeData:(NSData *)data
+{
+    [self _writeData:data pendingWrite:nil];
+}
+
+// `frameData` is `nil` if the frame couldn't be allocated.
+- (void)_writeFrameData:(nullable NSData *)frameData pendingWrite:(nullable SRPendingWrite *)pendingWrite
+{
+    [self assertOnWorkQueue];
+
+    if (!frameData) {
+        [self _failMessageTooBigWithPendingWrite:pendingWrite];
+        return;
+    }
+
+    uint8_t opCode = ((const uint8_t *)frameData.bytes)[0] & SROpCodeMask;
+    SRMetricsAdd(&_metricsRecorder->_counters.framesSent[opCode], 1);
+    [_capture recordSentFrame:frameData];
+    [self _writeData:frameData pendingWrite:pendingWrite];
+}
+
+- (void)_writeData:(NSData *)data pendingWrite:(nullable SRPendingWrite *)pendingWrite
 {
     [self assertOnWorkQueue];
 
     if (_closeWhenFinishedWriting) {
+        [pendingWrite completeWithError:SRPendingWriteError(nil)];
         return;
     }
 
+    if (pendingWrite) {
+        pendingWrite.startOffset = _outputBytesEnqueued;
+        pendingWrite.endOffset = _outputBytesEnqueued + data.length;
+        [_pendingWrites addObject:pendingWrite];
+    }
+    _outputBytesEnqueued += data.length;
+
     __block NSData *strongData = data;
     dispatch_data_t newData = dispatch_data_create(data.bytes, data.length, nil, ^{
         strongData = nil;
     });
     (void)strongData;
     _outputBuffer = dispatch_data_create_concat(_outputBuffer, newData);
+    SRMetricsPeak(&_metricsRecorder->_counters.peakOutputBufferLength, dispatch_data_get_size(_outputBuffer) - _outputBufferOffset);
     [self _pumpWriting];
 }
 
+- (void)_updatePendingWrites
+{
+    [self assertOnWorkQueue];
+
+    uint64_t now = SRMonotonicTimeNanoseconds();
+    while (_pendingWrites.count) {
+        SRPendingWrite *pendingWrite = _pendingWrites.firstObject;
+        if (pendingWrite.startOffset >= _outputBytesWritten) {
+            break;
+        }
+        if (pendingWrite.endOffset > _outputBytesWritten) {
+            [pendingWrite markFirstByteWrittenAtTime:now];
+            break;
+        }
+        [pendingWrite markLastByteWrittenAtTime:now];
+        [_pendingWrites removeObjectAtIndex:0];
+        [pendingWrite completeWithError:nil];
+    }
+}
+
+- (void)_failPendingWritesWithUnderlyingError:(nullable NSError *)underlyingError
+{
+    [self assertOnWorkQueue];
+
+    if (!_pendingWrites.count) {
+        return;
+    }
+
+    NSError *error = SRPendingWriteError(underlyingError);
+    NSArray<SRPendingWrite *> *pendingWrites = [_pendingWrites copy];
+    [_pendingWrites removeAllObjects];
+    for (SRPendingWrite *pendingWrite in pendingWrites) {
+        [pendingWrite completeWithError:error];
+    }
+}
+
 - (void)send:(nullable id)message
 {
     if (!message) {
@@ -621,6 +814,14 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 }
 
 - (BOOL)sendString:(NSString *)string error:(NSError **)error
+{
+    return [self sendString:string completionQueue:nil completion:nil error:error];
+}
+
+- (BOOL)sendString:(NSString *)string
+   completionQueue:(nullable dispatch_queue_t)completionQueue
+        completion:(nullable SRSendCompletionHandler)completion
+             error:(NSError **)error
 {
     if (self.readyState != SR_OPEN) {
         NSString *message = @"Invalid State: Cannot call `sendString:error:` until connection is open.";
@@ -631,20 +832,49 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
         return NO;
     }
 
-    string = [string copy];
+    SRPendingWrite *pendingWrite = (completion ? [[SRPendingWrite alloc] initWithQueue:completionQueue completion:completion] : nil);
+    // Encoding on the calling thread writes the string straight into the frame, without copying it first.
+    SR_TRACE_BEGIN(FrameBuild);
+    NSData *frameData = SRFrameDataCreateWithString(SROpCodeTextFrame, string, _frameBufferPool);
+    SR_TRACE_END(FrameBuild, frameData.length);
+    // A string that has characters but no UTF-8 length can't be encoded, anything else failed to allocate.
+    if (!frameData && (!string || (string.length > 0 && [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding] == 0))) {
+        NSString *message = @"Invalid Argument: Cannot send a string that can't be encoded as UTF-8.";
+        if (error) {
+            *error = SRErrorWithCodeDescription(2150, message);
+        }
+        SRDebugLog(message);
+        return NO;
+    }
     dispatch_async(_workQueue, ^{
-        [self _sendFrameWithOpcode:SROpCodeTextFrame data:[string dataUsingEncoding:NSUTF8StringEncoding]];
+        [self _writeFrameData:frameData pendingWrite:pendingWrite];
     });
     return YES;
 }
 
 - (BOOL)sendData:(nullable NSData *)data error:(NSError **)error
+{
+    return [self sendData:data completionQueue:nil completion:nil error:error];
+}
+
+- (BOOL)sendData:(nullable NSData *)data
+ completionQueue:(nullable dispatch_queue_t)completionQueue
+      completion:(nullable SRSendCompletionHandler)completion
+           error:(NSError **)error
 {
     data = [data copy];
-    return [self sendDataNoCopy:data error:error];
+    return [self _sendDataNoCopy:data completionQueue:completionQueue completion:completion error:error];
 }
 
 - (BOOL)sendDataNoCopy:(nullable NSData *)data error:(NSError **)error
+{
+    return [self _sendDataNoCopy:data completionQueue:nil completion:nil error:error];
+}
+
+- (BOOL)_sendDataNoCopy:(nullable NSData *)data
+        completionQueue:(nullable dispatch_queue_t)completionQueue
+             completion:(nullable SRSendCompletionHandler)completion
+                  error:(NSError **)error
 {
     if (self.readyState != SR_OPEN) {
         NSString *message = @"Invalid State: Cannot call `sendDataNoCopy:error:` until connection is open.";
@@ -655,20 +885,29 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
         return NO;
     }
 
+    SRPendingWrite *pendingWrite = (completion ? [[SRPendingWrite alloc] initWithQueue:completionQueue completion:completion] : nil);
     dispatch_async(_workQueue, ^{
         if (data) {
-            [self _sendFrameWithOpcode:SROpCodeBinaryFrame data:data];
+            [self _sendFrameWithOpcode:SROpCodeBinaryFrame data:data pendingWrite:pendingWrite];
         } else {
-            [self _sendFrameWithOpcode:SROpCodeTextFrame data:nil];
+            [self _sendFrameWithOpcode:SROpCodeTextFrame data:nil pendingWrite:pendingWrite];
         }
     });
     return YES;
 }
 
-- (BOOL)sendPing:(nullable NSData *)data error:(NSError **)error
+- (BOOL)sendDataParts:(NSArray<NSData *> *)parts error:(NSError **)error
+{
+    return [self sendDataParts:parts completionQueue:nil completion:nil error:error];
+}
+
+- (BOOL)sendDataParts:(NSArray<NSData *> *)parts
+      completionQueue:(nullable dispatch_queue_t)completionQueue
+           completion:(nullable SRSendCompletionHandler)completion
+                error:(NSError **)error
 {
     if (self.readyState != SR_OPEN) {
-        NSString *message = @"Invalid State: Cannot call `sendPing:error:` until connection is open.";
+        NSString *message = @"Invalid State: Cannot call `sendDataParts:error:` until connection is open.";
         if (error) {
             *error = SRErrorWithCodeDescription(2134, message);
         }
@@ -676,147 +915,616 @@ NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
         return NO;
     }
 
-    data = [data copy] ?: [NSData data]; // It's okay for a ping to be empty
+    SR_TRACE_BEGIN(FrameBuild);
+    NSData *frameData = SRFrameDataCreateWithParts(SROpCodeBinaryFrame, parts, _frameBufferPool);
+    SR_TRACE_END(FrameBuild, frameData.length);
+    SRPendingWrite *pendingWrite = (completion ? [[SRPendingWrite alloc] initWithQueue:completionQueue completion:completion] : nil);
     dispatch_async(_workQueue, ^{
-        [self _sendFrameWithOpcode:SROpCodePing data:data];
+        [self _writeFrameData:frameData pendingWrite:pendingWrite];
     });
     return YES;
 }
 
-- (void)_handlePingWithData:(nullable NSData *)data
+- (BOOL)sendDispatchData:(dispatch_data_t)data error:(NSError **)error
 {
-    // Need to pingpong this off _callbackQueue first to make sure messages happen in order
-    [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate> _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
-        if (availableMethods.didReceivePing) {
-            [delegate webSocket:self didReceivePingWithData:data];
-        }
-        dispatch_async(self->_workQueue, ^{
-            [self _sendFrameWithOpcode:SROpCodePong data:data];
-        });
-    }];
+    return [self sendDispatchData:data completionQueue:nil completion:nil error:error];
 }
 
-- (void)handlePong:(NSData *)pongData
+- (BOOL)sendDispatchData:(dispatch_data_t)data
+         completionQueue:(nullable dispatch_queue_t)completionQueue
+              completion:(nullable SRSendCompletionHandler)completion
+                   error:(NSError **)error
 {
-    SRDebugLog(@"Received pong");
-    [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
-        if (availableMethods.didReceivePong) {
-            [delegate webSocket:self didReceivePong:pongData];
+    if (self.readyState != SR_OPEN) {
+        NSString *message = @"Invalid State: Cannot call `sendDispatchData:error:` until connection is open.";
+        if (error) {
+            *error = SRErrorWithCodeDescription(2134, message);
         }
-    }];
+        SRDebugLog(message);
+        return NO;
+    }
+
+    SR_TRACE_BEGIN(FrameBuild);
+    NSData *frameData = SRFrameDataCreateWithDispatchData(SROpCodeBinaryFrame, data, _frameBufferPool);
+    SR_TRACE_END(FrameBuild, frameData.length);
+    SRPendingWrite *pendingWrite = (completion ? [[SRPendingWrite alloc] initWithQueue:completionQueue completion:completion] : nil);
+    dispatch_async(_workQueue, ^{
+        [self _writeFrameData:frameData pendingWrite:pendingWrite];
+    });
+    return YES;
+}
+
+- (SRMessageBuilder *)messageBuilderWithCapacity:(NSUInteger)capacity
+{
+    return [[SRMessageBuilder alloc] initWithBufferPool:_frameBufferPool capacity:capacity];
 }
 
+- (BOOL)sendMessageFromBuilder:(SRMessageBuilder *)builder error:(NSError **)error
+{
+    return [self sendMessageFromBuilder:builder completionQueue:nil completion:nil error:error];
+}
 
-static inline BOOL closeCodeIsValid(int closeCode) {
-    if (closeCode < 1000) {
+- (BOOL)sendMessageFromBuilder:(SRMessageBuilder *)builder
+               completionQueue:(nullable dispatch_queue_t)completionQueue
+                    completion:(nullable SRSendCompletionHandler)completion
+                         error:(NSError **)error
+{
+    NSAssert(!builder.finished, @"Cannot send SRMessageBuilder more than once.");
+
+    if (self.readyState != SR_OPEN) {
+        NSString *message = @"Invalid State: Cannot call `sendMessageFromBuilder:error:` until connection is open.";
+        if (error) {
+            *error = SRErrorWithCodeDescription(2134, message);
+        }
+        SRDebugLog(message);
         return NO;
     }
 
-    if (closeCode >= 1000 && closeCode <= 1011) {
-        if (closeCode == 1004 ||
-            closeCode == 1005 ||
-            closeCode == 1006) {
-            return NO;
+    // Header and masking are done on the calling thread, so the work queue only needs to enqueue the frame.
+    NSData *frameData = [builder finishFrameWithOpCode:(builder.isText ? SROpCodeTextFrame : SROpCodeBinaryFrame)];
+    if (!frameData) {
+        // Builder couldn't allocate its buffer, close with 1009 like for any other frame that can't be built.
+        dispatch_async(_workQueue, ^{
+            [self _failMessageTooBigWithPendingWrite:nil];
+        });
+        if (error) {
+            *error = SRErrorWithCodeDescription(SRStatusCodeMessageTooBig, @"Message too big");
         }
-        return YES;
+        return NO;
     }
+    SRPendingWrite *pendingWrite = (completion ? [[SRPendingWrite alloc] initWithQueue:completionQueue completion:completion] : nil);
+    dispatch_async(_workQueue, ^{
+        [self _writeFrameData:frameData pendingWrite:pendingWrite];
+    });
+    return YES;
+}
 
-    if (closeCode >= 3000 && closeCode <= 3999) {
-        return YES;
+- (BOOL)sendString:(NSString *)string conflationKey:(NSString *)conflationKey error:(NSError **)error
+{
+    if (self.readyState != SR_OPEN) {
+        NSString *message = @"Invalid State: Cannot call `sendString:conflationKey:error:` until connection is open.";
+        if (error) {
+            *error = SRErrorWithCodeDescription(2134, message);
+        }
+        SRDebugLog(message);
+        return NO;
     }
 
-    if (closeCode >= 4000 && closeCode <= 4999) {
-        return YES;
+    [self _enqueueConflatedMessage:[string copy] forKey:conflationKey];
+    return YES;
+}
+
+- (BOOL)sendData:(NSData *)data conflationKey:(NSString *)conflationKey error:(NSError **)error
+{
+    if (self.readyState != SR_OPEN) {
+        NSString *message = @"Invalid State: Cannot call `sendData:conflationKey:error:` until connection is open.";
+        if (error) {
+            *error = SRErrorWithCodeDescription(2134, message);
+        }
+        SRDebugLog(message);
+        return NO;
     }
 
-    return NO;
+    [self _enqueueConflatedMessage:[data copy] forKey:conflationKey];
+    return YES;
 }
 
-//  Note from RFC:
-//
-//  If there is a body, the first two
-//  bytes of the body MUST be a 2-byte unsigned integer (in network byte
-//  order) representing a status code with value /code/ defined in
-//  Section 7.4.  Following the 2-byte integer the body MAY contain UTF-8
-//  encoded data with value /reason/, the interpretation of which is not
-//  defined by this specification.
+- (void)_enqueueConflatedMessage:(id)message forKey:(NSString *)key
+{
+    key = [key copy];
+    dispatch_async(_workQueue, ^{
+        if (self.readyState != SR_OPEN) {
+            return;
+        }
+        if ([self->_conflationQueue enqueueMessage:message forKey:key]) {
+            atomic_fetch_add_explicit(&self->_conflatedMessageCount, 1, memory_order_relaxed);
+        }
+        [self _pumpWriting];
+    });
+}
 
-- (void)handleCloseWithData:(NSData *)data
+- (void)_pumpConflationQueue
 {
-    size_t dataSize = data.length;
-    __block uint16_t closeCode = 0;
+    [self assertOnWorkQueue];
 
-    SRDebugLog(@"Received close frame");
+    if (_isPumpingConflationQueue || !_conflationQueue.count) {
+        return;
+    }
 
-    if (dataSize == 1) {
-        // TODO handle error
-        [self _closeWithProtocolError:@"Payload for close must be larger than 2 bytes"];
+    // Nothing may follow the close frame, so drop whatever is left once we start closing.
+    if (self.readyState != SR_OPEN || _closeWhenFinishedWriting) {
+        [_conflationQueue removeAllMessages];
         return;
-    } else if (dataSize >= 2) {
-        [data getBytes:&closeCode length:sizeof(closeCode)];
-        _closeCode = CFSwapInt16BigToHost(closeCode);
-        if (!closeCodeIsValid(_closeCode)) {
-            [self _closeWithProtocolError:[NSString stringWithFormat:@"Cannot have close code of %d", _closeCode]];
-            return;
-        }
-        if (dataSize > 2) {
-            _closeReason = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(2, dataSize - 2)] encoding:NSUTF8StringEncoding];
-            if (!_closeReason) {
-                [self _closeWithProtocolError:@"Close reason MUST be valid UTF-8"];
-                return;
-            }
+    }
+
+    _isPumpingConflationQueue = YES;
+
+    // Only frame conflated messages while there is little unsent data left,
+    // so that newer messages have a chance to replace the queued ones when the connection is slow.
+    while (_conflationQueue.count &&
+           (dispatch_data_get_size(_outputBuffer) - _outputBufferOffset) < SRDefaultBufferSize()) {
+        id message = [_conflationQueue dequeueMessage];
+        atomic_fetch_add_explicit(&_conflationSentMessageCount, 1, memory_order_relaxed);
+
+        if ([message isKindOfClass:[NSString class]]) {
+            [self _sendFrameWithOpcode:SROpCodeTextFrame data:[message dataUsingEncoding:NSUTF8StringEncoding]];
+        } else {
+            [self _sendFrameWithOpcode:SROpCodeBinaryFrame data:message];
         }
-    } else {
-        _closeCode = SRStatusNoStatusReceived;
     }
 
-    [self assertOnWorkQueue];
+    _isPumpingConflationQueue = NO;
+}
 
-    if (self.readyState == SR_OPEN) {
-        [self closeWithCode:1000 reason:nil];
+- (uint64_t)conflatedMessageCount
+{
+    return atomic_load_explicit(&_conflatedMessageCount, memory_order_relaxed);
+}
+
+- (uint64_t)conflationSentMessageCount
+{
+    return atomic_load_explicit(&_conflationSentMessageCount, memory_order_relaxed);
+}
+
+- (BOOL)sendPing:(nullable NSData *)data error:(NSError **)error
+{
+    if (self.readyState != SR_OPEN) {
+        NSString *message = @"Invalid State: Cannot call `sendPing:error:` until connection is open.";
+        if (error) {
+            *error = SRErrorWithCodeDescription(2134, message);
+        }
+        SRDebugLog(message);
+        return NO;
     }
+
+    data = [data copy] ?: [NSData data]; // It's okay for a ping to be empty
     dispatch_async(_workQueue, ^{
-        [self closeConnection];
+        [self _sendFrameWithOpcode:SROpCodePing data:data];
     });
+    return YES;
 }
 
-- (void)closeConnection
+- (void)_handlePingWithData:(nullable NSData *)data
 {
     [self assertOnWorkQueue];
-    SRDebugLog(@"Trying to disconnect");
-    _closeWhenFinishedWriting = YES;
-    [self _pumpWriting];
+
+    // Answer on the work queue, so a busy delegate queue doesn't delay the pong and get the connection dropped.
+    [self _sendFrameWithOpcode:SROpCodePong data:data];
+
+    [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate> _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        if (availableMethods.didReceivePing) {
+            [delegate webSocket:self didReceivePingWithData:data];
+        }
+    }];
 }
 
-- (void)_handleFrameWithData:(NSData *)frameData opCode:(SROpCode)opcode
+- (void)handlePong:(NSData *)pongData
 {
-    // Check that the current data is valid UTF8
+    SRDebugLog(@"Received pong");
+    if ([self _handleKeepalivePong:pongData]) {
+        return;
+    }
+    [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        if (availableMethods.didReceivePong) {
+            [delegate webSocket:self didReceivePong:pongData];
+        }
+    }];
+}
 
-    BOOL isControlFrame = (opcode == SROpCodePing || opcode == SROpCodePong || opcode == SROpCodeConnectionClose);
+///--------------------------------------
+#pragma mark - Timeouts
+///--------------------------------------
+
+- (void)_scheduleIdleTimeoutWithDelay:(NSTimeInterval)delay
+{
+    [self assertOnWorkQueue];
+
+    if (_idleTimeout <= 0) {
+        return;
+    }
+
+    // Reads only record their time, the timer checks it when it fires, instead of being re-armed on every read.
+    __weak typeof(self) wself = self;
+    _idleTimeoutTimer = [[SRTimerWheel sharedWheel] scheduleTimerWithDelay:delay queue:_workQueue block:^{
+        __strong SRWebSocket *sself = wself;
+        if (!sself || sself.readyState != SR_OPEN) {
+            return;
+        }
+        NSTimeInterval idleTime = (NSTimeInterval)(SRMonotonicTimeNanoseconds() - sself->_lastReadTime) / NSEC_PER_SEC;
+        if (idleTime < sself->_idleTimeout) {
+            [sself _scheduleIdleTimeoutWithDelay:sself->_idleTimeout - idleTime];
+            return;
+        }
+        NSError *error = SRErrorWithDomainCodeDescription(NSURLErrorDomain, NSURLErrorTimedOut, @"Timed out waiting for data from server.");
+        [sself _failWithError:error];
+    }];
+}
+
+- (void)_scheduleCloseTimeout
+{
+    [self assertOnWorkQueue];
+
+    if (_closeTimeout <= 0 || _closeTimeoutTimer) {
+        return;
+    }
+
+    __weak typeof(self) wself = self;
+    _closeTimeoutTimer = [[SRTimerWheel sharedWheel] scheduleTimerWithDelay:_closeTimeout queue:_workQueue block:^{
+        __strong SRWebSocket *sself = wself;
+        if (!sself || sself.readyState == SR_CLOSED) {
+            return;
+        }
+        NSError *error = SRErrorWithDomainCodeDescription(NSURLErrorDomain, NSURLErrorTimedOut, @"Timed out waiting for server to close the connection.");
+        [sself _failWithError:error];
+    }];
+}
+
+- (void)_cancelTimers
+{
+    [self assertOnWorkQueue];
+
+    SRTimerWheel *timerWheel = [SRTimerWheel sharedWheel];
+    [timerWheel cancelTimer:_openTimeoutTimer];
+    [timerWheel cancelTimer:_closeTimeoutTimer];
+    [timerWheel cancelTimer:_idleTimeoutTimer];
+    [timerWheel cancelTimer:_keepalivePingTimer];
+    [timerWheel cancelTimer:_keepalivePongTimer];
+    [timerWheel cancelTimer:_metricsReportTimer];
+    _openTimeoutTimer = nil;
+    _closeTimeoutTimer = nil;
+    _idleTimeoutTimer = nil;
+    _keepalivePingTimer = nil;
+    _keepalivePongTimer = nil;
+    _metricsReportTimer = nil;
+}
+
+///--------------------------------------
+#pragma mark - Keepalive
+///--------------------------------------
+
+// Keepalive ping payload is the magic followed by the monotonic time the ping was sent at.
+static const uint8_t SRKeepalivePingMagic[4] = {'S', 'R', 'k', 'a'};
+
+- (void)_scheduleMetricsReport
+{
+    [self assertOnWorkQueue];
+
+    if (_metricsReportingInterval <= 0) {
+        return;
+    }
+
+    __weak typeof(self) wself = self;
+    _metricsReportTimer = [[SRTimerWheel sharedWheel] scheduleTimerWithDelay:_metricsReportingInterval queue:_workQueue block:^{
+        __strong SRWebSocket *sself = wself;
+        if (!sself || sself.readyState != SR_OPEN) {
+            return;
+        }
+        SRWebSocketMetrics *metrics = sself.metrics;
+        [sself.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+            if (availableMethods.didReportMetrics) {
+                [delegate webSocket:sself didReportMetrics:metrics];
+            }
+        }];
+        [sself _scheduleMetricsReport];
+    }];
+}
+
+- (void)_scheduleKeepalivePing
+{
+    [self assertOnWorkQueue];
+
+    if (_pingInterval <= 0) {
+        return;
+    }
+
+    __weak typeof(self) wself = self;
+    _keepalivePingTimer = [[SRTimerWheel sharedWheel] scheduleTimerWithDelay:_pingInterval queue:_workQueue block:^{
+        [wself _sendKeepalivePing];
+    }];
+}
+
+- (void)_sendKeepalivePing
+{
+    [self assertOnWorkQueue];
+
+    if (self.readyState != SR_OPEN) {
+        return;
+    }
+
+    uint8_t payload[sizeof(SRKeepalivePingMagic) + sizeof(uint64_t)];
+    uint64_t sendTime = SRMonotonicTimeNanoseconds();
+    memcpy(payload, SRKeepalivePingMagic, sizeof(SRKeepalivePingMagic));
+    memcpy(payload + sizeof(SRKeepalivePingMagic), &sendTime, sizeof(sendTime));
+    [self _sendFrameWithOpcode:SROpCodePing data:[NSData dataWithBytes:payload length:sizeof(payload)]];
+
+    __weak typeof(self) wself = self;
+    _keepalivePongTimer = [[SRTimerWheel sharedWheel] scheduleTimerWithDelay:_pongTimeout queue:_workQueue block:^{
+        __strong SRWebSocket *sself = wself;
+        if (!sself || sself.readyState != SR_OPEN) {
+            return;
+        }
+        [sself _failWithError:SRErrorWithCodeDescription(2147, @"Timed out waiting for pong to a keepalive ping.")];
+    }];
+}
+
+// Returns `YES` if the pong was sent in response to a keepalive ping.
+- (BOOL)_handleKeepalivePong:(NSData *)pongData
+{
+    [self assertOnWorkQueue];
+
+    if (pongData.length != sizeof(SRKeepalivePingMagic) + sizeof(uint64_t) ||
+        memcmp(pongData.bytes, SRKeepalivePingMagic, sizeof(SRKeepalivePingMagic)) != 0) {
+        return NO;
+    }
+
+    uint64_t sendTime = 0;
+    memcpy(&sendTime, (const uint8_t *)pongData.bytes + sizeof(SRKeepalivePingMagic), sizeof(sendTime));
+    uint64_t now = SRMonotonicTimeNanoseconds();
+    if (sendTime > now) {
+        return NO;
+    }
+    uint64_t roundTripTime = now - sendTime;
+
+    // Same estimators as TCP retransmission timer (RFC 6298).
+    uint64_t smoothedRoundTripTime = atomic_load_explicit(&_smoothedRoundTripTime, memory_order_relaxed);
+    uint64_t jitter = atomic_load_explicit(&_roundTripTimeJitter, memory_order_relaxed);
+    uint64_t minimumRoundTripTime = atomic_load_explicit(&_minimumRoundTripTime, memory_order_relaxed);
+    if (smoothedRoundTripTime == 0) {
+        smoothedRoundTripTime = roundTripTime;
+        jitter = roundTripTime / 2;
+        minimumRoundTripTime = roundTripTime;
+    } else {
+        uint64_t deviation = (smoothedRoundTripTime > roundTripTime ?
+                              smoothedRoundTripTime - roundTripTime :
+                              roundTripTime - smoothedRoundTripTime);
+        jitter = (3 * jitter + deviation) / 4;
+        smoothedRoundTripTime = (7 * smoothedRoundTripTime + roundTripTime) / 8;
+        minimumRoundTripTime = MIN(minimumRoundTripTime, roundTripTime);
+    }
+    atomic_store_explicit(&_smoothedRoundTripTime, smoothedRoundTripTime, memory_order_relaxed);
+    atomic_store_explicit(&_roundTripTimeJitter, jitter, memory_order_relaxed);
+    atomic_store_explicit(&_minimumRoundTripTime, minimumRoundTripTime, memory_order_relaxed);
+
+    [[SRTimerWheel sharedWheel] cancelTimer:_keepalivePongTimer];
+    _keepalivePongTimer = nil;
+    [self _scheduleKeepalivePing];
+
+    return YES;
+}
+
+
+- (SRWebSocketMetrics *)metrics
+{
+    return [_metricsRecorder metrics];
+}
+
++ (SRWebSocketMetrics *)aggregateMetrics
+{
+    return [SRMetricsRecorder aggregateMetrics];
+}
+
++ (NSData *)traceEventJSONData
+{
+    return SRTraceCopyChromeTraceJSON();
+}
+
++ (SRLogLevel)logLevel
+{
+    return (SRLogLevel)atomic_load_explicit(&SRLogRuntimeLevel, memory_order_relaxed);
+}
+
++ (void)setLogLevel:(SRLogLevel)logLevel
+{
+    atomic_store_explicit(&SRLogRuntimeLevel, (int)logLevel, memory_order_relaxed);
+}
+
++ (nullable SRLogSink)logSink
+{
+    return SRLogGetSink();
+}
+
++ (void)setLogSink:(nullable SRLogSink)logSink
+{
+    SRLogSetSink(logSink);
+}
+
+- (SRHandshakeTimeline)handshakeTimeline
+{
+    return [_metricsRecorder metrics].handshakeTimeline;
+}
+
+- (NSTimeInterval)smoothedRoundTripTime
+{
+    return (NSTimeInterval)atomic_load_explicit(&_smoothedRoundTripTime, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+- (NSTimeInterval)minimumRoundTripTime
+{
+    return (NSTimeInterval)atomic_load_explicit(&_minimumRoundTripTime, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+- (NSTimeInterval)roundTripTimeJitter
+{
+    return (NSTimeInterval)atomic_load_explicit(&_roundTripTimeJitter, memory_order_relaxed) / NSEC_PER_SEC;
+}
+
+
+static inline BOOL closeCodeIsValid(int closeCode) {
+    if (closeCode < 1000) {
+        return NO;
+    }
+
+    if (closeCode >= 1000 && closeCode <= 1011) {
+        if (closeCode == 1004 ||
+            closeCode == 1005 ||
+            closeCode == 1006) {
+            return NO;
+        }
+        return YES;
+    }
+
+    if (closeCode >= 3000 && closeCode <= 3999) {
+        return YES;
+    }
+
+    if (closeCode >= 4000 && closeCode <= 4999) {
+        return YES;
+    }
+
+    return NO;
+}
+
+//  Note from RFC:
+//
+//  If there is a body, the first two
+//  bytes of the body MUST be a 2-byte unsigned integer (in network byte
+//  order) representing a status code with value /code/ defined in
+//  Section 7.4.  Following the 2-byte integer the body MAY contain UTF-8
+//  encoded data with value /reason/, the interpretation of which is not
+//  defined by this specification.
+
+- (void)handleCloseWithData:(NSData *)data
+{
+    size_t dataSize = data.length;
+    __block uint16_t closeCode = 0;
+
+    SRDebugLog(@"Received close frame");
+
+    if (dataSize == 1) {
+        // TODO handle error
+        [self _closeWithProtocolError:@"Payload for close must be larger than 2 bytes"];
+        return;
+    } else if (dataSize >= 2) {
+        [data getBytes:&closeCode length:sizeof(closeCode)];
+        _closeCode = CFSwapInt16BigToHost(closeCode);
+        if (!closeCodeIsValid(_closeCode)) {
+            [self _closeWithProtocolError:[NSString stringWithFormat:@"Cannot have close code of %d", _closeCode]];
+            return;
+        }
+        if (dataSize > 2) {
+            _closeReason = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(2, dataSize - 2)] encoding:NSUTF8StringEncoding];
+            if (!_closeReason) {
+                [self _closeWithProtocolError:@"Close reason MUST be valid UTF-8"];
+                return;
+            }
+        }
+    } else {
+        _closeCode = SRStatusNoStatusReceived;
+    }
+
+    [self assertOnWorkQueue];
+
+    if (self.readyState == SR_OPEN) {
+        [self closeWithCode:1000 reason:nil];
+    }
+    dispatch_async(_workQueue, ^{
+        [self closeConnection];
+    });
+}
+
+- (void)closeConnection
+{
+    [self assertOnWorkQueue];
+    SRDebugLog(@"Trying to disconnect");
+    _closeWhenFinishedWriting = YES;
+    [self _pumpWriting];
+}
+
+// Everything before `_currentStringScanPosition` was already validated while the message was read.
+- (BOOL)_isValidUTF8Tail:(nullable NSData *)frameData
+{
+    NSUInteger length = frameData.length;
+    if (_currentStringScanPosition >= length) {
+        return YES;
+    }
+    const char *tail = (const char *)frameData.bytes + _currentStringScanPosition;
+    NSString *string = [[NSString alloc] initWithBytesNoCopy:(void *)tail
+                                                      length:length - _currentStringScanPosition
+                                                    encoding:NSUTF8StringEncoding
+                                                freeWhenDone:NO];
+    return (string != nil);
+}
+
+- (void)_handleFrameWithData:(NSData *)frameData opCode:(SROpCode)opcode
+{
+    // Check that the current data is valid UTF8
+
+    BOOL isControlFrame = (opcode == SROpCodePing || opcode == SROpCodePong || opcode == SROpCodeConnectionClose);
     if (isControlFrame) {
         //frameData will be copied before passing to handlers
         //otherwise there can be misbehaviours when value at the pointer is changed
         frameData = [frameData copy];
-
-        dispatch_async(_workQueue, ^{
-            [self _readFrameContinue];
-        });
     } else {
-        [self _readFrameNew];
+        SRMetricsPeak(&_metricsRecorder->_counters.peakFrameDataLength, frameData.length);
+        _currentMessageLastByteTime = _lastReadTime;
+        if (_currentFrameCount > 1) {
+            SRMetricsAdd(&_metricsRecorder->_counters.fragmentsReassembled, _currentFrameCount);
+        }
     }
 
     switch (opcode) {
         case SROpCodeTextFrame: {
+            // Decoder consumes raw bytes, so there is no need to create a string.
+            // Streaming validation leaves an incomplete trailing code point unscanned, it has to be valid once the message is complete.
+            if (_messageDecoderBlock && _decodesTextMessagesAsData && !_receivesMessagesOnDemand) {
+                if (![self _isValidUTF8Tail:frameData]) {
+                    [self closeWithCode:SRStatusCodeInvalidUTF8 reason:@"Text frames must be valid UTF-8."];
+                    dispatch_async(_workQueue, ^{
+                        [self closeConnection];
+                    });
+                    break;
+                }
+                SRDebugLog(@"Received text message.");
+                [self _decodeReceivedMessage:(frameData ?: [NSData data]) length:frameData.length];
+                break;
+            }
             NSString *string = [[NSString alloc] initWithData:frameData encoding:NSUTF8StringEncoding];
+            SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, MessageString, string, 0);
             if (!string && frameData) {
                 [self closeWithCode:SRStatusCodeInvalidUTF8 reason:@"Text frames must be valid UTF-8."];
                 dispatch_async(_workQueue, ^{
                     [self closeConnection];
                 });
-                return;
+                break;
             }
             SRDebugLog(@"Received text message.");
-            [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+            if (_receivesMessagesOnDemand) {
+                [self _enqueueReceivedMessage:string length:frameData.length];
+                break;
+            }
+            if (_messageDecoderBlock) {
+                [self _decodeReceivedMessage:string length:frameData.length];
+                break;
+            }
+            if (self.delegateController.availableDelegateMethods.didReceiveMessageWithMetadata) {
+                [self _reportMessageWithMetadata:string frameData:frameData opCode:opcode];
+                break;
+            }
+            if (self.delegateController.availableDelegateMethods.didReceiveMessages) {
+                [self _addMessageToBatch:string frameData:frameData];
+                break;
+            }
+            [self _performDelegateBlockForReceivedMessage:string length:frameData.length block:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
                 // Don't convert into string - iff `delegate` tells us not to. Otherwise - create UTF8 string and handle that.
                 if (availableMethods.shouldConvertTextFrameToString && ![delegate webSocketShouldConvertTextFrameToString:self]) {
                     if (availableMethods.didReceiveMessage) {
@@ -838,7 +1546,23 @@ static inline BOOL closeCodeIsValid(int closeCode) {
         }
         case SROpCodeBinaryFrame: {
             SRDebugLog(@"Received data message.");
-            [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+            if (_receivesMessagesOnDemand) {
+                [self _enqueueReceivedMessage:frameData length:frameData.length];
+                break;
+            }
+            if (_messageDecoderBlock) {
+                [self _decodeReceivedMessage:frameData length:frameData.length];
+                break;
+            }
+            if (self.delegateController.availableDelegateMethods.didReceiveMessageWithMetadata) {
+                [self _reportMessageWithMetadata:frameData frameData:nil opCode:opcode];
+                break;
+            }
+            if (self.delegateController.availableDelegateMethods.didReceiveMessages) {
+                [self _addMessageToBatch:frameData frameData:nil];
+                break;
+            }
+            [self _performDelegateBlockForReceivedMessage:frameData length:frameData.length block:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
                 if (availableMethods.didReceiveMessage) {
                     [delegate webSocket:self didReceiveMessage:frameData];
                 }
@@ -849,12 +1573,15 @@ static inline BOOL closeCodeIsValid(int closeCode) {
         }
             break;
         case SROpCodeConnectionClose:
+            [self _flushMessageBatch];
             [self handleCloseWithData:frameData];
             break;
         case SROpCodePing:
+            [self _flushMessageBatch];
             [self _handlePingWithData:frameData];
             break;
         case SROpCodePong:
+            [self _flushMessageBatch];
             [self handlePong:frameData];
             break;
         default:
@@ -862,6 +1589,14 @@ static inline BOOL closeCodeIsValid(int closeCode) {
             // TODO: Handle invalid opcode
             break;
     }
+
+    // The scanner picks up the next frame once this one is handled, in the same pass,
+    // so all frames of a single read are reported before the message batch is flushed.
+    if (isControlFrame) {
+        [self _readFrameContinue];
+    } else {
+        [self _readFrameNew];
+    }
 }
 
 - (void)_handleFrameHeader:(frame_header)frame_header curData:(NSData *)curData
@@ -888,6 +1623,9 @@ static inline BOOL closeCodeIsValid(int closeCode) {
     if (!isControlFrame) {
         _currentFrameOpcode = frame_header.opcode;
         _currentFrameCount += 1;
+        if (_currentFrameCount == 1) {
+            _currentMessageFirstByteTime = _lastReadTime;
+        }
     }
 
     if (frame_header.payload_length == 0) {
@@ -940,18 +1678,12 @@ static inline BOOL closeCodeIsValid(int closeCode) {
  +---------------------------------------------------------------+
  */
 
-static const uint8_t SRFinMask          = 0x80;
-static const uint8_t SROpCodeMask       = 0x0F;
-static const uint8_t SRRsvMask          = 0x70;
-static const uint8_t SRMaskMask         = 0x80;
-static const uint8_t SRPayloadLenMask   = 0x7F;
-
-
 - (void)_readFrameContinue
 {
     assert((_currentFrameCount == 0 && _currentFrameOpcode == 0) || (_currentFrameCount > 0 && _currentFrameOpcode > 0));
 
     [self _addConsumerWithDataLength:2 callback:^(SRWebSocket *sself, NSData *data) {
+        SR_TRACE_BEGIN(HeaderParse);
         __block frame_header header = {0};
 
         const uint8_t *headerBuffer = data.bytes;
@@ -975,6 +1707,7 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
             [sself _closeWithProtocolError:@"cannot continue a message"];
             return;
         }
+        SRMetricsAdd(&sself->_metricsRecorder->_counters.framesReceived[receivedOpcode], 1);
 
         header.opcode = receivedOpcode == 0 ? sself->_currentFrameOpcode : receivedOpcode;
 
@@ -992,12 +1725,9 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
         }
 
         size_t extra_bytes_needed = header.masked ? sizeof(sself->_currentReadMaskKey) : 0;
+        extra_bytes_needed += SRFrameHeaderExtendedLengthSize((uint8_t)header.payload_length);
 
-        if (header.payload_length == 126) {
-            extra_bytes_needed += sizeof(uint16_t);
-        } else if (header.payload_length == 127) {
-            extra_bytes_needed += sizeof(uint64_t);
-        }
+        SR_TRACE_END(HeaderParse, data.length);
 
         if (extra_bytes_needed == 0) {
             [sself _handleFrameHeader:header curData:sself->_currentFrameData];
@@ -1006,27 +1736,9 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
                 size_t mapped_size = edata.length;
 #pragma unused (mapped_size)
                 const void *mapped_buffer = edata.bytes;
-                size_t offset = 0;
-
-                if (header.payload_length == 126) {
-                    assert(mapped_size >= sizeof(uint16_t));
-                    uint16_t payloadLength = 0;
-                    memcpy(&payloadLength, mapped_buffer, sizeof(uint16_t));
-                    payloadLength = CFSwapInt16BigToHost(payloadLength);
-
-                    header.payload_length = payloadLength;
-                    offset += sizeof(uint16_t);
-                } else if (header.payload_length == 127) {
-                    assert(mapped_size >= sizeof(uint64_t));
-                    uint64_t payloadLength = 0;
-                    memcpy(&payloadLength, mapped_buffer, sizeof(uint64_t));
-                    payloadLength = CFSwapInt64BigToHost(payloadLength);
-
-                    header.payload_length = payloadLength;
-                    offset += sizeof(uint64_t);
-                } else {
-                    assert(header.payload_length < 126 && header.payload_length >= 0);
-                }
+                size_t offset = SRFrameHeaderExtendedLengthSize((uint8_t)header.payload_length);
+                assert(mapped_size >= offset);
+                header.payload_length = SRFrameHeaderReadExtendedLength(mapped_buffer, (uint8_t)header.payload_length);
 
                 if (header.masked) {
                     assert(mapped_size >= sizeof(eself->_currentReadMaskOffset) + offset);
@@ -1041,24 +1753,37 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
 
 - (void)_readFrameNew
 {
-    dispatch_async(_workQueue, ^{
-        // Don't reset the length, since Apple doesn't guarantee that this will free the memory (and in tests on
-        // some platforms, it doesn't seem to, effectively causing a leak the size of the biggest frame so far).
-        self->_currentFrameData = [[NSMutableData alloc] init];
+    [self assertOnWorkQueue];
 
-        self->_currentFrameOpcode = 0;
-        self->_currentFrameCount = 0;
-        self->_readOpCount = 0;
-        self->_currentStringScanPosition = 0;
+    // Don't reset the length, since Apple doesn't guarantee that this will free the memory (and in tests on
+    // some platforms, it doesn't seem to, effectively causing a leak the size of the biggest frame so far).
+    _currentFrameData = [[NSMutableData alloc] init];
+    SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, FrameData, _currentFrameData, 0);
 
-        [self _readFrameContinue];
-    });
+    _currentFrameOpcode = 0;
+    _currentFrameCount = 0;
+    _readOpCount = 0;
+    _currentStringScanPosition = 0;
+
+    [self _readFrameContinue];
 }
 
 - (void)_pumpWriting
 {
     [self assertOnWorkQueue];
 
+    [self _pumpConflationQueue];
+
+    if (_replaying) {
+        // Nothing to write to, sent frames are only reported to pending writes as if the peer took them.
+        _outputBytesWritten += dispatch_data_get_size(_outputBuffer) - _outputBufferOffset;
+        _outputBuffer = dispatch_data_empty;
+        _outputBufferOffset = 0;
+        if (_pendingWrites.count) {
+            [self _updatePendingWrites];
+        }
+    }
+
     NSUInteger dataLength = dispatch_data_get_size(_outputBuffer);
     if (dataLength - _outputBufferOffset > 0 && _outputStream.hasSpaceAvailable) {
         __block NSInteger bytesWritten = 0;
@@ -1066,11 +1791,15 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
 
         dispatch_data_t dataToSend = dispatch_data_create_subrange(_outputBuffer, _outputBufferOffset, dataLength - _outputBufferOffset);
         dispatch_data_apply(dataToSend, ^bool(dispatch_data_t region, size_t offset, const void *buffer, size_t size) {
+            SR_TRACE_BEGIN(Write);
             NSInteger sentLength = [_outputStream write:buffer maxLength:size];
+            SR_TRACE_END(Write, MAX(sentLength, 0));
+            SRMetricsAdd(&self->_metricsRecorder->_counters.writeCount, 1);
             if (sentLength == -1) {
                 streamFailed = YES;
                 return false;
             }
+            SRMetricsAdd(&self->_metricsRecorder->_counters.bytesSent, sentLength);
             bytesWritten += sentLength;
             return (sentLength >= (NSInteger)size); // If we can't write all the data into the stream - bail-out early.
         });
@@ -1084,17 +1813,31 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
         }
 
         _outputBufferOffset += bytesWritten;
+        _outputBytesWritten += bytesWritten;
+
+        if (_pendingWrites.count) {
+            [self _updatePendingWrites];
+        }
 
         if (_outputBufferOffset > SRDefaultBufferSize() && _outputBufferOffset > dataLength / 2) {
             _outputBuffer = dispatch_data_create_subrange(_outputBuffer, _outputBufferOffset, dataLength - _outputBufferOffset);
             _outputBufferOffset = 0;
         }
+
+        if (_conflationQueue.count && !_isPumpingConflationQueue &&
+            _outputBufferOffset == dispatch_data_get_size(_outputBuffer)) {
+            // The stream took everything we had, so it might not report available space again - keep draining.
+            dispatch_async(_workQueue, ^{
+                [self _pumpWriting];
+            });
+        }
     }
 
     if (_closeWhenFinishedWriting &&
         (dispatch_data_get_size(_outputBuffer) - _outputBufferOffset) == 0 &&
-        (_inputStream.streamStatus != NSStreamStatusNotOpen &&
-         _inputStream.streamStatus != NSStreamStatusClosed) &&
+        (_replaying ||
+         (_inputStream.streamStatus != NSStreamStatusNotOpen &&
+          _inputStream.streamStatus != NSStreamStatusClosed)) &&
         !_sentClose) {
         _sentClose = YES;
 
@@ -1131,14 +1874,19 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
     [self assertOnWorkQueue];
     assert(dataLength);
 
-    [_consumers addObject:[_consumerPool consumerWithScanner:nil handler:callback bytesNeeded:dataLength readToCurrentFrame:readToCurrentFrame unmaskBytes:unmaskBytes]];
+    SRIOConsumer *ioConsumer = [_consumerPool consumerWithScanner:nil handler:callback bytesNeeded:dataLength readToCurrentFrame:readToCurrentFrame unmaskBytes:unmaskBytes];
+    SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, ConsumerBlock, ioConsumer.handler, 0);
+    [_consumers addObject:ioConsumer];
     [self _pumpScanner];
 }
 
 - (void)_addConsumerWithScanner:(stream_scanner)consumer callback:(data_callback)callback dataLength:(size_t)dataLength
 {
     [self assertOnWorkQueue];
-    [_consumers addObject:[_consumerPool consumerWithScanner:consumer handler:callback bytesNeeded:dataLength readToCurrentFrame:NO unmaskBytes:NO]];
+    SRIOConsumer *ioConsumer = [_consumerPool consumerWithScanner:consumer handler:callback bytesNeeded:dataLength readToCurrentFrame:NO unmaskBytes:NO];
+    SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, ConsumerBlock, ioConsumer.consumer, 0);
+    SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, ConsumerBlock, ioConsumer.handler, 0);
+    [_consumers addObject:ioConsumer];
     [self _pumpScanner];
 }
 
@@ -1153,13 +1901,17 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
         _cleanupScheduled = YES;
 
         // Cleanup NSStream delegate's in the same RunLoop used by the streams themselves:
-        // This way we'll prevent race conditions between handleEvent and SRWebsocket's dealloc
-        NSTimer *timer = [NSTimer timerWithTimeInterval:(0.0f) target:self selector:@selector(_cleanupSelfReference:) userInfo:nil repeats:NO];
-        [[NSRunLoop SR_networkRunLoop] addTimer:timer forMode:NSDefaultRunLoopMode];
+        // This way we'll prevent race conditions between handleEvent and SRWebsocket's dealloc.
+        // Performing a block doesn't need a timer per socket, unlike scheduling a 0-second `NSTimer`.
+        CFRunLoopRef runLoop = [NSRunLoop SR_networkRunLoop].getCFRunLoop;
+        CFRunLoopPerformBlock(runLoop, kCFRunLoopDefaultMode, ^{
+            [self _cleanupSelfReference];
+        });
+        CFRunLoopWakeUp(runLoop);
     }
 }
 
-- (void)_cleanupSelfReference:(NSTimer *)timer
+- (void)_cleanupSelfReference
 {
     @synchronized(self) {
         // Nuke NSStream delegate's
@@ -1173,6 +1925,9 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
 
     // Cleanup selfRetain in the same GCD queue as usual
     dispatch_async(_workQueue, ^{
+        [self _failPendingWritesWithUnderlyingError:nil];
+        [self _completePendingReceives];
+        [self _cancelTimers];
         self->_selfRetain = nil;
     });
 }
@@ -1189,23 +1944,7 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
 {
     // TODO optimize so this can continue from where we last searched
     stream_scanner consumer = ^size_t(NSData *data) {
-        __block size_t found_size = 0;
-        __block size_t match_count = 0;
-
-        size_t size = data.length;
-        const unsigned char *buffer = data.bytes;
-        for (size_t i = 0; i < size; i++ ) {
-            if (((const unsigned char *)buffer)[i] == ((const unsigned char *)bytes)[match_count]) {
-                match_count += 1;
-                if (match_count == length) {
-                    found_size = i + 1;
-                    break;
-                }
-            } else {
-                match_count = 0;
-            }
-        }
-        return found_size;
+        return SRScanUntilBytes(data, bytes, length);
     };
     [self _addConsumerWithScanner:consumer callback:dataHandler];
 }
@@ -1238,6 +1977,10 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
     size_t foundSize = 0;
     if (consumer.consumer) {
         NSData *subdata = (NSData *)dispatch_data_create_subrange(_readBuffer, _readBufferOffset, readBufferSize - _readBufferOffset);
+        // Subrange of the whole buffer is the buffer itself, so it isn't an allocation.
+        if (subdata != (NSData *)_readBuffer) {
+            SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, DataSubrange, subdata, 0);
+        }
         foundSize = consumer.consumer(subdata);
     } else {
         assert(consumer.bytesNeeded);
@@ -1250,11 +1993,16 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
 
     if (consumer.readToCurrentFrame || foundSize) {
         dispatch_data_t slice = dispatch_data_create_subrange(_readBuffer, _readBufferOffset, foundSize);
+        if (slice != _readBuffer) {
+            SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, DataSubrange, slice, 0);
+        }
 
         _readBufferOffset += foundSize;
 
         if (_readBufferOffset > SRDefaultBufferSize() && _readBufferOffset > readBufferSize / 2) {
-            _readBuffer = dispatch_data_create_subrange(_readBuffer, _readBufferOffset, readBufferSize - _readBufferOffset);
+            dispatch_data_t unreadBuffer = dispatch_data_create_subrange(_readBuffer, _readBufferOffset, readBufferSize - _readBufferOffset);
+            SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, DataSubrange, unreadBuffer, 0);
+            _readBuffer = unreadBuffer;
             _readBufferOffset = 0;
         }
 
@@ -1275,10 +2023,12 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
         }
 
         if (consumer.readToCurrentFrame) {
+            SR_TRACE_BEGIN(PayloadConsume);
             dispatch_data_apply(slice, ^bool(dispatch_data_t region, size_t offset, const void *buffer, size_t size) {
                 [_currentFrameData appendBytes:buffer length:size];
                 return true;
             });
+            SR_TRACE_END(PayloadConsume, foundSize);
 
             _readOpCount += 1;
 
@@ -1290,8 +2040,11 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
 
                     size_t scanSize = currentDataSize - _currentStringScanPosition;
 
+                    SR_TRACE_BEGIN(UTF8Validation);
                     NSData *scan_data = [_currentFrameData subdataWithRange:NSMakeRange(_currentStringScanPosition, scanSize)];
-                    int32_t valid_utf8_size = validate_dispatch_data_partial_string(scan_data);
+                    SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, DataSubrange, scan_data, scanSize);
+                    int32_t valid_utf8_size = SRValidUTF8Length(scan_data);
+                    SR_TRACE_END(UTF8Validation, scanSize);
 
                     if (valid_utf8_size == -1) {
                         [self closeWithCode:SRStatusCodeInvalidUTF8 reason:@"Text frames must be valid UTF-8"];
@@ -1341,76 +2094,99 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
     _isPumping = NO;
 }
 
-//#define NOMASK
-
-static const size_t SRFrameHeaderOverhead = 32;
-
-- (void)_sendFrameWithOpcode:(SROpCode)opCode data:(NSData *)data
+- (void)_addMessageToBatch:(id)message frameData:(nullable NSData *)frameData
 {
     [self assertOnWorkQueue];
 
-    if (!data) {
-        return;
+    if (!_messageBatch) {
+        _messageBatch = [[NSMutableArray alloc] init];
+        _messageBatchFrames = [[NSMutableArray alloc] init];
     }
+    [_messageBatch addObject:message];
+    [_messageBatchFrames addObject:frameData ?: [NSNull null]];
+    NSData *messageData = frameData ?: message;
+    _messageBatchLength += messageData.length;
 
-    size_t payloadLength = data.length;
-
-    NSMutableData *frameData = [[NSMutableData alloc] initWithLength:payloadLength + SRFrameHeaderOverhead];
-    if (!frameData) {
-        [self closeWithCode:SRStatusCodeMessageTooBig reason:@"Message too big"];
-        return;
+    if (_messageBatch.count >= _maximumMessageBatchCount || _messageBatchLength >= _maximumMessageBatchLength) {
+        [self _flushMessageBatch];
     }
-    uint8_t *frameBuffer = (uint8_t *)frameData.mutableBytes;
-
-    // set fin
-    frameBuffer[0] = SRFinMask | opCode;
-
-    // set the mask and header
-    frameBuffer[1] |= SRMaskMask;
+}
 
-    size_t frameBufferSize = 2;
+- (void)_flushMessageBatch
+{
+    [self assertOnWorkQueue];
 
-    if (payloadLength < 126) {
-        frameBuffer[1] |= payloadLength;
-    } else {
-        uint64_t declaredPayloadLength = 0;
-        size_t declaredPayloadLengthSize = 0;
+    if (_messageBatch.count == 0) {
+        return;
+    }
 
-        if (payloadLength <= UINT16_MAX) {
-            frameBuffer[1] |= 126;
+    NSArray *messages = _messageBatch;
+    NSArray *frames = _messageBatchFrames;
+    NSUInteger messagesLength = _messageBatchLength;
+    _messageBatch = nil;
+    _messageBatchFrames = nil;
+    _messageBatchLength = 0;
+
+    [self _performDelegateBlockForReceivedMessageCount:messages.count length:messagesLength block:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        NSArray *deliveredMessages = messages;
+        // Don't convert into string - iff `delegate` tells us not to, asking once per batch.
+        if (availableMethods.shouldConvertTextFrameToString && ![delegate webSocketShouldConvertTextFrameToString:self]) {
+            NSMutableArray *dataMessages = [NSMutableArray arrayWithCapacity:messages.count];
+            [messages enumerateObjectsUsingBlock:^(id message, NSUInteger index, BOOL *stop) {
+                id frameData = frames[index];
+                [dataMessages addObject:(frameData == [NSNull null] ? message : frameData)];
+            }];
+            deliveredMessages = dataMessages;
+        }
 
-            declaredPayloadLength = CFSwapInt16BigToHost((uint16_t)payloadLength);
-            declaredPayloadLengthSize = sizeof(uint16_t);
-        } else {
-            frameBuffer[1] |= 127;
+        if (availableMethods.didReceiveMessages) {
+            [delegate webSocket:self didReceiveMessages:deliveredMessages];
+            return;
+        }
 
-            declaredPayloadLength = CFSwapInt64BigToHost((uint64_t)payloadLength);
-            declaredPayloadLengthSize = sizeof(uint64_t);
+        // Delegate changed since the messages were received, report them one by one.
+        for (id message in deliveredMessages) {
+            if (availableMethods.didReceiveMessage) {
+                [delegate webSocket:self didReceiveMessage:message];
+            }
+            if ([message isKindOfClass:[NSString class]]) {
+                if (availableMethods.didReceiveMessageWithString) {
+                    [delegate webSocket:self didReceiveMessageWithString:message];
+                }
+            } else if (availableMethods.didReceiveMessageWithData) {
+                [delegate webSocket:self didReceiveMessageWithData:message];
+            }
         }
+    }];
+}
 
-        memcpy((frameBuffer + frameBufferSize), &declaredPayloadLength, declaredPayloadLengthSize);
-        frameBufferSize += declaredPayloadLengthSize;
-    }
+- (void)_sendFrameWithOpcode:(SROpCode)opCode data:(NSData *)data
+{
+    [self _sendFrameWithOpcode:opCode data:data pendingWrite:nil];
+}
 
-    const uint8_t *unmaskedPayloadBuffer = (uint8_t *)data.bytes;
-    uint8_t *maskKey = frameBuffer + frameBufferSize;
-    
-    size_t randomBytesSize = sizeof(uint32_t);
-    NSData *randomData = SRRandomData(randomBytesSize);
-    [randomData getBytes:maskKey range:NSMakeRange(0, randomBytesSize)];
-    frameBufferSize += randomBytesSize;
+- (void)_sendFrameWithOpcode:(SROpCode)opCode data:(NSData *)data pendingWrite:(nullable SRPendingWrite *)pendingWrite
+{
+    [self assertOnWorkQueue];
 
-    // Copy and unmask the buffer
-    uint8_t *frameBufferPayloadPointer = frameBuffer + frameBufferSize;
+    // `sendData:` with `nil` has never written anything, but a completion shouldn't report that as sent.
+    if (!data) {
+        [pendingWrite completeWithError:SRErrorWithCodeDescription(2151, @"Nothing was sent, since the message has no data.")];
+        return;
+    }
 
-    memcpy(frameBufferPayloadPointer, unmaskedPayloadBuffer, payloadLength);
-    SRMaskBytesSIMD(frameBufferPayloadPointer, payloadLength, maskKey);
-    frameBufferSize += payloadLength;
+    SR_TRACE_BEGIN(FrameBuild);
+    NSData *frameData = SRFrameDataCreate(opCode, data);
+    SR_TRACE_END(FrameBuild, frameData.length);
+    [self _writeFrameData:frameData pendingWrite:pendingWrite];
+}
 
-    assert(frameBufferSize <= frameData.length);
-    frameData.length = frameBufferSize;
+- (void)_failMessageTooBigWithPendingWrite:(nullable SRPendingWrite *)pendingWrite
+{
+    [self assertOnWorkQueue];
 
-    [self _writeData:frameData];
+    [pendingWrite completeWithError:SRErrorWithCodeDescription(SRStatusCodeMessageTooBig, @"Message too big")];
+    [self closeWithCode:SRStatusCodeMessageTooBig reason:@"Message too big"];
 }
 
 - (void)stream:(NSStream *)aStream handleEvent:(NSStreamEvent)eventCode
@@ -1421,7 +2197,9 @@ static const size_t SRFrameHeaderOverhead = 32;
         (eventCode == NSStreamEventHasBytesAvailable || eventCode == NSStreamEventHasSpaceAvailable)) {
         SecTrustRef trust = (__bridge SecTrustRef)[aStream propertyForKey:(__bridge id)kCFStreamPropertySSLPeerTrust];
         if (trust) {
+            SRMetricsMarkHandshake(&_metricsRecorder->_counters, SRHandshakeMarkTLSEnd);
             _streamSecurityValidated = [_securityPolicy evaluateServerTrust:trust forDomain:_urlRequest.URL.host];
+            SRMetricsMarkHandshake(&_metricsRecorder->_counters, SRHandshakeMarkTrustEvaluationEnd);
         }
         if (!_streamSecurityValidated) {
             dispatch_async(_workQueue, ^{
@@ -1473,29 +2251,12 @@ static const size_t SRFrameHeaderOverhead = 32;
 
         case NSStreamEventEndEncountered: {
             [self _pumpScanner];
+            [self _flushMessageBatch];
             SRDebugLog(@"NSStreamEventEndEncountered %@", aStream);
             if (aStream.streamError) {
                 [self _failWithError:aStream.streamError];
             } else {
-                dispatch_async(_workQueue, ^{
-                    if (self.readyState != SR_CLOSED) {
-                        self.readyState = SR_CLOSED;
-                        [self _scheduleCleanup];
-                    }
-
-                    if (!self->_sentClose && !self->_failed) {
-                        self->_sentClose = YES;
-                        // If we get closed in this state it's probably not clean because we should be sending this when we send messages
-                        [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
-                            if (availableMethods.didCloseWithCode) {
-                                [delegate webSocket:self
-                                   didCloseWithCode:SRStatusCodeGoingAway
-                                             reason:@"Stream end encountered"
-                                           wasClean:NO];
-                            }
-                        }];
-                    }
-                });
+                [self _didEndReading];
             }
 
             break;
@@ -1503,24 +2264,7 @@ static const size_t SRFrameHeaderOverhead = 32;
 
         case NSStreamEventHasBytesAvailable: {
             SRDebugLog(@"NSStreamEventHasBytesAvailable %@", aStream);
-            uint8_t buffer[SRDefaultBufferSize()];
-
-            while (_inputStream.hasBytesAvailable) {
-                NSInteger bytesRead = [_inputStream read:buffer maxLength:SRDefaultBufferSize()];
-                if (bytesRead > 0) {
-                    dispatch_data_t data = dispatch_data_create(buffer, bytesRead, nil, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
-                    if (!data) {
-                        NSError *error = SRErrorWithCodeDescription(SRStatusCodeMessageTooBig,
-                                                                    @"Unable to allocate memory to read from socket.");
-                        [self _failWithError:error];
-                        return;
-                    }
-                    _readBuffer = dispatch_data_create_concat(_readBuffer, data);
-                } else if (bytesRead == -1) {
-                    [self _failWithError:_inputStream.streamError];
-                }
-            }
-            [self _pumpScanner];
+            [self _readFromInputStream];
             break;
         }
 
@@ -1536,105 +2280,522 @@ static const size_t SRFrameHeaderOverhead = 32;
     }
 }
 
+- (void)_didEndReading
+{
+    dispatch_async(_workQueue, ^{
+        [self _failPendingWritesWithUnderlyingError:nil];
+
+        if (self.readyState != SR_CLOSED) {
+            self.readyState = SR_CLOSED;
+            [self _scheduleCleanup];
+        }
+        [self _completePendingReceives];
+
+        if (!self->_sentClose && !self->_failed) {
+            self->_sentClose = YES;
+            // If we get closed in this state it's probably not clean because we should be sending this when we send messages
+            [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+                if (availableMethods.didCloseWithCode) {
+                    [delegate webSocket:self
+                       didCloseWithCode:SRStatusCodeGoingAway
+                                 reason:@"Stream end encountered"
+                               wasClean:NO];
+                }
+            }];
+        }
+    });
+}
+
+- (void)_appendToReadBuffer:(dispatch_data_t)data
+{
+    SRMetricsAdd(&_metricsRecorder->_counters.bytesReceived, dispatch_data_get_size(data));
+    [_capture recordReceivedData:data];
+    dispatch_data_t readBuffer = dispatch_data_create_concat(_readBuffer, data);
+    // Concatenating to empty data returns the other data, which isn't an allocation.
+    if (readBuffer != _readBuffer && readBuffer != data) {
+        SR_AUDIT_ALLOCATION(&_metricsRecorder->_counters, DataConcatenation, readBuffer, 0);
+    }
+    _readBuffer = readBuffer;
+    SRMetricsPeak(&_metricsRecorder->_counters.peakReadBufferLength, dispatch_data_get_size(_readBuffer));
+}
+
+- (void)_readFromInputStream
+{
+    [self assertOnWorkQueue];
+
+    uint8_t buffer[SRDefaultBufferSize()];
+
+    while (_inputStream.hasBytesAvailable) {
+        // Leave the rest in the stream, so TCP flow control pushes back on the server.
+        if ([self _shouldPauseReading]) {
+            [self _pauseReading];
+            break;
+        }
+
+        SR_TRACE_BEGIN(Read);
+        NSInteger bytesRead = [_inputStream read:buffer maxLength:SRDefaultBufferSize()];
+        SR_TRACE_END(Read, MAX(bytesRead, 0));
+        SRMetricsAdd(&_metricsRecorder->_counters.readCount, 1);
+        if (bytesRead > 0) {
+            _lastReadTime = SRMonotonicTimeNanoseconds();
+            dispatch_data_t data = dispatch_data_create(buffer, bytesRead, nil, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+            if (!data) {
+                NSError *error = SRErrorWithCodeDescription(SRStatusCodeMessageTooBig,
+                                                            @"Unable to allocate memory to read from socket.");
+                [self _failWithError:error];
+                return;
+            }
+            [self _appendToReadBuffer:data];
+            // Frames are parsed while `_lastReadTime` is still the time of the read that carried their bytes.
+            [self _pumpScanner];
+        } else if (bytesRead == -1) {
+            [self _failWithError:_inputStream.streamError];
+            break;
+        }
+    }
+    // Everything decoded from this read is reported now, batches never wait for more data.
+    [self _flushMessageBatch];
+    [self _updateReceiveBacklogLength];
+
+    // Backlog might have drained on another thread before the pause became visible.
+    [self _resumeReadingIfNeeded];
+}
+
 ///--------------------------------------
-#pragma mark - Delegate
+#pragma mark - Capture Replay
 ///--------------------------------------
 
-- (id<SRWebSocketDelegate> _Nullable)delegate
+- (BOOL)replayCaptureFromURL:(NSURL *)url atRecordedSpeed:(BOOL)recordedSpeed error:(NSError **)error
 {
-    return self.delegateController.delegate;
+    NSAssert(self.readyState == SR_CONNECTING && !_selfRetain, @"Cannot replay a capture on an SRWebSocket that was opened.");
+    NSAssert(!dispatch_get_specific((__bridge void *)self), @"Cannot replay a capture on the work queue.");
+
+    // Received bytes before the open record hold the handshake response, which is skipped.
+    NSMutableData *handshakeData = [NSMutableData data];
+    __block BOOL opened = NO;
+    __block uint64_t openTimestamp = 0;
+    __block uint64_t replayStartTime = 0;
+
+    BOOL success = SRTrafficCaptureEnumerateRecords(url, error, ^(SRTrafficCaptureRecordType type, uint64_t timestamp, NSData *payload, BOOL *stop) {
+        if (!opened) {
+            if (type == SRTrafficCaptureRecordTypeReceived) {
+                [handshakeData appendData:payload];
+            } else if (type == SRTrafficCaptureRecordTypeOpen && payload.length == sizeof(uint64_t)) {
+                uint64_t handshakeLength = 0;
+                [payload getBytes:&handshakeLength length:sizeof(handshakeLength)];
+                handshakeLength = MIN(OSSwapLittleToHostInt64(handshakeLength), handshakeData.length);
+
+                opened = YES;
+                openTimestamp = timestamp;
+                replayStartTime = SRMonotonicTimeNanoseconds();
+                NSData *unreadData = [handshakeData subdataWithRange:NSMakeRange(handshakeLength, handshakeData.length - handshakeLength)];
+                dispatch_sync(self->_workQueue, ^{
+                    [self _replayDidOpen];
+                    [self _replayReceivedData:unreadData];
+                });
+            }
+            return;
+        }
+        if (type != SRTrafficCaptureRecordTypeReceived) {
+            return;
+        }
+
+        if (recordedSpeed && timestamp > openTimestamp) {
+            uint64_t elapsedTime = SRMonotonicTimeNanoseconds() - replayStartTime;
+            uint64_t recordedTime = timestamp - openTimestamp;
+            if (recordedTime > elapsedTime) {
+                [NSThread sleepForTimeInterval:(double)(recordedTime - elapsedTime) / NSEC_PER_SEC];
+            }
+        }
+        __block BOOL closed = NO;
+        dispatch_sync(self->_workQueue, ^{
+            [self _replayReceivedData:payload];
+            closed = (self.readyState == SR_CLOSED);
+        });
+        *stop = closed;
+    });
+    if (!success) {
+        return NO;
+    }
+    if (!opened) {
+        if (error) {
+            *error = SRErrorWithCodeDescription(2149, @"Capture doesn't contain an opened connection.");
+        }
+        return NO;
+    }
+
+    // Like the end of the input stream, everything that was captured is in.
+    dispatch_sync(_workQueue, ^{
+        [self _didEndReading];
+    });
+    return YES;
 }
 
-- (void)setDelegate:(id<SRWebSocketDelegate> _Nullable)delegate
+- (void)_replayDidOpen
 {
-    self.delegateController.delegate = delegate;
+    [self assertOnWorkQueue];
+
+    _replaying = YES;
+    _selfRetain = self;
+    self.readyState = SR_OPEN;
+    [self _readFrameNew];
+
+    [self.delegateController performDelegateBlock:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        if (availableMethods.didOpen) {
+            [delegate webSocketDidOpen:self];
+        }
+    }];
 }
 
-- (void)setDelegateDispatchQueue:(dispatch_queue_t _Nullable)queue
+- (void)_replayReceivedData:(NSData *)data
 {
-    self.delegateController.dispatchQueue = queue;
+    [self assertOnWorkQueue];
+
+    if (data.length == 0) {
+        return;
+    }
+    _lastReadTime = SRMonotonicTimeNanoseconds();
+    SRMetricsAdd(&_metricsRecorder->_counters.readCount, 1);
+
+    __block NSData *strongData = data;
+    dispatch_data_t readData = dispatch_data_create(data.bytes, data.length, nil, ^{
+        strongData = nil;
+    });
+    (void)strongData;
+    [self _appendToReadBuffer:readData];
+    [self _pumpScanner];
+    [self _flushMessageBatch];
+    [self _updateReceiveBacklogLength];
 }
 
-- (dispatch_queue_t _Nullable)delegateDispatchQueue
+///--------------------------------------
+#pragma mark - Receive On Demand
+///--------------------------------------
+
+- (void)receiveMessagesWithMaximumCount:(NSUInteger)maximumCount
+                        completionQueue:(nullable dispatch_queue_t)completionQueue
+                             completion:(SRReceiveCompletionHandler)completion
 {
-    return self.delegateController.dispatchQueue;
+    NSAssert(_receivesMessagesOnDemand, @"Cannot receive messages on demand unless `receivesMessagesOnDemand` is enabled.");
+
+    SRPendingReceive *pendingReceive = [[SRPendingReceive alloc] initWithMaximumCount:maximumCount
+                                                                                queue:completionQueue
+                                                                           completion:completion];
+    dispatch_async(_workQueue, ^{
+        [self->_pendingReceives addObject:pendingReceive];
+        [self _completePendingReceives];
+    });
 }
 
-- (void)setDelegateOperationQueue:(NSOperationQueue *_Nullable)queue
+- (void)_enqueueReceivedMessage:(id)message length:(NSUInteger)length
 {
-    self.delegateController.operationQueue = queue;
+    [self assertOnWorkQueue];
+
+    [_receivedMessages addObject:message];
+    [_receivedMessageLengths addObject:@(length)];
+    _receivedMessagesLength += length;
+    [self _completePendingReceives];
 }
 
-- (NSOperationQueue *_Nullable)delegateOperationQueue
+- (void)_completePendingReceives
 {
-    return self.delegateController.operationQueue;
-}
+    [self assertOnWorkQueue];
 
-@end
+    while (_pendingReceives.count > 0 && _receivedMessages.count > 0) {
+        SRPendingReceive *pendingReceive = _pendingReceives.firstObject;
+        [_pendingReceives removeObjectAtIndex:0];
 
-#ifdef HAS_ICU
+        NSRange range = NSMakeRange(0, MIN(pendingReceive.maximumCount, _receivedMessages.count));
+        NSArray *messages = [_receivedMessages subarrayWithRange:range];
+        for (NSNumber *length in [_receivedMessageLengths subarrayWithRange:range]) {
+            _receivedMessagesLength -= length.unsignedIntegerValue;
+        }
+        [_receivedMessages removeObjectsInRange:range];
+        [_receivedMessageLengths removeObjectsInRange:range];
 
-static inline int32_t validate_dispatch_data_partial_string(NSData *data) {
-    if ([data length] > INT32_MAX) {
-        // INT32_MAX is the limit so long as this Framework is using 32 bit ints everywhere.
-        return -1;
+        SRMetricsAdd(&_metricsRecorder->_counters.messagesDelivered, messages.count);
+        [pendingReceive completeWithMessages:messages error:nil];
     }
 
-    int32_t size = (int32_t)[data length];
+    // No more messages are coming, once everything that was received is handed out.
+    if (self.readyState == SR_CLOSED && _receivedMessages.count == 0 && _pendingReceives.count > 0) {
+        NSError *error = SRErrorWithCodeDescription(2148, @"Socket was closed, no more messages will be received.");
+        for (SRPendingReceive *pendingReceive in _pendingReceives) {
+            [pendingReceive completeWithMessages:@[] error:error];
+        }
+        [_pendingReceives removeAllObjects];
+    }
+
+    [self _updateReceiveBacklogLength];
+    [self _resumeReadingIfNeeded];
+}
+
+///--------------------------------------
+#pragma mark - Receive Flow Control
+///--------------------------------------
 
-    const void * contents = [data bytes];
-    const uint8_t *str = (const uint8_t *)contents;
+- (BOOL)_shouldPauseReading
+{
+    [self assertOnWorkQueue];
 
-    UChar32 codepoint = 1;
-    int32_t offset = 0;
-    int32_t lastOffset = 0;
-    while(offset < size && codepoint > 0)  {
-        lastOffset = offset;
-        U8_NEXT(str, offset, size, codepoint);
+    // Only pause while there are messages to drain, otherwise nothing would ever resume reading.
+    // This also lets a single message that is larger than the budget through.
+    size_t undecodedLength = [self _undecodedLength];
+    if (_receivesMessagesOnDemand) {
+        return (_receivedMessagesLength > 0 &&
+                _receivedMessagesLength + undecodedLength >= _maximumReceiveBacklogLength);
     }
 
-    if (codepoint == -1) {
-        // Check to see if the last byte is valid or whether it was just continuing
-        if (!U8_IS_LEAD(str[lastOffset]) || U8_COUNT_TRAIL_BYTES(str[lastOffset]) + lastOffset < (int32_t)size) {
+    uint_fast64_t backlogCount = atomic_load(&_delegateBacklogCount);
+    if (backlogCount == 0) {
+        return NO;
+    }
+    if (_maximumDelegateBacklogCount != 0 && backlogCount >= _maximumDelegateBacklogCount) {
+        return YES;
+    }
+    return (_maximumDelegateBacklogLength != 0 &&
+            atomic_load(&_delegateBacklogLength) + undecodedLength >= _maximumDelegateBacklogLength);
+}
 
-            size = -1;
-        } else {
-            uint8_t leadByte = str[lastOffset];
-            U8_MASK_LEAD_BYTE(leadByte, U8_COUNT_TRAIL_BYTES(leadByte));
+- (void)_pauseReading
+{
+    [self assertOnWorkQueue];
 
-            for (int i = lastOffset + 1; i < offset; i++) {
-                if (U8_IS_SINGLE(str[i]) || U8_IS_LEAD(str[i]) || !U8_IS_TRAIL(str[i])) {
-                    size = -1;
-                }
-            }
+    if (atomic_load(&_readingPaused)) {
+        return;
+    }
+    SRDebugLog(@"Pausing reading, receive backlog is full.");
+    atomic_store_explicit(&_readPauseStartTime, SRMonotonicTimeNanoseconds(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&_readPauseCount, 1, memory_order_relaxed);
+    atomic_store(&_readingPaused, true);
+}
 
-            if (size != -1) {
-                size = lastOffset;
-            }
+- (void)_resumeReadingIfNeeded
+{
+    [self assertOnWorkQueue];
+
+    if (!atomic_load(&_readingPaused) || [self _shouldPauseReading]) {
+        return;
+    }
+    SRDebugLog(@"Resuming reading, receive backlog drained.");
+    uint64_t pausedDuration = SRMonotonicTimeNanoseconds() - atomic_load_explicit(&_readPauseStartTime, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_readPausedDuration, pausedDuration, memory_order_relaxed);
+    atomic_store(&_readingPaused, false);
+
+    // Stream doesn't report bytes that were left in it again, so read them.
+    // Asynchronously, since the read can drain and resume again, which would otherwise recurse without bound.
+    dispatch_async(_workQueue, ^{
+        if (self.readyState == SR_OPEN || self.readyState == SR_CLOSING) {
+            [self _readFromInputStream];
         }
+    });
+}
+
+- (void)_performDelegateBlockForReceivedMessage:(id)message length:(NSUInteger)length block:(SRDelegateBlock)block
+{
+    [self assertOnWorkQueue];
+
+    SRDelegateBlock backlogBlock = [self _delegateBacklogBlockForMessageCount:1 length:length block:block];
+    if (_messageOrderingKeyBlock) {
+        [self.delegateController performDelegateBlock:backlogBlock orderingKey:_messageOrderingKeyBlock(message)];
+    } else {
+        [self.delegateController performDelegateBlock:backlogBlock];
     }
+}
+
+// `frameData` is only passed for text messages, to report it instead of the string if the delegate asks for that.
+- (void)_reportMessageWithMetadata:(id)message frameData:(nullable NSData *)frameData opCode:(SROpCode)opCode
+{
+    [self assertOnWorkQueue];
+
+    NSUInteger payloadLength = (frameData ?: (NSData *)message).length;
+    NSUInteger frameCount = _currentFrameCount;
+    uint64_t firstByteTime = _currentMessageFirstByteTime;
+    uint64_t lastByteTime = _currentMessageLastByteTime;
+    uint64_t queuedTime = SRMonotonicTimeNanoseconds();
+    [self _performDelegateBlockForReceivedMessage:message length:payloadLength block:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        id payload = message;
+        if (frameData && availableMethods.shouldConvertTextFrameToString && ![delegate webSocketShouldConvertTextFrameToString:self]) {
+            payload = frameData;
+        }
+        SRMessage *receivedMessage = [[SRMessage alloc] initWithPayload:payload
+                                                                 opCode:(SRMessageOpCode)opCode
+                                                          payloadLength:payloadLength
+                                                             frameCount:frameCount
+                                                             compressed:NO
+                                                          firstByteTime:firstByteTime
+                                                           lastByteTime:lastByteTime
+                                                             queuedTime:queuedTime];
+        if (availableMethods.didReceiveMessageWithMetadata) {
+            [delegate webSocket:self didReceiveMessageWithMetadata:receivedMessage];
+        }
+    }];
+}
+
+- (void)_decodeReceivedMessage:(id)message length:(NSUInteger)length
+{
+    [self assertOnWorkQueue];
 
-    if (size != -1 && ![[NSString alloc] initWithBytesNoCopy:(char *)[data bytes] length:size encoding:NSUTF8StringEncoding freeWhenDone:NO]) {
-        size = -1;
+    if (!_decodePipeline) {
+        _decodePipeline = [[SRDecodePipeline alloc] initWithDecoder:_messageDecoderBlock];
     }
 
-    return size;
+    // Ordering key and backlog are taken now, so flow control accounts for messages that are still being decoded.
+    BOOL ordered = (_messageOrderingKeyBlock != nil);
+    id orderingKey = (ordered ? _messageOrderingKeyBlock(message) : nil);
+    __block id decodedMessage = nil;
+    SRDelegateBlock backlogBlock = [self _delegateBacklogBlockForMessageCount:1 length:length block:^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        if (availableMethods.didReceiveDecodedMessage) {
+            [delegate webSocket:self didReceiveDecodedMessage:decodedMessage];
+        } else if (availableMethods.didReceiveMessage) {
+            [delegate webSocket:self didReceiveMessage:decodedMessage];
+        }
+    }];
+
+    [_decodePipeline decodeMessage:message completion:^(id _Nullable decoded) {
+        // Completions arrive in order on a private queue. Reporting from the work queue keeps delegate calls
+        // serialized with everything else the socket reports, which matters when they are called inline.
+        dispatch_async(self->_workQueue, ^{
+            if (!decoded) {
+                // Dropped by the decoder, it still has to leave the backlog.
+                backlogBlock(nil, (SRDelegateAvailableMethods){});
+                return;
+            }
+            decodedMessage = decoded;
+            if (ordered) {
+                [self.delegateController performDelegateBlock:backlogBlock orderingKey:orderingKey];
+            } else {
+                [self.delegateController performDelegateBlock:backlogBlock];
+            }
+        });
+    }];
 }
 
-#else
+- (void)_performDelegateBlockForReceivedMessageCount:(NSUInteger)count length:(NSUInteger)length block:(SRDelegateBlock)block
+{
+    [self assertOnWorkQueue];
+    [self.delegateController performDelegateBlock:[self _delegateBacklogBlockForMessageCount:count length:length block:block]];
+}
 
-// This is a hack, and probably not optimal
-static inline int32_t validate_dispatch_data_partial_string(NSData *data) {
-    static const int maxCodepointSize = 3;
+// Counts messages as dispatched and returns a block that counts them as handled once `block` returns.
+- (SRDelegateBlock)_delegateBacklogBlockForMessageCount:(NSUInteger)count length:(NSUInteger)length block:(SRDelegateBlock)block
+{
+    [self assertOnWorkQueue];
 
-    for (int i = 0; i < maxCodepointSize; i++) {
-        NSString *str = [[NSString alloc] initWithBytesNoCopy:(char *)data.bytes length:data.length - i encoding:NSUTF8StringEncoding freeWhenDone:NO];
-        if (str) {
-            return (int32_t)data.length - i;
+    atomic_fetch_add(&_delegateBacklogLength, length);
+    atomic_fetch_add(&_delegateBacklogCount, count);
+    return ^(id<SRWebSocketDelegate>  _Nullable delegate, SRDelegateAvailableMethods availableMethods) {
+        block(delegate, availableMethods);
+        SRMetricsAdd(&self->_metricsRecorder->_counters.messagesDelivered, count);
+
+        atomic_fetch_sub(&self->_delegateBacklogLength, length);
+        atomic_fetch_sub(&self->_delegateBacklogCount, count);
+        // Work queue is only bothered while it waits for the delegate to catch up.
+        // Pairs with `_pauseReading` followed by `_shouldPauseReading`, so either side observes the other.
+        if (atomic_load(&self->_readingPaused)) {
+            dispatch_async(self->_workQueue, ^{
+                [self _resumeReadingIfNeeded];
+            });
         }
+    };
+}
+
+- (size_t)_undecodedLength
+{
+    return dispatch_data_get_size(_readBuffer) - _readBufferOffset;
+}
+
+- (NSUInteger)_currentReceiveBacklogLength
+{
+    return _receivedMessagesLength + [self _undecodedLength] + _currentFrameData.length;
+}
+
+- (void)_updateReceiveBacklogLength
+{
+    atomic_store_explicit(&_receiveBacklogLength, [self _currentReceiveBacklogLength], memory_order_relaxed);
+}
+
+- (NSUInteger)receiveBacklogLength
+{
+    return (NSUInteger)atomic_load_explicit(&_receiveBacklogLength, memory_order_relaxed);
+}
+
+- (NSUInteger)delegateBacklogLength
+{
+    return (NSUInteger)atomic_load_explicit(&_delegateBacklogLength, memory_order_relaxed);
+}
+
+- (NSUInteger)delegateBacklogCount
+{
+    return (NSUInteger)atomic_load_explicit(&_delegateBacklogCount, memory_order_relaxed);
+}
+
+- (NSUInteger)readPauseCount
+{
+    return (NSUInteger)atomic_load_explicit(&_readPauseCount, memory_order_relaxed);
+}
+
+- (NSTimeInterval)readPausedDuration
+{
+    uint64_t duration = atomic_load_explicit(&_readPausedDuration, memory_order_relaxed);
+    if (atomic_load(&_readingPaused)) {
+        duration += SRMonotonicTimeNanoseconds() - atomic_load_explicit(&_readPauseStartTime, memory_order_relaxed);
     }
+    return (NSTimeInterval)duration / NSEC_PER_SEC;
+}
+
+///--------------------------------------
+#pragma mark - Delegate
+///--------------------------------------
 
-    return -1;
+- (id<SRWebSocketDelegate> _Nullable)delegate
+{
+    return self.delegateController.delegate;
 }
 
-#endif
+- (void)setDelegate:(id<SRWebSocketDelegate> _Nullable)delegate
+{
+    self.delegateController.delegate = delegate;
+}
+
+- (void)setDelegateDispatchQueue:(dispatch_queue_t _Nullable)queue
+{
+    self.delegateController.dispatchQueue = queue;
+}
+
+- (dispatch_queue_t _Nullable)delegateDispatchQueue
+{
+    return self.delegateController.dispatchQueue;
+}
+
+- (void)setDelegateOperationQueue:(NSOperationQueue *_Nullable)queue
+{
+    self.delegateController.operationQueue = queue;
+}
+
+- (NSOperationQueue *_Nullable)delegateOperationQueue
+{
+    return self.delegateController.operationQueue;
+}
+
+- (void)setCallsDelegateInline:(BOOL)callsDelegateInline
+{
+    self.delegateController.performsInline = callsDelegateInline;
+}
+
+- (BOOL)callsDelegateInline
+{
+    return self.delegateController.performsInline;
+}
+
+- (void)setConcurrentDeliveryWidth:(NSUInteger)concurrentDeliveryWidth
+{
+    self.delegateController.orderingLaneCount = MAX(concurrentDeliveryWidth, 1);
+}
+
+- (NSUInteger)concurrentDeliveryWidth
+{
+    return self.delegateController.orderingLaneCount;
+}
+
+@end
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Timestamps of the phases of opening a socket, from `open` until the handshake response headers are complete.
+
+ All values are in nanoseconds from the monotonic clock used by `clock_gettime_nsec_np(CLOCK_UPTIME_RAW)`.
+ A value of `0` means that the phase didn't happen, for example there is no proxy configured or the socket failed earlier.
+ Streams resolve the host and connect in a single step, so DNS resolution is part of the connect phase.
+ */
+typedef struct {
+    /** Time when `open` was called and proxy resolution started. */
+    uint64_t openTime;
+    /** Time when fetching the proxy auto-configuration script started. */
+    uint64_t PACFetchStartTime;
+    /** Time when the proxy auto-configuration script was fetched. */
+    uint64_t PACFetchEndTime;
+    /** Time when evaluation of the proxy auto-configuration script started. */
+    uint64_t PACEvaluationStartTime;
+    /** Time when evaluation of the proxy auto-configuration script finished. */
+    uint64_t PACEvaluationEndTime;
+    /** Time when proxy resolution finished and connecting to the host or proxy started. */
+    uint64_t connectStartTime;
+    /** Time when the TCP connection to the host or proxy was established. */
+    uint64_t connectEndTime;
+    /** Time when the `CONNECT` request was sent to the HTTP proxy. */
+    uint64_t proxyConnectStartTime;
+    /** Time when the response to the `CONNECT` request was received. */
+    uint64_t proxyConnectEndTime;
+    /** Time when TLS was enabled on the connection. */
+    uint64_t TLSStartTime;
+    /** Time when the TLS handshake finished and evaluation of the server trust started. */
+    uint64_t TLSEndTime;
+    /** Time when `-[SRSecurityPolicy evaluateServerTrust:forDomain:]` returned. */
+    uint64_t trustEvaluationEndTime;
+    /** Time when the upgrade request was written. */
+    uint64_t upgradeRequestTime;
+    /** Time when the headers of the upgrade response were complete. */
+    uint64_t headersCompleteTime;
+} SRHandshakeTimeline;
+
+/**
+ Stages of the receive pipeline whose heap allocations are counted by the allocation audit.
+ */
+typedef NS_ENUM(NSUInteger, SRAllocationStage) {
+    /** Handler blocks copied to the heap when a consumer of the read buffer is added, one or more per frame. */
+    SRAllocationStageConsumerBlock,
+    /** `SRIOConsumer` objects created because the pool of reusable consumers was empty. */
+    SRAllocationStageConsumer,
+    /** Subranges of the read buffer handed to consumers, and copies of frame data scanned for valid UTF-8. */
+    SRAllocationStageDataSubrange,
+    /** Concatenations of bytes read from the stream to the read buffer. */
+    SRAllocationStageDataConcatenation,
+    /** Buffers the payload of every received message is reassembled into. */
+    SRAllocationStageFrameData,
+    /** Strings created from text message payloads, which also validates their UTF-8. */
+    SRAllocationStageMessageString,
+    SRAllocationStageCount
+};
+
+/**
+ A `SRWebSocketMetrics` is an immutable snapshot of counters describing the behavior of a single socket,
+ returned by `-[SRWebSocket metrics]`, or of all sockets in the process, returned by `+[SRWebSocket aggregateMetrics]`.
+
+ Counters are updated with relaxed atomics, so a snapshot taken while sockets are active is not guaranteed to be consistent
+ across counters. Peak values of an aggregate snapshot are the maximum over all sockets.
+ */
+@interface SRWebSocketMetrics : NSObject
+
+#pragma mark Bytes
+
+/** Number of bytes read from the network, including the opening handshake response. */
+@property (nonatomic, assign, readonly) uint64_t bytesReceived;
+/** Number of bytes written to the network, including the opening handshake request. */
+@property (nonatomic, assign, readonly) uint64_t bytesSent;
+
+#pragma mark Frames
+
+@property (nonatomic, assign, readonly) uint64_t textFramesReceived;
+@property (nonatomic, assign, readonly) uint64_t binaryFramesReceived;
+@property (nonatomic, assign, readonly) uint64_t continuationFramesReceived;
+@property (nonatomic, assign, readonly) uint64_t pingFramesReceived;
+@property (nonatomic, assign, readonly) uint64_t pongFramesReceived;
+@property (nonatomic, assign, readonly) uint64_t closeFramesReceived;
+
+@property (nonatomic, assign, readonly) uint64_t textFramesSent;
+@property (nonatomic, assign, readonly) uint64_t binaryFramesSent;
+@property (nonatomic, assign, readonly) uint64_t pingFramesSent;
+@property (nonatomic, assign, readonly) uint64_t pongFramesSent;
+@property (nonatomic, assign, readonly) uint64_t closeFramesSent;
+
+#pragma mark Messages
+
+/** Number of received messages handed to the delegate or to on demand receive requests. */
+@property (nonatomic, assign, readonly) uint64_t messagesDelivered;
+/** Number of frames that were reassembled into fragmented messages. */
+@property (nonatomic, assign, readonly) uint64_t fragmentsReassembled;
+
+#pragma mark Buffers
+
+/** Largest number of bytes held in the read buffer. */
+@property (nonatomic, assign, readonly) uint64_t peakReadBufferLength;
+/** Largest number of bytes held in the output buffer. */
+@property (nonatomic, assign, readonly) uint64_t peakOutputBufferLength;
+/** Largest payload length of a single received message. */
+@property (nonatomic, assign, readonly) uint64_t peakFrameDataLength;
+
+#pragma mark Calls
+
+/** Number of reads from the input stream. */
+@property (nonatomic, assign, readonly) uint64_t readCount;
+/** Number of writes to the output stream. */
+@property (nonatomic, assign, readonly) uint64_t writeCount;
+
+#pragma mark Allocations
+
+/**
+ Whether SocketRocket was built with `SR_ALLOCATION_AUDIT_ENABLED` defined. Allocation counters stay `0` otherwise.
+ The audit asks the allocator for the size of every counted object, so it is meant for profiling builds and benchmarks only.
+ */
+@property (class, nonatomic, assign, readonly, getter=isAllocationAuditEnabled) BOOL allocationAuditEnabled;
+
+/**
+ Number of heap allocations done by a stage of the receive pipeline. Divide by `messagesDelivered` to get allocations per message.
+
+ @param stage Stage of the receive pipeline.
+ */
+- (uint64_t)allocationCountForStage:(SRAllocationStage)stage;
+
+/**
+ Number of bytes allocated on the heap by a stage of the receive pipeline, as reported by the allocator for the counted objects.
+ Payload bytes are included where the object copies them into a buffer of its own, but not later growth of a buffer.
+
+ @param stage Stage of the receive pipeline.
+ */
+- (uint64_t)allocatedBytesForStage:(SRAllocationStage)stage;
+
+#pragma mark Handshake
+
+/** Timeline of opening the socket. Empty for the aggregate snapshot. */
+@property (nonatomic, assign, readonly) SRHandshakeTimeline handshakeTimeline;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
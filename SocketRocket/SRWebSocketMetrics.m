@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRWebSocketMetrics.h"
+#import "SRWebSocketMetrics+Private.h"
+
+#import "SRAllocationAudit.h"
+#import "SRConstants.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation SRWebSocketMetrics {
+    uint64_t _allocations[SRAllocationStageCount];
+    uint64_t _allocatedBytes[SRAllocationStageCount];
+}
+
+- (instancetype)initWithValues:(const SRMetricsValues *)values
+{
+    self = [super init];
+    if (!self) return self;
+
+    _bytesReceived = values->bytesReceived;
+    _bytesSent = values->bytesSent;
+
+    _textFramesReceived = values->framesReceived[SROpCodeTextFrame];
+    _binaryFramesReceived = values->framesReceived[SROpCodeBinaryFrame];
+    _continuationFramesReceived = values->framesReceived[0]; // Continuation frames have opcode `0`.
+    _pingFramesReceived = values->framesReceived[SROpCodePing];
+    _pongFramesReceived = values->framesReceived[SROpCodePong];
+    _closeFramesReceived = values->framesReceived[SROpCodeConnectionClose];
+
+    _textFramesSent = values->framesSent[SROpCodeTextFrame];
+    _binaryFramesSent = values->framesSent[SROpCodeBinaryFrame];
+    _pingFramesSent = values->framesSent[SROpCodePing];
+    _pongFramesSent = values->framesSent[SROpCodePong];
+    _closeFramesSent = values->framesSent[SROpCodeConnectionClose];
+
+    _messagesDelivered = values->messagesDelivered;
+    _fragmentsReassembled = values->fragmentsReassembled;
+
+    _peakReadBufferLength = values->peakReadBufferLength;
+    _peakOutputBufferLength = values->peakOutputBufferLength;
+    _peakFrameDataLength = values->peakFrameDataLength;
+
+    _readCount = values->readCount;
+    _writeCount = values->writeCount;
+
+    memcpy(_allocations, values->allocations, sizeof(_allocations));
+    memcpy(_allocatedBytes, values->allocatedBytes, sizeof(_allocatedBytes));
+
+    _handshakeTimeline = (SRHandshakeTimeline){
+        .openTime = values->handshake[SRHandshakeMarkOpen],
+        .PACFetchStartTime = values->handshake[SRHandshakeMarkPACFetchStart],
+        .PACFetchEndTime = values->handshake[SRHandshakeMarkPACFetchEnd],
+        .PACEvaluationStartTime = values->handshake[SRHandshakeMarkPACEvaluationStart],
+        .PACEvaluationEndTime = values->handshake[SRHandshakeMarkPACEvaluationEnd],
+        .connectStartTime = values->handshake[SRHandshakeMarkConnectStart],
+        .connectEndTime = values->handshake[SRHandshakeMarkConnectEnd],
+        .proxyConnectStartTime = values->handshake[SRHandshakeMarkProxyConnectStart],
+        .proxyConnectEndTime = values->handshake[SRHandshakeMarkProxyConnectEnd],
+        .TLSStartTime = values->handshake[SRHandshakeMarkTLSStart],
+        .TLSEndTime = values->handshake[SRHandshakeMarkTLSEnd],
+        .trustEvaluationEndTime = values->handshake[SRHandshakeMarkTrustEvaluationEnd],
+        .upgradeRequestTime = values->handshake[SRHandshakeMarkUpgradeRequest],
+        .headersCompleteTime = values->handshake[SRHandshakeMarkHeadersComplete],
+    };
+
+    return self;
+}
+
++ (BOOL)isAllocationAuditEnabled
+{
+#ifdef SR_ALLOCATION_AUDIT_ENABLED
+    return YES;
+#else
+    return NO;
+#endif
+}
+
+- (uint64_t)allocationCountForStage:(SRAllocationStage)stage
+{
+    return (stage < SRAllocationStageCount ? _allocations[stage] : 0);
+}
+
+- (uint64_t)allocatedBytesForStage:(SRAllocationStage)stage
+{
+    return (stage < SRAllocationStageCount ? _allocatedBytes[stage] : 0);
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p, bytesReceived: %llu, bytesSent: %llu, messagesDelivered: %llu, readCount: %llu, writeCount: %llu>",
+            NSStringFromClass([self class]), self,
+            self.bytesReceived, self.bytesSent, self.messagesDelivered, self.readCount, self.writeCount];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -11,5 +11,9 @@
 
 #import <SocketRocket/NSRunLoop+SRWebSocket.h>
 #import <SocketRocket/NSURLRequest+SRWebSocket.h>
+#import <SocketRocket/SRMessage.h>
+#import <SocketRocket/SRLoopbackTransport.h>
+#import <SocketRocket/SRMessageBuilder.h>
 #import <SocketRocket/SRSecurityPolicy.h>
 #import <SocketRocket/SRWebSocket.h>
+#import <SocketRocket/SRWebSocketMetrics.h>
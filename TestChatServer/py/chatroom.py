@@ -58,6 +58,11 @@ class ChatHandler(tornado.websocket.WebSocketHandler):
         connections.remove(self)
 
 
+class EchoHandler(tornado.websocket.WebSocketHandler):
+    def on_message(self, msg):
+        self.write_message(msg, binary=isinstance(msg, bytes))
+
+
 def main():
     global logger
     #tornado.options.parse_command_line()
@@ -72,6 +77,7 @@ def main():
 
     application = tornado.web.Application([
         (r"/chat", ChatHandler),
+        (r"/echo", EchoHandler),
         (r"/(.*)", tornado.web.StaticFileHandler, {"path": args.static_path, "default_filename":'index.html'}),
     ],
     )
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+@interface SRConflationTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_openExpectation;
+}
+@end
+
+@implementation SRConflationTests
+
+- (void)testNewerMessageReplacesPendingOneWithSameKey
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [self srt_openWebSocketWithServer:server
+                                                      delegate:self
+                                                 delegateQueue:dispatch_queue_create("SRConflationTests.delegate", DISPATCH_QUEUE_SERIAL)
+                                               openExpectation:&_openExpectation
+                                                 configuration:nil];
+
+    // Server doesn't read yet, so this message stays in the output buffer and holds back the conflated ones.
+    NSData *blockingMessage = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    XCTAssertTrue([webSocket sendData:blockingMessage error:NULL]);
+
+    const NSUInteger updateCount = 100;
+    for (NSUInteger i = 0; i < updateCount; i++) {
+        NSString *price = [NSString stringWithFormat:@"price %lu", (unsigned long)i];
+        XCTAssertTrue([webSocket sendString:price conflationKey:@"price" error:NULL]);
+        if (i == 0) {
+            XCTAssertTrue([webSocket sendData:[@"volume" dataUsingEncoding:NSUTF8StringEncoding] conflationKey:@"volume" error:NULL]);
+        }
+    }
+
+    SRTOpCode opCode = 0;
+    XCTAssertEqualObjects([server readFrameWithOpCode:&opCode], blockingMessage);
+    XCTAssertEqual(opCode, SRTOpCodeBinaryFrame);
+
+    // Only the latest message of every key is sent, in the order the keys were first enqueued.
+    NSString *latestPrice = [NSString stringWithFormat:@"price %lu", (unsigned long)(updateCount - 1)];
+    XCTAssertEqualObjects([server readFrameWithOpCode:&opCode], [latestPrice dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqual(opCode, SRTOpCodeTextFrame);
+    XCTAssertEqualObjects([server readFrameWithOpCode:&opCode], [@"volume" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqual(opCode, SRTOpCodeBinaryFrame);
+
+    XCTAssertEqual(webSocket.conflatedMessageCount, updateCount - 1);
+    XCTAssertEqual(webSocket.conflationSentMessageCount, 2);
+
+    // Once the output buffer drained, a conflated message is sent right away.
+    XCTAssertTrue([webSocket sendString:@"price final" conflationKey:@"price" error:NULL]);
+    XCTAssertEqualObjects([server readFrameWithOpCode:&opCode], [@"price final" dataUsingEncoding:NSUTF8StringEncoding]);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+@end
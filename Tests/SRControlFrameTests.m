@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+static const NSUInteger SRTMessageCount = 100;
+
+@interface SRControlFrameTests : XCTestCase <SRWebSocketDelegate>
+{
+    SRTLocalServer *_server;
+    SRWebSocket *_webSocket;
+    dispatch_queue_t _delegateQueue;
+    dispatch_semaphore_t _delegateQueueSemaphore;
+
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_pingExpectation;
+    // Accessed only on the delegate queue.
+    NSMutableArray<NSString *> *_events;
+}
+@end
+
+@implementation SRControlFrameTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    _events = [NSMutableArray array];
+    _server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(_server);
+
+    _delegateQueue = dispatch_queue_create("SRControlFrameTests.delegate", DISPATCH_QUEUE_SERIAL);
+    _webSocket = [self srt_openWebSocketWithServer:_server
+                                          delegate:self
+                                     delegateQueue:_delegateQueue
+                                   openExpectation:&_openExpectation
+                                     configuration:nil];
+}
+
+- (void)tearDown
+{
+    [self _unblockDelegateQueue];
+    [_webSocket close];
+    [_server close];
+    [super tearDown];
+}
+
+// Keeps the delegate queue busy until `_unblockDelegateQueue`, like a main thread that is stuck in a long task.
+- (void)_blockDelegateQueue
+{
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    _delegateQueueSemaphore = semaphore;
+    dispatch_async(_delegateQueue, ^{
+        dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    });
+}
+
+- (void)_unblockDelegateQueue
+{
+    if (_delegateQueueSemaphore) {
+        dispatch_semaphore_signal(_delegateQueueSemaphore);
+        _delegateQueueSemaphore = nil;
+    }
+}
+
+- (void)testPongIsSentWhileDelegateQueueIsBlocked
+{
+    [self _blockDelegateQueue];
+
+    NSData *payload = [@"ping" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertTrue([_server sendFrameWithOpCode:SRTOpCodePing payload:payload]);
+
+    SRTOpCode opCode = 0;
+    XCTAssertEqualObjects([_server readFrameWithOpCode:&opCode], payload);
+    XCTAssertEqual(opCode, SRTOpCodePong);
+}
+
+- (void)testProtocolErrorCloseIsSentWhileDelegateQueueIsBlocked
+{
+    [self _blockDelegateQueue];
+
+    // Control frames can't be fragmented.
+    XCTAssertTrue([_server sendFrameWithOpCode:SRTOpCodePing payload:nil fin:NO]);
+
+    SRTOpCode opCode = 0;
+    NSData *payload = [_server readFrameWithOpCode:&opCode];
+    XCTAssertEqual(opCode, SRTOpCodeConnectionClose);
+    XCTAssertGreaterThanOrEqual(payload.length, 2);
+    const uint8_t *closeCode = payload.bytes;
+    XCTAssertEqual((closeCode[0] << 8) | closeCode[1], SRStatusCodeProtocolError);
+}
+
+- (void)testPingIsReportedAfterEarlierMessages
+{
+    [self _blockDelegateQueue];
+
+    NSMutableArray<NSString *> *expectedEvents = [NSMutableArray array];
+    for (NSUInteger i = 0; i < SRTMessageCount; i++) {
+        NSString *message = [NSString stringWithFormat:@"message %lu", (unsigned long)i];
+        XCTAssertTrue([_server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[message dataUsingEncoding:NSUTF8StringEncoding]]);
+        [expectedEvents addObject:message];
+    }
+    XCTAssertTrue([_server sendFrameWithOpCode:SRTOpCodePing payload:[@"ping" dataUsingEncoding:NSUTF8StringEncoding]]);
+    [expectedEvents addObject:@"ping"];
+
+    // Pong goes out before the delegate has seen any of the messages.
+    SRTOpCode opCode = 0;
+    XCTAssertNotNil([_server readFrameWithOpCode:&opCode]);
+    XCTAssertEqual(opCode, SRTOpCodePong);
+
+    _pingExpectation = [self expectationWithDescription:@"Received ping"];
+    [self _unblockDelegateQueue];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    dispatch_sync(_delegateQueue, ^{
+        XCTAssertEqualObjects(self->_events, expectedEvents);
+    });
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    [_events addObject:string];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceivePingWithData:(nullable NSData *)data
+{
+    [_events addObject:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+    [_pingExpectation fulfill];
+}
+
+@end
@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+@interface SRFramingTests : XCTestCase <SRWebSocketDelegate>
+{
+    SRTLocalServer *_server;
+    SRWebSocket *_webSocket;
+    XCTestExpectation *_openExpectation;
+}
+@end
+
+@implementation SRFramingTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    _server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(_server);
+
+    _webSocket = [self srt_openWebSocketWithServer:_server
+                                          delegate:self
+                                     delegateQueue:dispatch_queue_create("SRFramingTests.delegate", DISPATCH_QUEUE_SERIAL)
+                                   openExpectation:&_openExpectation
+                                     configuration:nil];
+}
+
+- (void)tearDown
+{
+    [_webSocket close];
+    [_server close];
+    [super tearDown];
+}
+
+// Random bytes of `length`, split into parts at `splits`.
+static NSArray<NSData *> *SRTPayloadParts(NSUInteger length, NSArray<NSNumber *> *splits)
+{
+    NSMutableData *payload = [NSMutableData dataWithLength:length];
+    arc4random_buf(payload.mutableBytes, payload.length);
+
+    NSMutableArray<NSData *> *parts = [NSMutableArray array];
+    NSUInteger offset = 0;
+    for (NSNumber *split in [splits arrayByAddingObject:@(length)]) {
+        [parts addObject:[payload subdataWithRange:NSMakeRange(offset, split.unsignedIntegerValue - offset)]];
+        offset = split.unsignedIntegerValue;
+    }
+    return parts;
+}
+
+static NSData *SRTJoinedParts(NSArray<NSData *> *parts)
+{
+    NSMutableData *data = [NSMutableData data];
+    for (NSData *part in parts) {
+        [data appendData:part];
+    }
+    return data;
+}
+
+- (void)_assertReceivedFrameWithOpCode:(SRTOpCode)expectedOpCode payload:(NSData *)expectedPayload
+{
+    SRTOpCode opCode = 0;
+    NSData *payload = [_server readFrameWithOpCode:&opCode];
+    XCTAssertEqual(opCode, expectedOpCode);
+    XCTAssertEqualObjects(payload, expectedPayload);
+}
+
+- (void)testScatterGatherMatchesContiguousSend
+{
+    // Odd splits leave parts that don't start on a masking key boundary.
+    // Lengths cover the 7-bit, 16-bit and 64-bit payload length encodings.
+    NSArray<NSArray<NSData *> *> *payloads = @[
+        SRTPayloadParts(0, @[]),
+        SRTPayloadParts(125, @[ @1, @3, @64 ]),
+        SRTPayloadParts(126, @[ @5 ]),
+        SRTPayloadParts(UINT16_MAX, @[ @7, @1000, @1001 ]),
+        SRTPayloadParts(UINT16_MAX + 1, @[ @33333 ]),
+        SRTPayloadParts(300 * 1024, @[ @1, @2, @100 * 1024 + 3 ]),
+    ];
+
+    for (NSArray<NSData *> *parts in payloads) {
+        NSData *payload = SRTJoinedParts(parts);
+
+        // `sendData:` frames a copy of the contiguous bytes, the reference for the scatter-gather frame.
+        NSError *error = nil;
+        XCTAssertTrue([_webSocket sendData:payload error:&error]);
+        XCTAssertTrue([_webSocket sendDataParts:parts error:&error]);
+        XCTAssertNil(error);
+
+        [self _assertReceivedFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload];
+        [self _assertReceivedFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload];
+    }
+}
+
+- (void)testDiscontiguousDispatchDataMatchesContiguousSend
+{
+    NSArray<NSData *> *parts = SRTPayloadParts(70 * 1024, @[ @3, @4, @10 * 1024 + 1, @65 * 1024 ]);
+    dispatch_data_t data = dispatch_data_empty;
+    for (NSData *part in parts) {
+        dispatch_data_t region = dispatch_data_create(part.bytes, part.length, nil, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+        data = dispatch_data_create_concat(data, region);
+    }
+    NSData *payload = SRTJoinedParts(parts);
+
+    NSError *error = nil;
+    XCTAssertTrue([_webSocket sendData:payload error:&error]);
+    XCTAssertTrue([_webSocket sendDispatchData:data error:&error]);
+    XCTAssertNil(error);
+
+    [self _assertReceivedFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload];
+    [self _assertReceivedFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload];
+}
+
+- (void)_assertStringFramingMatchesCopiedPayload:(NSString *)string
+{
+    // Conflated strings are framed from a copy of their UTF-8 data, the reference for encoding straight into the frame.
+    NSError *error = nil;
+    XCTAssertTrue([_webSocket sendString:string conflationKey:[NSUUID UUID].UUIDString error:&error]);
+    SRTOpCode opCode = 0;
+    NSData *expectedPayload = [_server readFrameWithOpCode:&opCode];
+    XCTAssertEqual(opCode, SRTOpCodeTextFrame);
+    XCTAssertEqualObjects(expectedPayload, [string dataUsingEncoding:NSUTF8StringEncoding]);
+
+    XCTAssertTrue([_webSocket sendString:string error:&error]);
+    XCTAssertNil(error);
+    [self _assertReceivedFrameWithOpCode:SRTOpCodeTextFrame payload:expectedPayload];
+}
+
+- (void)testASCIIStringFraming
+{
+    [self _assertStringFramingMatchesCopiedPayload:@""];
+    [self _assertStringFramingMatchesCopiedPayload:@"Hello, World!"];
+    [self _assertStringFramingMatchesCopiedPayload:[@"" stringByPaddingToLength:70 * 1024 withString:@"0123456789" startingAtIndex:0]];
+}
+
+- (void)testNonASCIIStringFraming
+{
+    [self _assertStringFramingMatchesCopiedPayload:@"Hello, \u4E16\u754C \U0001F30D"];
+
+    // Multi-byte characters straddle the boundaries of the chunks the string is encoded in.
+    NSMutableString *string = [NSMutableString stringWithString:@"a"];
+    while (string.length < 20 * 1024) {
+        [string appendString:@"\u00E9\u20AC\U0001F600"];
+    }
+    [self _assertStringFramingMatchesCopiedPayload:string];
+}
+
+- (void)testInvalidStringIsNotSent
+{
+    unichar unpairedSurrogate = 0xD800;
+    NSArray<NSString *> *strings = @[
+        [NSString stringWithCharacters:&unpairedSurrogate length:1],
+        [@"\u00E9 before " stringByAppendingString:[NSString stringWithCharacters:&unpairedSurrogate length:1]],
+    ];
+    for (NSString *string in strings) {
+        NSError *error = nil;
+        XCTAssertFalse([_webSocket sendString:string error:&error]);
+        XCTAssertEqual(error.code, 2150);
+    }
+
+    // Nothing was written for them, the next frame is the next valid message.
+    XCTAssertTrue([_webSocket sendString:@"valid" error:NULL]);
+    [self _assertReceivedFrameWithOpCode:SRTOpCodeTextFrame payload:[@"valid" dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+@end
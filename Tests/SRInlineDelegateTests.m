@@ -0,0 +1,258 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <stdatomic.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+static const NSUInteger SRTMessageCount = 500;
+
+// Records delegate calls and counts the ones that break the rules of `callsDelegateInline`.
+@interface SRTInlineDelegate : NSObject <SRWebSocketDelegate>
+{
+@public
+    atomic_int _activeCallCount;
+    atomic_uint _offQueueCallCount;
+    atomic_uint _overlappingCallCount;
+
+    NSMutableArray<NSString *> *_messages;
+    NSMutableArray<NSString *> *_pings;
+    NSMutableArray<NSString *> *_events;
+    NSUInteger _expectedMessageCount;
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_receivedExpectation;
+}
+@end
+
+@implementation SRTInlineDelegate
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _messages = [NSMutableArray array];
+    _pings = [NSMutableArray array];
+    _events = [NSMutableArray array];
+    _expectedMessageCount = SRTMessageCount;
+
+    return self;
+}
+
+- (void)_beginCallForWebSocket:(SRWebSocket *)webSocket
+{
+    if (!dispatch_get_specific((__bridge void *)webSocket)) {
+        atomic_fetch_add(&_offQueueCallCount, 1);
+    }
+    if (atomic_fetch_add(&_activeCallCount, 1) != 0) {
+        atomic_fetch_add(&_overlappingCallCount, 1);
+    }
+    // Gives a call that would run concurrently a chance to show up.
+    usleep(20);
+}
+
+- (void)_endCall
+{
+    atomic_fetch_sub(&_activeCallCount, 1);
+}
+
+- (void)_recordMessage:(NSString *)message
+{
+    [_messages addObject:message];
+    [_events addObject:message];
+    [self _fulfillIfReceivedAll];
+}
+
+- (void)_fulfillIfReceivedAll
+{
+    if (_messages.count == _expectedMessageCount && _pings.count == SRTMessageCount) {
+        [_receivedExpectation fulfill];
+    }
+}
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [self _beginCallForWebSocket:webSocket];
+    [_openExpectation fulfill];
+    [self _endCall];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceivePingWithData:(nullable NSData *)data
+{
+    [self _beginCallForWebSocket:webSocket];
+    NSString *ping = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    [_pings addObject:ping];
+    [_events addObject:ping];
+    [self _fulfillIfReceivedAll];
+    [self _endCall];
+}
+
+@end
+
+@interface SRTInlineMessageDelegate : SRTInlineDelegate
+@end
+
+@implementation SRTInlineMessageDelegate
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    [self _beginCallForWebSocket:webSocket];
+    [self _recordMessage:string];
+    [self _endCall];
+}
+
+@end
+
+@interface SRTInlineBatchDelegate : SRTInlineDelegate
+@end
+
+@implementation SRTInlineBatchDelegate
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessages:(NSArray *)messages
+{
+    [self _beginCallForWebSocket:webSocket];
+    for (NSString *message in messages) {
+        [self _recordMessage:message];
+    }
+    [self _endCall];
+}
+
+@end
+
+@interface SRInlineDelegateTests : XCTestCase
+@end
+
+@implementation SRInlineDelegateTests
+
+- (SRWebSocket *)_openWebSocketWithServer:(SRTLocalServer *)server
+                                 delegate:(SRTInlineDelegate *)delegate
+                receivesMessagesOnDemand:(BOOL)receivesMessagesOnDemand
+{
+    return [self srt_openWebSocketWithServer:server
+                                    delegate:delegate
+                               delegateQueue:nil
+                             openExpectation:&delegate->_openExpectation
+                               configuration:^(SRWebSocket *webSocket) {
+        webSocket.callsDelegateInline = YES;
+        webSocket.receivesMessagesOnDemand = receivesMessagesOnDemand;
+    }];
+}
+
+// Every message is followed by a ping with the same index, batched into as few reads as the kernel allows.
+- (void)_sendMessagesAndPingsWithServer:(SRTLocalServer *)server
+{
+    for (NSUInteger i = 0; i < SRTMessageCount; i++) {
+        NSData *message = [[NSString stringWithFormat:@"message %lu", (unsigned long)i] dataUsingEncoding:NSUTF8StringEncoding];
+        NSData *ping = [[NSString stringWithFormat:@"ping %lu", (unsigned long)i] dataUsingEncoding:NSUTF8StringEncoding];
+        XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodeTextFrame payload:message]);
+        XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodePing payload:ping]);
+    }
+}
+
+- (NSArray<NSString *> *)_expectedStringsWithFormat:(NSString *)format
+{
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    for (NSUInteger i = 0; i < SRTMessageCount; i++) {
+        [strings addObject:[NSString stringWithFormat:format, (unsigned long)i]];
+    }
+    return strings;
+}
+
+- (void)_assertInlineCallsOfDelegate:(SRTInlineDelegate *)delegate
+{
+    XCTAssertEqual(atomic_load(&delegate->_offQueueCallCount), 0);
+    XCTAssertEqual(atomic_load(&delegate->_overlappingCallCount), 0);
+    XCTAssertEqualObjects(delegate->_pings, [self _expectedStringsWithFormat:@"ping %lu"]);
+}
+
+- (void)testMessagesAreReportedInlineInOrder
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRTInlineMessageDelegate *delegate = [[SRTInlineMessageDelegate alloc] init];
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server delegate:delegate receivesMessagesOnDemand:NO];
+
+    delegate->_receivedExpectation = [self expectationWithDescription:@"Received all messages and pings"];
+    [self _sendMessagesAndPingsWithServer:server];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+
+    [self _assertInlineCallsOfDelegate:delegate];
+    NSMutableArray<NSString *> *expectedEvents = [NSMutableArray array];
+    for (NSUInteger i = 0; i < SRTMessageCount; i++) {
+        [expectedEvents addObject:[NSString stringWithFormat:@"message %lu", (unsigned long)i]];
+        [expectedEvents addObject:[NSString stringWithFormat:@"ping %lu", (unsigned long)i]];
+    }
+    XCTAssertEqualObjects(delegate->_events, expectedEvents);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testBatchesAreReportedInlineInOrder
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRTInlineBatchDelegate *delegate = [[SRTInlineBatchDelegate alloc] init];
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server delegate:delegate receivesMessagesOnDemand:NO];
+
+    delegate->_receivedExpectation = [self expectationWithDescription:@"Received all messages and pings"];
+    [self _sendMessagesAndPingsWithServer:server];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+
+    [self _assertInlineCallsOfDelegate:delegate];
+    XCTAssertEqualObjects(delegate->_messages, [self _expectedStringsWithFormat:@"message %lu"]);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testOnDemandReceiveKeepsInlineDelegateCallsSerialized
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRTInlineDelegate *delegate = [[SRTInlineDelegate alloc] init];
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server delegate:delegate receivesMessagesOnDemand:YES];
+
+    XCTestExpectation *messagesExpectation = [self expectationWithDescription:@"Received all messages"];
+    dispatch_queue_t consumerQueue = dispatch_queue_create("SRInlineDelegateTests.consumer", DISPATCH_QUEUE_SERIAL);
+    NSMutableArray<NSString *> *messages = [NSMutableArray array];
+    __block void (^receiveNext)(void) = nil;
+    receiveNext = ^{
+        [webSocket receiveMessagesWithMaximumCount:16 completionQueue:consumerQueue completion:^(NSArray *receivedMessages, NSError *error) {
+            XCTAssertNil(error);
+            [messages addObjectsFromArray:receivedMessages];
+            if (error || messages.count == SRTMessageCount) {
+                [messagesExpectation fulfill];
+                return;
+            }
+            receiveNext();
+        }];
+    };
+    receiveNext();
+
+    // Pings are the only delegate calls, messages are handed out to the requests above.
+    delegate->_receivedExpectation = [self expectationWithDescription:@"Received all pings"];
+    delegate->_expectedMessageCount = 0;
+    [self _sendMessagesAndPingsWithServer:server];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+    receiveNext = nil;
+
+    [self _assertInlineCallsOfDelegate:delegate];
+    XCTAssertEqualObjects(messages, [self _expectedStringsWithFormat:@"message %lu"]);
+
+    [webSocket close];
+    [server close];
+}
+
+@end
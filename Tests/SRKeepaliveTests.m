@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+static const NSTimeInterval SRTPingInterval = 0.05;
+static const NSTimeInterval SRTPongDelay = 0.02;
+
+@interface SRKeepaliveTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_failExpectation;
+    XCTestExpectation *_pongExpectation;
+    NSError *_error;
+    NSMutableArray<NSData *> *_pongs;
+}
+@end
+
+@implementation SRKeepaliveTests
+
+- (void)setUp
+{
+    [super setUp];
+    _pongs = [NSMutableArray array];
+}
+
+- (SRWebSocket *)_openWebSocketWithServer:(SRTLocalServer *)server pongTimeout:(NSTimeInterval)pongTimeout
+{
+    return [self srt_openWebSocketWithServer:server
+                                    delegate:self
+                               delegateQueue:dispatch_queue_create("SRKeepaliveTests.delegate", DISPATCH_QUEUE_SERIAL)
+                             openExpectation:&_openExpectation
+                               configuration:^(SRWebSocket *webSocket) {
+        webSocket.pingInterval = SRTPingInterval;
+        webSocket.pongTimeout = pongTimeout;
+    }];
+}
+
+- (void)testPongsToKeepalivePingsMeasureRoundTripTime
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server pongTimeout:10.0];
+    XCTAssertEqual(webSocket.smoothedRoundTripTime, 0.0);
+
+    // Next ping is only scheduled once the pong to the previous one is handled,
+    // so the fourth ping shows that the round trip times of the first three were recorded.
+    const NSUInteger answeredPingCount = 3;
+    NSUInteger pingCount = 0;
+    SRTOpCode opCode = 0;
+    NSData *payload = nil;
+    while (pingCount <= answeredPingCount && (payload = [server readFrameWithOpCode:&opCode])) {
+        if (opCode != SRTOpCodePing) {
+            continue;
+        }
+        pingCount++;
+        if (pingCount <= answeredPingCount) {
+            [NSThread sleepForTimeInterval:SRTPongDelay];
+            XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodePong payload:payload]);
+        }
+    }
+    XCTAssertEqual(pingCount, answeredPingCount + 1);
+
+    XCTAssertGreaterThanOrEqual(webSocket.minimumRoundTripTime, SRTPongDelay);
+    XCTAssertGreaterThanOrEqual(webSocket.smoothedRoundTripTime, webSocket.minimumRoundTripTime);
+    XCTAssertLessThan(webSocket.smoothedRoundTripTime, 5.0);
+    XCTAssertGreaterThan(webSocket.roundTripTimeJitter, 0.0);
+    XCTAssertNil(_error);
+
+    // Only pongs that don't answer keepalive pings reach the delegate.
+    _pongExpectation = [self expectationWithDescription:@"Received pong"];
+    NSData *applicationPayload = [@"application" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodePong payload:applicationPayload]);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+    XCTAssertEqualObjects(_pongs, @[ applicationPayload ]);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testMissingPongFailsSocket
+{
+    const NSTimeInterval pongTimeout = 0.2;
+
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server pongTimeout:pongTimeout];
+
+    _failExpectation = [self expectationWithDescription:@"Failed"];
+    SRTOpCode opCode = 0;
+    NSData *payload = nil;
+    do {
+        payload = [server readFrameWithOpCode:&opCode];
+    } while (payload && opCode != SRTOpCodePing);
+    XCTAssertNotNil(payload);
+    NSDate *pingDate = [NSDate date];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqual(_error.code, 2147);
+    XCTAssertGreaterThanOrEqual(-pingDate.timeIntervalSinceNow, pongTimeout / 2);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error
+{
+    _error = error;
+    [_failExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceivePong:(nullable NSData *)pongData
+{
+    [_pongs addObject:pongData];
+    [_pongExpectation fulfill];
+}
+
+@end
@@ -0,0 +1,227 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRDelegateController.h"
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+static const NSUInteger SRTKeyCount = 8;
+static const NSUInteger SRTKeyedMessageCount = 1000;
+
+static void *SRTQueueKey = &SRTQueueKey;
+
+@interface SRKeyedDeliveryTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_receivedExpectation;
+
+    // Next expected index of every key, accessed while synchronized on `self`.
+    NSMutableDictionary<NSString *, NSNumber *> *_nextIndexes;
+    NSUInteger _receivedCount;
+    NSUInteger _outOfOrderCount;
+}
+@end
+
+@implementation SRKeyedDeliveryTests
+
+- (void)setUp
+{
+    [super setUp];
+    _nextIndexes = [NSMutableDictionary dictionary];
+}
+
+- (dispatch_queue_t)_concurrentQueueWithName:(NSString *)name
+{
+    dispatch_queue_t queue = dispatch_queue_create(name.UTF8String, DISPATCH_QUEUE_CONCURRENT);
+    dispatch_queue_set_specific(queue, SRTQueueKey, (__bridge void *)queue, NULL);
+    return queue;
+}
+
+// Records that the message with `index` of `key` was delivered, counting it if an earlier one of the same key wasn't yet.
+- (void)_recordKey:(NSString *)key index:(NSUInteger)index
+{
+    @synchronized (self) {
+        if (_nextIndexes[key].unsignedIntegerValue != index) {
+            _outOfOrderCount++;
+        }
+        _nextIndexes[key] = @(index + 1);
+        _receivedCount++;
+        if (_receivedCount == SRTKeyedMessageCount) {
+            [_receivedExpectation fulfill];
+        }
+    }
+}
+
+///--------------------------------------
+#pragma mark - Delegate Controller
+///--------------------------------------
+
+- (void)testEqualKeysArePerformedInOrderOnConcurrentQueue
+{
+    SRDelegateController *controller = [[SRDelegateController alloc] init];
+    controller.dispatchQueue = [self _concurrentQueueWithName:@"SRKeyedDeliveryTests.delegate"];
+    controller.orderingLaneCount = 4;
+
+    _receivedExpectation = [self expectationWithDescription:@"Performed all blocks"];
+    NSUInteger indexes[SRTKeyCount] = {};
+    for (NSUInteger i = 0; i < SRTKeyedMessageCount; i++) {
+        NSUInteger keyIndex = arc4random_uniform(SRTKeyCount);
+        NSString *key = [NSString stringWithFormat:@"%lu", (unsigned long)keyIndex];
+        NSUInteger index = indexes[keyIndex]++;
+        [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+            // Uneven run times reorder blocks that aren't serialized by their lane.
+            usleep(arc4random_uniform(100));
+            [self _recordKey:key index:index];
+        } orderingKey:key];
+    }
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqual(_outOfOrderCount, 0);
+}
+
+- (void)testNilKeyIsNotQueuedBehindKeyedBlocks
+{
+    SRDelegateController *controller = [[SRDelegateController alloc] init];
+    controller.dispatchQueue = [self _concurrentQueueWithName:@"SRKeyedDeliveryTests.delegate"];
+    // Every key shares the single lane.
+    controller.orderingLaneCount = 1;
+
+    dispatch_semaphore_t blockingSemaphore = dispatch_semaphore_create(0);
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        dispatch_semaphore_wait(blockingSemaphore, DISPATCH_TIME_FOREVER);
+    } orderingKey:@"blocking"];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Performed block without key"];
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        [expectation fulfill];
+    } orderingKey:nil];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    dispatch_semaphore_signal(blockingSemaphore);
+}
+
+- (void)testLanesAreRebuiltWhenWidthOrQueueChanges
+{
+    SRDelegateController *controller = [[SRDelegateController alloc] init];
+    dispatch_queue_t firstQueue = [self _concurrentQueueWithName:@"SRKeyedDeliveryTests.first"];
+    controller.dispatchQueue = firstQueue;
+    controller.orderingLaneCount = 1;
+
+    // Blocks the only lane, anything that is still queued on it can't run.
+    dispatch_semaphore_t blockingSemaphore = dispatch_semaphore_create(0);
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        dispatch_semaphore_wait(blockingSemaphore, DISPATCH_TIME_FOREVER);
+    } orderingKey:@"blocking"];
+
+    // New lanes don't wait for the blocked one, even for the same key.
+    controller.orderingLaneCount = 2;
+    XCTestExpectation *widthExpectation = [self expectationWithDescription:@"Performed block after width change"];
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        XCTAssertEqual(dispatch_get_specific(SRTQueueKey), (__bridge void *)firstQueue);
+        [widthExpectation fulfill];
+    } orderingKey:@"blocking"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    dispatch_queue_t secondQueue = [self _concurrentQueueWithName:@"SRKeyedDeliveryTests.second"];
+    controller.dispatchQueue = secondQueue;
+    XCTestExpectation *queueExpectation = [self expectationWithDescription:@"Performed block after queue change"];
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        XCTAssertEqual(dispatch_get_specific(SRTQueueKey), (__bridge void *)secondQueue);
+        [queueExpectation fulfill];
+    } orderingKey:@"blocking"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    dispatch_semaphore_signal(blockingSemaphore);
+}
+
+- (void)testKeyedBlocksUseOperationQueue
+{
+    SRDelegateController *controller = [[SRDelegateController alloc] init];
+    controller.orderingLaneCount = 4;
+    NSOperationQueue *operationQueue = [[NSOperationQueue alloc] init];
+    controller.operationQueue = operationQueue;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Performed block"];
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        XCTAssertEqual([NSOperationQueue currentQueue], operationQueue);
+        [expectation fulfill];
+    } orderingKey:@"key"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+}
+
+- (void)testKeyedBlocksArePerformedInline
+{
+    SRDelegateController *controller = [[SRDelegateController alloc] init];
+    controller.dispatchQueue = [self _concurrentQueueWithName:@"SRKeyedDeliveryTests.delegate"];
+    controller.orderingLaneCount = 4;
+    controller.performsInline = YES;
+
+    __block BOOL performed = NO;
+    [controller performDelegateBlock:^(id<SRWebSocketDelegate> delegate, SRDelegateAvailableMethods availableMethods) {
+        performed = YES;
+    } orderingKey:@"key"];
+    XCTAssertTrue(performed);
+}
+
+///--------------------------------------
+#pragma mark - Web Socket
+///--------------------------------------
+
+- (void)testMessagesWithEqualKeysAreReportedInOrder
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [self srt_openWebSocketWithServer:server
+                                                      delegate:self
+                                                 delegateQueue:[self _concurrentQueueWithName:@"SRKeyedDeliveryTests.delegate"]
+                                               openExpectation:&_openExpectation
+                                                 configuration:^(SRWebSocket *socket) {
+        socket.concurrentDeliveryWidth = 4;
+        socket.messageOrderingKeyBlock = ^id _Nullable(id message) {
+            return [message componentsSeparatedByString:@" "].firstObject;
+        };
+    }];
+
+    _receivedExpectation = [self expectationWithDescription:@"Received all messages"];
+    NSUInteger indexes[SRTKeyCount] = {};
+    for (NSUInteger i = 0; i < SRTKeyedMessageCount; i++) {
+        NSUInteger key = arc4random_uniform(SRTKeyCount);
+        NSString *message = [NSString stringWithFormat:@"%lu %lu", (unsigned long)key, (unsigned long)indexes[key]++];
+        XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[message dataUsingEncoding:NSUTF8StringEncoding]]);
+    }
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+
+    XCTAssertEqual(_outOfOrderCount, 0);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    usleep(arc4random_uniform(100));
+    NSArray<NSString *> *components = [string componentsSeparatedByString:@" "];
+    [self _recordKey:components[0] index:(NSUInteger)components[1].integerValue];
+}
+
+@end
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+
+@interface SRLogTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_failExpectation;
+}
+@end
+
+@implementation SRLogTests
+
+- (void)tearDown
+{
+    SRWebSocket.logSink = nil;
+    SRWebSocket.logLevel = SRLogLevelError;
+    [super tearDown];
+}
+
+- (void)testSinkReceivesEnabledLevels
+{
+    NSMutableArray<NSString *> *messages = [NSMutableArray array];
+    NSMutableIndexSet *levels = [NSMutableIndexSet indexSet];
+    SRWebSocket.logLevel = SRLogLevelWarning;
+    SRWebSocket.logSink = ^(SRLogLevel level, NSString *message) {
+        [levels addIndex:(NSUInteger)level];
+        [messages addObject:message];
+    };
+
+    // Nothing listens on the port anymore, so connecting fails.
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    NSURL *url = server.URL;
+    [server close];
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:url];
+    webSocket.delegate = self;
+    [webSocket open];
+
+    _failExpectation = [self expectationWithDescription:@"Failed to connect"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    // Swapping the sink hands everything queued so far to the previous one.
+    SRWebSocket.logSink = nil;
+
+    XCTAssertTrue([[messages componentsJoinedByString:@"\n"] containsString:@"Failing with error"]);
+    XCTAssertFalse([levels containsIndex:SRLogLevelInfo]);
+    XCTAssertFalse([levels containsIndex:SRLogLevelDebug]);
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocket:(SRWebSocket *)webSocket didFailWithError:(NSError *)error
+{
+    [_failExpectation fulfill];
+}
+
+@end
@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRLoopbackTransport.h>
+#import <SocketRocket/SRWebSocket.h>
+
+#import "XCTestCase+SRTLocalServer.h"
+
+@interface SRLoopbackTransportTests : XCTestCase <SRWebSocketDelegate>
+{
+    NSMutableArray *_messages;
+    NSUInteger _expectedMessageCount;
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_messagesExpectation;
+    XCTestExpectation *_closeExpectation;
+    NSInteger _closeCode;
+    BOOL _closedCleanly;
+}
+@end
+
+@implementation SRLoopbackTransportTests
+
+- (void)setUp
+{
+    [super setUp];
+    _messages = [NSMutableArray array];
+}
+
+- (SRWebSocket *)_webSocketWithTransport:(SRLoopbackTransport *)transport
+{
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:[NSURL URLWithString:@"ws://loopback/"]];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRLoopbackTransportTests.delegate", DISPATCH_QUEUE_SERIAL);
+    webSocket.loopbackTransport = transport;
+    return webSocket;
+}
+
+- (void)testEchoesMessagesInChunks
+{
+    SRLoopbackTransport *transport = [[SRLoopbackTransport alloc] init];
+    transport.chunkLength = 1000;
+    transport.bufferLength = 64 * 1024;
+    SRWebSocket *webSocket = [self _webSocketWithTransport:transport];
+
+    [self srt_openWebSocket:webSocket withServer:nil openExpectation:&_openExpectation];
+
+    NSMutableData *largeData = [NSMutableData dataWithLength:200 * 1024];
+    arc4random_buf(largeData.mutableBytes, largeData.length);
+    NSArray *sentMessages = @[ @"hello", [NSData dataWithBytes:"\x00\x01\x02" length:3], [largeData copy] ];
+
+    _expectedMessageCount = sentMessages.count;
+    _messagesExpectation = [self expectationWithDescription:@"Echoed"];
+    NSError *error = nil;
+    XCTAssertTrue([webSocket sendString:sentMessages[0] error:&error]);
+    XCTAssertTrue([webSocket sendData:sentMessages[1] error:&error]);
+    XCTAssertTrue([webSocket sendData:sentMessages[2] error:&error]);
+    XCTAssertNil(error);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+    XCTAssertEqualObjects(_messages, sentMessages);
+    XCTAssertEqual(transport.receivedMessageCount, sentMessages.count);
+
+    _closeExpectation = [self expectationWithDescription:@"Closed"];
+    [webSocket closeWithCode:SRStatusCodeNormal reason:nil];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+    XCTAssertEqual(_closeCode, SRStatusCodeNormal);
+    XCTAssertTrue(_closedCleanly);
+}
+
+- (void)testLatencyDelaysDelivery
+{
+    SRLoopbackTransport *transport = [[SRLoopbackTransport alloc] init];
+    transport.latency = 0.1;
+    SRWebSocket *webSocket = [self _webSocketWithTransport:transport];
+
+    [self srt_openWebSocket:webSocket withServer:nil openExpectation:&_openExpectation];
+
+    _expectedMessageCount = 1;
+    _messagesExpectation = [self expectationWithDescription:@"Echoed"];
+    NSDate *sendDate = [NSDate date];
+    [webSocket sendString:@"ping" error:NULL];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    // One trip to the server and one back.
+    XCTAssertGreaterThanOrEqual(-sendDate.timeIntervalSinceNow, 0.2);
+    [webSocket close];
+}
+
+- (void)testServerRepliesAndCloses
+{
+    SRLoopbackTransport *transport = [[SRLoopbackTransport alloc] init];
+    __weak SRLoopbackTransport *wtransport = transport;
+    transport.messageHandler = ^(id message) {
+        [wtransport sendString:[@"re: " stringByAppendingString:message]];
+        [wtransport closeWithCode:4000 reason:@"Done"];
+    };
+    SRWebSocket *webSocket = [self _webSocketWithTransport:transport];
+
+    [self srt_openWebSocket:webSocket withServer:nil openExpectation:&_openExpectation];
+
+    _closeExpectation = [self expectationWithDescription:@"Closed"];
+    [webSocket sendString:@"question" error:NULL];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqualObjects(_messages, @[ @"re: question" ]);
+    XCTAssertEqual(_closeCode, 4000);
+    XCTAssertTrue(_closedCleanly);
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    [self _didReceiveMessage:string];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    [self _didReceiveMessage:data];
+}
+
+- (void)_didReceiveMessage:(id)message
+{
+    [_messages addObject:message];
+    if (_messages.count == _expectedMessageCount) {
+        [_messagesExpectation fulfill];
+    }
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(nullable NSString *)reason wasClean:(BOOL)wasClean
+{
+    _closeCode = code;
+    _closedCleanly = wasClean;
+    [_closeExpectation fulfill];
+}
+
+@end
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+@interface SRMessageBatchTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_messagesExpectation;
+    NSUInteger _expectedMessageCount;
+    NSMutableArray<NSArray *> *_batches;
+    NSUInteger _receivedCount;
+}
+@end
+
+@implementation SRMessageBatchTests
+
+- (void)setUp
+{
+    [super setUp];
+    _batches = [NSMutableArray array];
+}
+
+- (SRWebSocket *)_openWebSocketWithServer:(SRTLocalServer *)server maximumMessageBatchCount:(NSUInteger)maximumMessageBatchCount
+{
+    return [self srt_openWebSocketWithServer:server
+                                    delegate:self
+                               delegateQueue:dispatch_queue_create("SRMessageBatchTests.delegate", DISPATCH_QUEUE_SERIAL)
+                             openExpectation:&_openExpectation
+                               configuration:^(SRWebSocket *webSocket) {
+        webSocket.maximumMessageBatchCount = maximumMessageBatchCount;
+    }];
+}
+
+- (void)testFramesOfSingleReadAreReportedTogether
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server maximumMessageBatchCount:256];
+
+    NSMutableArray<NSData *> *payloads = [NSMutableArray array];
+    NSMutableArray<NSString *> *messages = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 5; i++) {
+        NSString *message = [NSString stringWithFormat:@"message %lu", (unsigned long)i];
+        [messages addObject:message];
+        [payloads addObject:[message dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+
+    _expectedMessageCount = messages.count;
+    _messagesExpectation = [self expectationWithDescription:@"Received all messages"];
+    XCTAssertTrue([server sendFramesWithOpCode:SRTOpCodeTextFrame payloads:payloads]);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqual(_batches.count, 1);
+    XCTAssertEqualObjects(_batches.firstObject, messages);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testBatchIsSplitAtMaximumCount
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+    SRWebSocket *webSocket = [self _openWebSocketWithServer:server maximumMessageBatchCount:2];
+
+    NSArray<NSData *> *payloads = @[ [NSData dataWithBytes:"a" length:1],
+                                     [NSData dataWithBytes:"b" length:1],
+                                     [NSData dataWithBytes:"c" length:1] ];
+    _expectedMessageCount = payloads.count;
+    _messagesExpectation = [self expectationWithDescription:@"Received all messages"];
+    XCTAssertTrue([server sendFramesWithOpCode:SRTOpCodeBinaryFrame payloads:payloads]);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    NSArray *expectedBatches = @[ @[ payloads[0], payloads[1] ], @[ payloads[2] ] ];
+    XCTAssertEqualObjects(_batches, expectedBatches);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessages:(NSArray *)messages
+{
+    [_batches addObject:messages];
+    _receivedCount += messages.count;
+    if (_receivedCount == _expectedMessageCount) {
+        [_messagesExpectation fulfill];
+    }
+}
+
+@end
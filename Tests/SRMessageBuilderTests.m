@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRFrameBufferPool.h"
+#import "SRFrameHeader.h"
+#import "SRMessageBuilder+Private.h"
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+static const NSUInteger SRTMaximumBufferLength = 64 * 1024;
+
+@interface SRMessageBuilderTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_openExpectation;
+}
+@end
+
+@implementation SRMessageBuilderTests
+
+// Start of the pooled buffer that `builder` writes its payload into.
+static const void *SRTBufferBytesOfBuilder(SRMessageBuilder *builder)
+{
+    return (const uint8_t *)builder.mutableBytes - SRFrameHeaderMaxLength;
+}
+
+- (void)testAbandonedBuilderReturnsBufferToPool
+{
+    SRFrameBufferPool *pool = [[SRFrameBufferPool alloc] initWithBufferCapacity:1 maximumBufferLength:SRTMaximumBufferLength];
+
+    const void *bufferBytes = NULL;
+    @autoreleasepool {
+        SRMessageBuilder *builder = [[SRMessageBuilder alloc] initWithBufferPool:pool capacity:1024];
+        bufferBytes = SRTBufferBytesOfBuilder(builder);
+    }
+
+    XCTAssertEqual([pool bufferWithMinimumLength:1].mutableBytes, bufferBytes);
+}
+
+- (void)testFrameReturnsBufferToPoolOnceReleased
+{
+    SRFrameBufferPool *pool = [[SRFrameBufferPool alloc] initWithBufferCapacity:1 maximumBufferLength:SRTMaximumBufferLength];
+
+    const void *bufferBytes = NULL;
+    @autoreleasepool {
+        SRMessageBuilder *builder = [[SRMessageBuilder alloc] initWithBufferPool:pool capacity:1024];
+        bufferBytes = SRTBufferBytesOfBuilder(builder);
+        [builder appendBytes:"payload" length:7];
+        NSData *frameData = [builder finishFrameWithOpCode:SROpCodeBinaryFrame];
+
+        // The frame still owns the buffer, even once the builder is gone.
+        builder = nil;
+        XCTAssertNotEqual([pool bufferWithMinimumLength:1].mutableBytes, bufferBytes);
+        XCTAssertEqual(frameData.length, SRFrameHeaderLength(7) + 7);
+    }
+
+    XCTAssertEqual([pool bufferWithMinimumLength:1].mutableBytes, bufferBytes);
+}
+
+- (void)testBuilderGrownPastMaximumLengthIsNotPooled
+{
+    SRFrameBufferPool *pool = [[SRFrameBufferPool alloc] initWithBufferCapacity:1 maximumBufferLength:SRTMaximumBufferLength];
+
+    @autoreleasepool {
+        SRMessageBuilder *builder = [[SRMessageBuilder alloc] initWithBufferPool:pool capacity:16];
+        builder.length = SRTMaximumBufferLength + 1;
+        XCTAssertNotNil([builder finishFrameWithOpCode:SROpCodeBinaryFrame]);
+    }
+
+    // Pool is empty, so a fresh buffer of exactly the requested length comes back.
+    XCTAssertEqual([pool bufferWithMinimumLength:1].length, 1);
+}
+
+- (void)testBuilderWithUnsatisfiableCapacityIgnoresWrites
+{
+    SRFrameBufferPool *pool = [[SRFrameBufferPool alloc] initWithBufferCapacity:1 maximumBufferLength:SRTMaximumBufferLength];
+
+    for (NSNumber *capacity in @[ @(NSUIntegerMax / 2), @(NSUIntegerMax) ]) {
+        SRMessageBuilder *builder = [[SRMessageBuilder alloc] initWithBufferPool:pool capacity:capacity.unsignedIntegerValue];
+        XCTAssertTrue(builder.mutableBytes == NULL);
+
+        [builder appendBytes:"payload" length:7];
+        XCTAssertTrue(builder.mutableBytes == NULL);
+        XCTAssertNil([builder finishFrameWithOpCode:SROpCodeBinaryFrame]);
+    }
+}
+
+- (void)testSendingBuilderWithUnsatisfiableCapacityClosesWithMessageTooBig
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [self srt_openWebSocketWithServer:server
+                                                      delegate:self
+                                                 delegateQueue:dispatch_queue_create("SRMessageBuilderTests.delegate", DISPATCH_QUEUE_SERIAL)
+                                               openExpectation:&_openExpectation
+                                                 configuration:nil];
+
+    SRMessageBuilder *builder = [webSocket messageBuilderWithCapacity:NSUIntegerMax / 2];
+    XCTAssertTrue(builder.mutableBytes == NULL);
+    NSError *error = nil;
+    XCTAssertFalse([webSocket sendMessageFromBuilder:builder error:&error]);
+    XCTAssertEqual(error.code, SRStatusCodeMessageTooBig);
+
+    SRTOpCode opCode = 0;
+    NSData *payload = [server readFrameWithOpCode:&opCode];
+    XCTAssertEqual(opCode, SRTOpCodeConnectionClose);
+    XCTAssertGreaterThanOrEqual(payload.length, 2);
+    const uint8_t *closeCode = payload.bytes;
+    XCTAssertEqual((closeCode[0] << 8) | closeCode[1], SRStatusCodeMessageTooBig);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testBuilderMessageMatchesSentData
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [self srt_openWebSocketWithServer:server
+                                                      delegate:self
+                                                 delegateQueue:dispatch_queue_create("SRMessageBuilderTests.delegate", DISPATCH_QUEUE_SERIAL)
+                                               openExpectation:&_openExpectation
+                                                 configuration:nil];
+
+    // Builders start small and grow past their capacity, across the 16-bit payload length encoding.
+    for (NSNumber *length in @[ @0, @100, @126, @70000 ]) {
+        NSMutableData *payload = [NSMutableData dataWithLength:length.unsignedIntegerValue];
+        arc4random_buf(payload.mutableBytes, payload.length);
+
+        SRMessageBuilder *builder = [webSocket messageBuilderWithCapacity:64];
+        [builder appendBytes:payload.bytes length:payload.length];
+        NSError *error = nil;
+        XCTAssertTrue([webSocket sendMessageFromBuilder:builder error:&error]);
+        XCTAssertNil(error);
+
+        SRTOpCode opCode = 0;
+        XCTAssertEqualObjects([server readFrameWithOpCode:&opCode], payload);
+        XCTAssertEqual(opCode, SRTOpCodeBinaryFrame);
+    }
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+@end
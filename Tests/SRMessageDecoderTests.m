@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <stdatomic.h>
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+
+@interface SRMessageDecoderTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_expectation;
+    NSInteger _receivedCount;
+    NSInteger _pingCount;
+
+    // Set when delegate methods are expected to be called inline, on the queue of the socket.
+    BOOL _expectsInlineDelivery;
+    atomic_int _activeDelegateCallCount;
+}
+@end
+
+static const NSInteger SRTDecodedMessageCount = 1000;
+
+@implementation SRMessageDecoderTests
+
+- (void)testDecodedMessagesAreReportedInOrder
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRMessageDecoderTests.delegate", DISPATCH_QUEUE_SERIAL);
+    webSocket.decodesTextMessagesAsData = YES;
+    webSocket.messageDecoderBlock = ^id _Nullable(id message) {
+        XCTAssertTrue([message isKindOfClass:[NSData class]]);
+        // Uneven decode times shuffle completion order on the concurrent queue.
+        usleep(arc4random_uniform(200));
+        return [NSJSONSerialization JSONObjectWithData:message options:0 error:NULL];
+    };
+    [webSocket open];
+
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        if (![server acceptConnection]) {
+            return;
+        }
+        for (NSInteger i = 0; i < SRTDecodedMessageCount; i++) {
+            NSData *payload = [NSJSONSerialization dataWithJSONObject:@{ @"index" : @(i) } options:0 error:NULL];
+            if (![server sendFrameWithOpCode:SRTOpCodeTextFrame payload:payload]) {
+                return;
+            }
+        }
+    });
+
+    _expectation = [self expectationWithDescription:@"Received all messages"];
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+
+    XCTAssertEqual(_receivedCount, SRTDecodedMessageCount);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testInlineDecodedMessagesAreSerializedWithOtherDelegateCalls
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = self;
+    webSocket.callsDelegateInline = YES;
+    webSocket.messageDecoderBlock = ^id _Nullable(id message) {
+        usleep(arc4random_uniform(200));
+        return [NSJSONSerialization JSONObjectWithData:[message dataUsingEncoding:NSUTF8StringEncoding] options:0 error:NULL];
+    };
+    _expectsInlineDelivery = YES;
+    [webSocket open];
+
+    // Pings are reported inline on the work queue while earlier messages are still being decoded.
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        if (![server acceptConnection]) {
+            return;
+        }
+        for (NSInteger i = 0; i < SRTDecodedMessageCount; i++) {
+            NSData *payload = [NSJSONSerialization dataWithJSONObject:@{ @"index" : @(i) } options:0 error:NULL];
+            if (![server sendFrameWithOpCode:SRTOpCodeTextFrame payload:payload] ||
+                ![server sendFrameWithOpCode:SRTOpCodePing payload:nil]) {
+                return;
+            }
+        }
+    });
+
+    _expectation = [self expectationWithDescription:@"Received all messages"];
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+
+    XCTAssertEqual(_receivedCount, SRTDecodedMessageCount);
+    XCTAssertGreaterThan(_pingCount, 0);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testTextMessageEndingInIncompleteCodePointClosesWithInvalidUTF8
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRMessageDecoderTests.delegate", DISPATCH_QUEUE_SERIAL);
+    webSocket.decodesTextMessagesAsData = YES;
+    webSocket.messageDecoderBlock = ^id _Nullable(id message) {
+        XCTFail(@"Invalid UTF-8 must not be decoded.");
+        return nil;
+    };
+    [webSocket open];
+    XCTAssertTrue([server acceptConnection]);
+
+    // First two bytes of a three byte code point, which streaming validation accepts until the message ends.
+    const uint8_t bytes[] = { 'a', 0xE2, 0x82 };
+    XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[NSData dataWithBytes:bytes length:sizeof(bytes)]]);
+
+    SRTOpCode opCode = 0;
+    NSData *payload = [server readFrameWithOpCode:&opCode];
+    XCTAssertEqual(opCode, SRTOpCodeConnectionClose);
+    XCTAssertGreaterThanOrEqual(payload.length, 2);
+    const uint8_t *closeCode = payload.bytes;
+    XCTAssertEqual((closeCode[0] << 8) | closeCode[1], SRStatusCodeInvalidUTF8);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - Delegate Calls
+///--------------------------------------
+
+- (void)_beginDelegateCallForWebSocket:(SRWebSocket *)webSocket
+{
+    if (!_expectsInlineDelivery) {
+        return;
+    }
+    // Work queue of the socket is tagged with the socket as its specific key.
+    XCTAssertTrue(dispatch_get_specific((__bridge void *)webSocket) != NULL);
+    XCTAssertEqual(atomic_fetch_add(&_activeDelegateCallCount, 1), 0);
+    // Widens the window for another delegate call to overlap with this one.
+    usleep(50);
+}
+
+- (void)_endDelegateCall
+{
+    if (_expectsInlineDelivery) {
+        atomic_fetch_sub(&_activeDelegateCallCount, 1);
+    }
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveDecodedMessage:(id)message
+{
+    [self _beginDelegateCallForWebSocket:webSocket];
+
+    XCTAssertTrue([message isKindOfClass:[NSDictionary class]]);
+    XCTAssertEqualObjects(message[@"index"], @(_receivedCount));
+    _receivedCount++;
+
+    if (_receivedCount == SRTDecodedMessageCount) {
+        [_expectation fulfill];
+    }
+
+    [self _endDelegateCall];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceivePingWithData:(nullable NSData *)data
+{
+    [self _beginDelegateCallForWebSocket:webSocket];
+    _pingCount++;
+    [self _endDelegateCall];
+}
+
+@end
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRMessage.h>
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+static const NSTimeInterval SRTReadSeparation = 0.1;
+
+@interface SRMessageMetadataTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_openExpectation;
+    XCTestExpectation *_messagesExpectation;
+    NSUInteger _expectedMessageCount;
+    NSMutableArray<SRMessage *> *_messages;
+}
+@end
+
+@implementation SRMessageMetadataTests
+
+- (void)setUp
+{
+    [super setUp];
+    _messages = [NSMutableArray array];
+}
+
+- (void)testByteTimesComeFromTheReadsThatCarriedTheMessage
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [self srt_openWebSocketWithServer:server
+                                                      delegate:self
+                                                 delegateQueue:dispatch_queue_create("SRMessageMetadataTests.delegate", DISPATCH_QUEUE_SERIAL)
+                                               openExpectation:&_openExpectation
+                                                 configuration:nil];
+
+    _expectedMessageCount = 2;
+    _messagesExpectation = [self expectationWithDescription:@"Received messages"];
+
+    // First message is split across two separated reads, second one arrives in a read of its own.
+    XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[@"Hello, " dataUsingEncoding:NSUTF8StringEncoding] fin:NO]);
+    [NSThread sleepForTimeInterval:SRTReadSeparation];
+    XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodeContinuationFrame payload:[@"World!" dataUsingEncoding:NSUTF8StringEncoding] fin:YES]);
+    [NSThread sleepForTimeInterval:SRTReadSeparation];
+    XCTAssertTrue([server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[@"Bye" dataUsingEncoding:NSUTF8StringEncoding]]);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    uint64_t minimumSeparation = (uint64_t)(SRTReadSeparation / 2 * NSEC_PER_SEC);
+
+    SRMessage *splitMessage = _messages[0];
+    XCTAssertEqualObjects(splitMessage.payload, @"Hello, World!");
+    XCTAssertEqual(splitMessage.frameCount, 2);
+    XCTAssertGreaterThan(splitMessage.firstByteTime, 0);
+    XCTAssertGreaterThanOrEqual(splitMessage.lastByteTime, splitMessage.firstByteTime + minimumSeparation);
+    XCTAssertGreaterThanOrEqual(splitMessage.queuedTime, splitMessage.lastByteTime);
+
+    SRMessage *message = _messages[1];
+    XCTAssertEqualObjects(message.payload, @"Bye");
+    XCTAssertEqual(message.firstByteTime, message.lastByteTime);
+    XCTAssertGreaterThanOrEqual(message.firstByteTime, splitMessage.lastByteTime + minimumSeparation);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithMetadata:(SRMessage *)message
+{
+    [_messages addObject:message];
+    if (_messages.count == _expectedMessageCount) {
+        [_messagesExpectation fulfill];
+    }
+}
+
+@end
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+
+@interface SRReceiveFlowControlTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_expectation;
+    uint32_t _receivedCount;
+    NSUInteger _maximumBacklogLength;
+}
+@end
+
+static const uint32_t SRTMessageCount = 2000;
+static const NSUInteger SRTMessageLength = 16 * 1024;
+
+@implementation SRReceiveFlowControlTests
+
+- (void)testSlowDelegatePausesReading
+{
+    const NSUInteger backlogLimit = 256 * 1024;
+
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRReceiveFlowControlTests.delegate", DISPATCH_QUEUE_SERIAL);
+    webSocket.maximumDelegateBacklogLength = backlogLimit;
+    [webSocket open];
+
+    // Producer writes as fast as the kernel lets it, every message is tagged with its index.
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        if (![server acceptConnection]) {
+            return;
+        }
+        NSMutableData *payload = [NSMutableData dataWithLength:SRTMessageLength];
+        for (uint32_t i = 0; i < SRTMessageCount; i++) {
+            memcpy(payload.mutableBytes, &i, sizeof(i));
+            if (![server sendFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload]) {
+                return;
+            }
+        }
+    });
+
+    _expectation = [self expectationWithDescription:@"Received all messages"];
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+
+    XCTAssertEqual(_receivedCount, SRTMessageCount);
+    XCTAssertGreaterThan(webSocket.readPauseCount, 0);
+    XCTAssertGreaterThan(webSocket.readPausedDuration, 0.0);
+    // Reading stops as soon as the budget is reached, so the backlog can only overshoot it by a single read and a partially decoded frame.
+    XCTAssertLessThanOrEqual(_maximumBacklogLength, backlogLimit + SRTMessageLength + 64 * 1024);
+
+    [webSocket close];
+    [server close];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    _maximumBacklogLength = MAX(_maximumBacklogLength, webSocket.delegateBacklogLength);
+
+    uint32_t index = UINT32_MAX;
+    [data getBytes:&index length:sizeof(index)];
+    XCTAssertEqual(index, _receivedCount);
+    _receivedCount++;
+
+    if (_receivedCount == SRTMessageCount) {
+        [_expectation fulfill];
+        return;
+    }
+    // Delegate is intentionally slower than the producer.
+    usleep(200);
+}
+
+@end
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+
+@interface SRReceiveOnDemandTests : XCTestCase
+@end
+
+@implementation SRReceiveOnDemandTests
+
+- (void)testSlowConsumerKeepsBacklogBounded
+{
+    const uint32_t messageCount = 2000;
+    const NSUInteger messageLength = 16 * 1024;
+    const NSUInteger backlogLimit = 256 * 1024;
+
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.receivesMessagesOnDemand = YES;
+    webSocket.maximumReceiveBacklogLength = backlogLimit;
+    [webSocket open];
+
+    // Producer writes as fast as the kernel lets it, every message is tagged with its index.
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        if (![server acceptConnection]) {
+            return;
+        }
+        NSMutableData *payload = [NSMutableData dataWithLength:messageLength];
+        for (uint32_t i = 0; i < messageCount; i++) {
+            memcpy(payload.mutableBytes, &i, sizeof(i));
+            if (![server sendFrameWithOpCode:SRTOpCodeBinaryFrame payload:payload]) {
+                return;
+            }
+        }
+    });
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Received all messages"];
+    dispatch_queue_t consumerQueue = dispatch_queue_create("SRReceiveOnDemandTests.consumer", DISPATCH_QUEUE_SERIAL);
+
+    __block uint32_t receivedCount = 0;
+    __block NSUInteger maximumBacklogLength = 0;
+    __block void (^receiveNext)(void) = nil;
+    receiveNext = ^{
+        [webSocket receiveMessagesWithMaximumCount:1 completionQueue:consumerQueue completion:^(NSArray *messages, NSError *error) {
+            XCTAssertNil(error);
+            NSData *message = messages.firstObject;
+            XCTAssertEqual(message.length, messageLength);
+
+            uint32_t index = UINT32_MAX;
+            [message getBytes:&index length:sizeof(index)];
+            XCTAssertEqual(index, receivedCount);
+            receivedCount++;
+
+            maximumBacklogLength = MAX(maximumBacklogLength, webSocket.receiveBacklogLength);
+            if (error || receivedCount == messageCount) {
+                [expectation fulfill];
+                return;
+            }
+            // Consumer is intentionally slower than the producer.
+            usleep(200);
+            receiveNext();
+        }];
+    };
+    receiveNext();
+
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+    receiveNext = nil;
+
+    XCTAssertEqual(receivedCount, messageCount);
+    // Reading stops as soon as the limit is reached, so the backlog can only overshoot it by a single read and a partially decoded frame.
+    XCTAssertLessThanOrEqual(maximumBacklogLength, backlogLimit + messageLength + 64 * 1024);
+
+    [webSocket close];
+    [server close];
+}
+
+@end
@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRMessageBuilder.h>
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+#import "XCTestCase+SRTLocalServer.h"
+
+@interface SRSendCompletionTests : XCTestCase <SRWebSocketDelegate>
+{
+    SRTLocalServer *_server;
+    SRWebSocket *_webSocket;
+    XCTestExpectation *_openExpectation;
+    dispatch_queue_t _completionQueue;
+}
+@end
+
+@implementation SRSendCompletionTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    _server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(_server);
+    _completionQueue = dispatch_queue_create("SRSendCompletionTests.completion", DISPATCH_QUEUE_SERIAL);
+
+    _webSocket = [self srt_openWebSocketWithServer:_server
+                                          delegate:self
+                                     delegateQueue:dispatch_queue_create("SRSendCompletionTests.delegate", DISPATCH_QUEUE_SERIAL)
+                                   openExpectation:&_openExpectation
+                                     configuration:nil];
+}
+
+- (void)tearDown
+{
+    [_webSocket close];
+    [_server close];
+    [super tearDown];
+}
+
+// Sends `count` messages of `length` bytes, `completion` is called with the index of the message it completes.
+- (void)_sendMessageCount:(NSUInteger)count
+                   length:(NSUInteger)length
+               completion:(void (^)(NSUInteger index, SRSendTimestamps timestamps, NSError *_Nullable error))completion
+{
+    NSMutableData *payload = [NSMutableData dataWithLength:length];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSError *error = nil;
+        BOOL scheduled = [_webSocket sendData:payload completionQueue:_completionQueue completion:^(SRSendTimestamps timestamps, NSError *_Nullable completionError) {
+            completion(i, timestamps, completionError);
+        } error:&error];
+        XCTAssertTrue(scheduled);
+        XCTAssertNil(error);
+    }
+}
+
+- (void)testCompletionsAreCalledInOrderWithTimestamps
+{
+    const NSUInteger messageCount = 100;
+    const NSUInteger messageLength = 64 * 1024;
+
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        for (NSUInteger i = 0; i < messageCount; i++) {
+            if (![self->_server readFrameWithOpCode:NULL]) {
+                return;
+            }
+        }
+    });
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Completed all messages"];
+    __block NSUInteger completedCount = 0;
+    __block uint64_t previousLastByteTime = 0;
+    [self _sendMessageCount:messageCount length:messageLength completion:^(NSUInteger index, SRSendTimestamps timestamps, NSError *error) {
+        XCTAssertEqual(index, completedCount);
+        XCTAssertNil(error);
+        XCTAssertGreaterThan(timestamps.enqueueTime, 0);
+        XCTAssertGreaterThanOrEqual(timestamps.firstByteTime, timestamps.enqueueTime);
+        XCTAssertGreaterThanOrEqual(timestamps.lastByteTime, timestamps.firstByteTime);
+        XCTAssertGreaterThanOrEqual(timestamps.lastByteTime, previousLastByteTime);
+        previousLastByteTime = timestamps.lastByteTime;
+
+        completedCount++;
+        if (completedCount == messageCount) {
+            [expectation fulfill];
+        }
+    }];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+}
+
+- (void)testUnwrittenMessagesCompleteWithErrorWhenConnectionCloses
+{
+    // Way more than socket buffers hold, while the server doesn't read.
+    const NSUInteger messageCount = 32;
+    const NSUInteger messageLength = 1024 * 1024;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Completed all messages"];
+    __block NSUInteger completedCount = 0;
+    __block NSUInteger failedCount = 0;
+    [self _sendMessageCount:messageCount length:messageLength completion:^(NSUInteger index, SRSendTimestamps timestamps, NSError *error) {
+        XCTAssertEqual(index, completedCount);
+        XCTAssertGreaterThan(timestamps.enqueueTime, 0);
+        if (error) {
+            XCTAssertEqual(error.code, 2146);
+            XCTAssertEqual(timestamps.lastByteTime, 0);
+            failedCount++;
+        } else {
+            // Once a message failed, nothing after it can be written.
+            XCTAssertEqual(failedCount, 0);
+        }
+
+        completedCount++;
+        if (completedCount == messageCount) {
+            [expectation fulfill];
+        }
+    }];
+
+    // Give the socket time to fill the buffers, then drop the connection with everything else still unwritten.
+    [NSThread sleepForTimeInterval:0.5];
+    [_server close];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+
+    XCTAssertGreaterThan(failedCount, 0);
+}
+
+- (void)testNilDataCompletesWithError
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Completed"];
+    XCTAssertTrue([_webSocket sendData:nil completionQueue:_completionQueue completion:^(SRSendTimestamps timestamps, NSError *error) {
+        XCTAssertEqual(error.code, 2151);
+        XCTAssertEqual(timestamps.lastByteTime, 0);
+        [expectation fulfill];
+    } error:NULL]);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+}
+
+- (void)testPartsDispatchDataAndBuilderMessagesComplete
+{
+    NSData *payload = [@"payload" dataUsingEncoding:NSUTF8StringEncoding];
+    void (^completion)(SRSendTimestamps, NSError *) = ^(SRSendTimestamps timestamps, NSError *error) {
+        XCTAssertNil(error);
+        XCTAssertGreaterThan(timestamps.lastByteTime, 0);
+    };
+
+    XCTestExpectation *partsExpectation = [self expectationWithDescription:@"Completed parts"];
+    NSArray<NSData *> *parts = @[ [payload subdataWithRange:NSMakeRange(0, 3)], [payload subdataWithRange:NSMakeRange(3, payload.length - 3)] ];
+    XCTAssertTrue([_webSocket sendDataParts:parts completionQueue:_completionQueue completion:^(SRSendTimestamps timestamps, NSError *error) {
+        completion(timestamps, error);
+        [partsExpectation fulfill];
+    } error:NULL]);
+
+    XCTestExpectation *dispatchDataExpectation = [self expectationWithDescription:@"Completed dispatch data"];
+    dispatch_data_t dispatchData = dispatch_data_create(payload.bytes, payload.length, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    XCTAssertTrue([_webSocket sendDispatchData:dispatchData completionQueue:_completionQueue completion:^(SRSendTimestamps timestamps, NSError *error) {
+        completion(timestamps, error);
+        [dispatchDataExpectation fulfill];
+    } error:NULL]);
+
+    XCTestExpectation *builderExpectation = [self expectationWithDescription:@"Completed builder"];
+    SRMessageBuilder *builder = [_webSocket messageBuilderWithCapacity:payload.length];
+    [builder appendBytes:payload.bytes length:payload.length];
+    XCTAssertTrue([_webSocket sendMessageFromBuilder:builder completionQueue:_completionQueue completion:^(SRSendTimestamps timestamps, NSError *error) {
+        completion(timestamps, error);
+        [builderExpectation fulfill];
+    } error:NULL]);
+
+    for (NSUInteger i = 0; i < 3; i++) {
+        XCTAssertEqualObjects([_server readFrameWithOpCode:NULL], payload);
+    }
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocketDidOpen:(SRWebSocket *)webSocket
+{
+    [_openExpectation fulfill];
+}
+
+@end
@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import "SRTimerWheel.h"
+
+// Long enough that the wheel never ticks on its own during a test, which advances it by hand instead.
+static const NSTimeInterval SRTManualTickInterval = 10.0;
+
+@interface SRTimerWheel (SRTimerWheelTests)
+
+- (void)_advanceTicks:(unsigned long)tickCount;
+
+@end
+
+@interface SRTimerWheelTests : XCTestCase
+{
+    dispatch_queue_t _queue;
+    NSMutableArray<NSNumber *> *_firedTicks;
+}
+@end
+
+@implementation SRTimerWheelTests
+
+- (void)setUp
+{
+    [super setUp];
+    _queue = dispatch_queue_create("SRTimerWheelTests.timers", DISPATCH_QUEUE_SERIAL);
+    _firedTicks = [NSMutableArray array];
+}
+
+// Schedules a timer that expires at `tick` of a manually advanced wheel, the deadline is halfway into the tick before.
+- (SRTimerWheelTimer *)_scheduleTimerOnWheel:(SRTimerWheel *)wheel atTick:(uint64_t)tick
+{
+    return [wheel scheduleTimerWithDelay:((NSTimeInterval)tick - 0.5) * SRTManualTickInterval queue:_queue block:^{
+        [self->_firedTicks addObject:@(tick)];
+    }];
+}
+
+// Fired timers are reported asynchronously on their queue, wait for them.
+- (NSArray<NSNumber *> *)_firedTicksAfterAdvancingWheel:(SRTimerWheel *)wheel by:(unsigned long)tickCount
+{
+    [wheel _advanceTicks:tickCount];
+    __block NSArray<NSNumber *> *firedTicks = nil;
+    dispatch_sync(_queue, ^{
+        firedTicks = [self->_firedTicks copy];
+        [self->_firedTicks removeAllObjects];
+    });
+    return firedTicks;
+}
+
+- (void)testTimersFireAtTheirTickAcrossLevelBoundaries
+{
+    SRTimerWheel *wheel = [[SRTimerWheel alloc] initWithTickInterval:SRTManualTickInterval];
+
+    // First level covers 256 ticks, the second one 2^14 and the third one 2^20.
+    NSArray<NSNumber *> *ticks = @[ @1, @2, @255, @256, @257, @300, @511, @512, @16383, @16384, @16385, @20000, @(1 << 20), @((1 << 20) + 1) ];
+    for (NSNumber *tick in ticks) {
+        [self _scheduleTimerOnWheel:wheel atTick:tick.unsignedLongLongValue];
+    }
+
+    uint64_t currentTick = 0;
+    for (NSNumber *tick in ticks) {
+        uint64_t expirationTick = tick.unsignedLongLongValue;
+        if (expirationTick - currentTick > 1) {
+            XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:(unsigned long)(expirationTick - currentTick - 1)], @[]);
+        }
+        XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:1], @[ tick ]);
+        currentTick = expirationTick;
+    }
+}
+
+- (void)testTimersBeyondRangeOfWheelFireAtTheirTick
+{
+    SRTimerWheel *wheel = [[SRTimerWheel alloc] initWithTickInterval:SRTManualTickInterval];
+
+    // Top level ends at 2^26 ticks, the timer has to be put back in before it can fire.
+    const uint64_t tick = ((uint64_t)1 << 26) + 300;
+    [self _scheduleTimerOnWheel:wheel atTick:tick];
+
+    XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:(unsigned long)(tick - 1)], @[]);
+    XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:1], @[ @(tick) ]);
+}
+
+- (void)testCoalescedTicksFireEveryTimerTheyCover
+{
+    SRTimerWheel *wheel = [[SRTimerWheel alloc] initWithTickInterval:SRTManualTickInterval];
+    for (NSNumber *tick in @[ @5, @256, @300, @301, @16384, @16500 ]) {
+        [self _scheduleTimerOnWheel:wheel atTick:tick.unsignedLongLongValue];
+    }
+
+    // A single tick event with a count above one, as the dispatch timer reports ticks that were missed.
+    NSArray<NSNumber *> *firedTicks = [self _firedTicksAfterAdvancingWheel:wheel by:300];
+    XCTAssertEqualObjects(firedTicks, (@[ @5, @256, @300 ]));
+
+    firedTicks = [self _firedTicksAfterAdvancingWheel:wheel by:16384 - 300];
+    XCTAssertEqualObjects(firedTicks, (@[ @301, @16384 ]));
+
+    firedTicks = [self _firedTicksAfterAdvancingWheel:wheel by:1000];
+    XCTAssertEqualObjects(firedTicks, (@[ @16500 ]));
+}
+
+- (void)testCancelledTimersDontFire
+{
+    SRTimerWheel *wheel = [[SRTimerWheel alloc] initWithTickInterval:SRTManualTickInterval];
+    SRTimerWheelTimer *firstLevelTimer = [self _scheduleTimerOnWheel:wheel atTick:10];
+    SRTimerWheelTimer *secondLevelTimer = [self _scheduleTimerOnWheel:wheel atTick:300];
+    [self _scheduleTimerOnWheel:wheel atTick:400];
+
+    [wheel cancelTimer:firstLevelTimer];
+    [wheel cancelTimer:secondLevelTimer];
+    XCTAssertTrue(firstLevelTimer.cancelled);
+    XCTAssertTrue(secondLevelTimer.cancelled);
+
+    XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:399], @[]);
+    XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:1], @[ @400 ]);
+}
+
+- (void)testCancelOnTimerQueueDuringCascade
+{
+    const uint64_t timerCount = 2000;
+    SRTimerWheel *wheel = [[SRTimerWheel alloc] initWithTickInterval:SRTManualTickInterval];
+
+    // All of them start on the second level, and cascade down at tick 256 or 512 while they are being cancelled.
+    NSMutableArray<SRTimerWheelTimer *> *timers = [NSMutableArray array];
+    NSMutableSet<NSNumber *> *cancelledIndexes = [NSMutableSet set];
+    NSMutableArray<NSNumber *> *firedIndexes = [NSMutableArray array];
+    __block BOOL firedAfterCancel = NO;
+    for (uint64_t i = 0; i < timerCount; i++) {
+        NSTimeInterval delay = ((NSTimeInterval)(256 + i % 400) - 0.5) * SRTManualTickInterval;
+        [timers addObject:[wheel scheduleTimerWithDelay:delay queue:_queue block:^{
+            firedAfterCancel = firedAfterCancel || [cancelledIndexes containsObject:@(i)];
+            [firedIndexes addObject:@(i)];
+        }]];
+    }
+
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        for (NSUInteger tick = 0; tick < 700; tick++) {
+            [wheel _advanceTicks:1];
+        }
+    });
+    dispatch_group_async(group, _queue, ^{
+        for (uint64_t i = 0; i < timerCount; i += 2) {
+            [wheel cancelTimer:timers[i]];
+            [cancelledIndexes addObject:@(i)];
+        }
+    });
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    dispatch_sync(_queue, ^{
+        XCTAssertFalse(firedAfterCancel);
+        NSMutableSet<NSNumber *> *expectedIndexes = [NSMutableSet set];
+        for (uint64_t i = 1; i < timerCount; i += 2) {
+            [expectedIndexes addObject:@(i)];
+        }
+        NSSet<NSNumber *> *firedIndexSet = [NSSet setWithArray:firedIndexes];
+        XCTAssertTrue([expectedIndexes isSubsetOfSet:firedIndexSet]);
+        XCTAssertEqual(firedIndexes.count, firedIndexSet.count);
+    });
+
+    // Bookkeeping survived the cancellations, a new timer still fires on the next tick.
+    [wheel scheduleTimerWithDelay:0.5 * SRTManualTickInterval queue:_queue block:^{
+        [self->_firedTicks addObject:@0];
+    }];
+    XCTAssertEqualObjects([self _firedTicksAfterAdvancingWheel:wheel by:1], @[ @0 ]);
+}
+
+- (void)testTimersDontFireEarly
+{
+    // Small ticks cross the second and third level within a test and make the dispatch timer coalesce ticks.
+    SRTimerWheel *wheel = [[SRTimerWheel alloc] initWithTickInterval:0.0001];
+    NSArray<NSNumber *> *delays = @[ @0.00005, @0.001, @0.02, @0.03, @1.7 ];
+
+    NSMutableArray<XCTestExpectation *> *expectations = [NSMutableArray array];
+    NSMutableArray<NSNumber *> *firedDelays = [NSMutableArray array];
+    for (NSNumber *delay in delays) {
+        XCTestExpectation *expectation = [self expectationWithDescription:delay.stringValue];
+        [expectations addObject:expectation];
+        uint64_t scheduleTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        [wheel scheduleTimerWithDelay:delay.doubleValue queue:_queue block:^{
+            uint64_t elapsedTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - scheduleTime;
+            XCTAssertGreaterThanOrEqual(elapsedTime, (uint64_t)(delay.doubleValue * NSEC_PER_SEC));
+            [firedDelays addObject:delay];
+            [expectation fulfill];
+        }];
+    }
+    [self waitForExpectations:expectations timeout:10.0];
+
+    dispatch_sync(_queue, ^{
+        XCTAssertEqualObjects(firedDelays, delays);
+    });
+}
+
+@end
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+
+@interface SRTrafficCaptureTests : XCTestCase <SRWebSocketDelegate>
+{
+    NSURL *_captureURL;
+    NSMutableArray *_messages;
+    XCTestExpectation *_closeExpectation;
+}
+@end
+
+@implementation SRTrafficCaptureTests
+
+- (void)setUp
+{
+    [super setUp];
+    _captureURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+    _messages = [NSMutableArray array];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:_captureURL error:NULL];
+    [super tearDown];
+}
+
+- (SRWebSocket *)_webSocketWithURL:(NSURL *)url
+{
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:url];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRTrafficCaptureTests.delegate", DISPATCH_QUEUE_SERIAL);
+    return webSocket;
+}
+
+- (void)testReplayDeliversCapturedMessages
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [self _webSocketWithURL:server.URL];
+    webSocket.captureFileURL = _captureURL;
+    [webSocket open];
+
+    XCTAssertTrue([server acceptConnection]);
+    [server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[@"hello" dataUsingEncoding:NSUTF8StringEncoding]];
+    [server sendFrameWithOpCode:SRTOpCodeBinaryFrame payload:[NSMutableData dataWithLength:1000]];
+    uint16_t closeCode = CFSwapInt16HostToBig(SRStatusCodeNormal);
+    [server sendFrameWithOpCode:SRTOpCodeConnectionClose payload:[NSData dataWithBytes:&closeCode length:sizeof(closeCode)]];
+
+    SRTOpCode opCode = 0;
+    XCTAssertNotNil([server readFrameWithOpCode:&opCode]);
+    XCTAssertEqual(opCode, SRTOpCodeConnectionClose);
+
+    _closeExpectation = [self expectationWithDescription:@"Closed"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+    [server close];
+
+    NSArray *capturedMessages = [_messages copy];
+    XCTAssertEqual(capturedMessages.count, 2);
+    [_messages removeAllObjects];
+
+    // The replaying socket never connects, so its URL doesn't matter.
+    SRWebSocket *replayWebSocket = [self _webSocketWithURL:server.URL];
+    _closeExpectation = [self expectationWithDescription:@"Replay closed"];
+    NSError *error = nil;
+    XCTAssertTrue([replayWebSocket replayCaptureFromURL:_captureURL atRecordedSpeed:NO error:&error]);
+    XCTAssertNil(error);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqualObjects(_messages, capturedMessages);
+}
+
+- (void)testReplayFailsForFileThatIsNotACapture
+{
+    [[@"GET / HTTP/1.1\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:_captureURL atomically:YES];
+
+    SRWebSocket *webSocket = [self _webSocketWithURL:[NSURL URLWithString:@"ws://localhost"]];
+    NSError *error = nil;
+    XCTAssertFalse([webSocket replayCaptureFromURL:_captureURL atRecordedSpeed:NO error:&error]);
+    XCTAssertNotNil(error);
+    XCTAssertEqual(webSocket.readyState, SR_CONNECTING);
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithString:(NSString *)string
+{
+    [_messages addObject:string];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessageWithData:(NSData *)data
+{
+    [_messages addObject:data];
+}
+
+- (void)webSocket:(SRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(nullable NSString *)reason wasClean:(BOOL)wasClean
+{
+    [_closeExpectation fulfill];
+}
+
+@end
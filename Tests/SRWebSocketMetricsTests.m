@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+#import <SocketRocket/SRWebSocketMetrics.h>
+
+#import "SRTLocalServer.h"
+
+@interface SRWebSocketMetricsTests : XCTestCase <SRWebSocketDelegate>
+{
+    XCTestExpectation *_expectation;
+    NSUInteger _receivedCount;
+}
+@end
+
+@implementation SRWebSocketMetricsTests
+
+- (void)testCountersReflectTraffic
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRWebSocketMetricsTests.delegate", DISPATCH_QUEUE_SERIAL);
+    [webSocket open];
+
+    XCTAssertTrue([server acceptConnection]);
+    [server sendFrameWithOpCode:SRTOpCodeBinaryFrame payload:[NSMutableData dataWithLength:1000]];
+    [server sendFrameWithOpCode:SRTOpCodeTextFrame payload:[@"hello" dataUsingEncoding:NSUTF8StringEncoding]];
+    [server sendFrameWithOpCode:SRTOpCodePing payload:nil];
+
+    SRTOpCode opCode = 0;
+    XCTAssertNotNil([server readFrameWithOpCode:&opCode]);
+    XCTAssertEqual(opCode, SRTOpCodePong);
+
+    _expectation = [self expectationWithDescription:@"Received all messages"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    SRWebSocketMetrics *metrics = webSocket.metrics;
+    XCTAssertEqual(metrics.binaryFramesReceived, 1);
+    XCTAssertEqual(metrics.textFramesReceived, 1);
+    XCTAssertEqual(metrics.pingFramesReceived, 1);
+    XCTAssertEqual(metrics.pongFramesSent, 1);
+    XCTAssertEqual(metrics.messagesDelivered, 2);
+    XCTAssertEqual(metrics.peakFrameDataLength, 1000);
+    XCTAssertGreaterThan(metrics.bytesReceived, 1000 + 5);
+    XCTAssertGreaterThan(metrics.readCount, 0);
+    XCTAssertGreaterThan(metrics.writeCount, 0);
+
+    // Plain connection to the loopback server, so there is no proxy or TLS phase.
+    SRHandshakeTimeline timeline = webSocket.handshakeTimeline;
+    XCTAssertGreaterThan(timeline.openTime, 0);
+    XCTAssertGreaterThanOrEqual(timeline.connectStartTime, timeline.openTime);
+    XCTAssertGreaterThanOrEqual(timeline.connectEndTime, timeline.connectStartTime);
+    XCTAssertGreaterThanOrEqual(timeline.upgradeRequestTime, timeline.connectEndTime);
+    XCTAssertGreaterThanOrEqual(timeline.headersCompleteTime, timeline.upgradeRequestTime);
+    XCTAssertEqual(timeline.proxyConnectStartTime, 0);
+    XCTAssertEqual(timeline.TLSStartTime, 0);
+    XCTAssertEqual(SRWebSocket.aggregateMetrics.handshakeTimeline.openTime, 0);
+
+    // Aggregate covers this socket too.
+    XCTAssertGreaterThanOrEqual(SRWebSocket.aggregateMetrics.bytesReceived, metrics.bytesReceived);
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testAllocationAuditCountsReceivePipeline
+{
+    SRTLocalServer *server = [[SRTLocalServer alloc] init];
+    XCTAssertNotNil(server);
+
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = self;
+    webSocket.delegateDispatchQueue = dispatch_queue_create("SRWebSocketMetricsTests.delegate", DISPATCH_QUEUE_SERIAL);
+    [webSocket open];
+
+    XCTAssertTrue([server acceptConnection]);
+    // Long enough not to fit a tagged pointer string.
+    NSData *payload = [[@"" stringByPaddingToLength:100 withString:@"text " startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    [server sendFrameWithOpCode:SRTOpCodeTextFrame payload:payload];
+    [server sendFrameWithOpCode:SRTOpCodeTextFrame payload:payload];
+
+    _expectation = [self expectationWithDescription:@"Received all messages"];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    SRWebSocketMetrics *metrics = webSocket.metrics;
+    if (SRWebSocketMetrics.allocationAuditEnabled) {
+        XCTAssertGreaterThan([metrics allocationCountForStage:SRAllocationStageConsumerBlock], 0);
+        XCTAssertGreaterThanOrEqual([metrics allocationCountForStage:SRAllocationStageFrameData], 2);
+        XCTAssertEqual([metrics allocationCountForStage:SRAllocationStageMessageString], 2);
+        XCTAssertGreaterThanOrEqual([metrics allocatedBytesForStage:SRAllocationStageMessageString], 2 * payload.length);
+    } else {
+        for (SRAllocationStage stage = 0; stage < SRAllocationStageCount; stage++) {
+            XCTAssertEqual([metrics allocationCountForStage:stage], 0);
+            XCTAssertEqual([metrics allocatedBytesForStage:stage], 0);
+        }
+    }
+
+    [webSocket close];
+    [server close];
+}
+
+- (void)testTraceEventJSONIsValid
+{
+    NSDictionary *trace = [NSJSONSerialization JSONObjectWithData:SRWebSocket.traceEventJSONData options:0 error:NULL];
+    XCTAssertTrue([trace isKindOfClass:[NSDictionary class]]);
+    XCTAssertTrue([trace[@"traceEvents"] isKindOfClass:[NSArray class]]);
+}
+
+///--------------------------------------
+#pragma mark - SRWebSocketDelegate
+///--------------------------------------
+
+- (void)webSocket:(SRWebSocket *)webSocket didReceiveMessage:(id)message
+{
+    _receivedCount++;
+    if (_receivedCount == 2) {
+        [_expectation fulfill];
+    }
+}
+
+@end
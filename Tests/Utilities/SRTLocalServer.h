@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(uint8_t, SRTOpCode) {
+    SRTOpCodeContinuationFrame = 0x0,
+    SRTOpCodeTextFrame = 0x1,
+    SRTOpCodeBinaryFrame = 0x2,
+    SRTOpCodeConnectionClose = 0x8,
+    SRTOpCodePing = 0x9,
+    SRTOpCodePong = 0xA,
+};
+
+/**
+ Minimal blocking web socket server peer listening on the loopback interface.
+ It accepts a single connection and exposes frame level reads and writes, so tests and benchmarks control exactly what the client sees.
+ */
+@interface SRTLocalServer : NSObject
+
+/**
+ URL to connect to, with the port that was assigned to the listening socket.
+ */
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+/**
+ Creates a server listening on an ephemeral port of `127.0.0.1`.
+ Returns `nil` if the listening socket couldn't be created.
+ */
+- (nullable instancetype)init;
+
+/**
+ Blocks until a client connects and completes the opening handshake.
+
+ @return `YES` if the handshake succeeded, otherwise - `NO`.
+ */
+- (BOOL)acceptConnection;
+
+/**
+ Writes a single unmasked frame with `FIN` set.
+ */
+- (BOOL)sendFrameWithOpCode:(SRTOpCode)opCode payload:(nullable NSData *)payload;
+
+/**
+ Writes a single unmasked frame, with `FIN` set only if `fin` is `YES`.
+ */
+- (BOOL)sendFrameWithOpCode:(SRTOpCode)opCode payload:(nullable NSData *)payload fin:(BOOL)fin;
+
+/**
+ Writes a frame with `FIN` set for each of `payloads` with a single write, so the client usually reads them all at once.
+ */
+- (BOOL)sendFramesWithOpCode:(SRTOpCode)opCode payloads:(NSArray<NSData *> *)payloads;
+
+/**
+ Blocks, sending every data message from the client back with the same opcode and answering pings, until the connection is closed.
+
+ @param fragmentLength Maximum payload length of a single frame of an echoed message, longer messages are split into continuation frames.
+ `0` sends every message as a single frame.
+ */
+- (void)echoMessagesWithFragmentLength:(NSUInteger)fragmentLength;
+
+/**
+ Blocks until a whole frame is read from the client and returns its unmasked payload, or `nil` if the connection was closed.
+ */
+- (nullable NSData *)readFrameWithOpCode:(SRTOpCode *_Nullable)opCode;
+
+/**
+ Closes the connection and the listening socket.
+ */
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
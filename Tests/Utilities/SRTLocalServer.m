@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "SRTLocalServer.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import <arpa/inet.h>
+#import <netinet/in.h>
+#import <netinet/tcp.h>
+#import <sys/socket.h>
+#import <unistd.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSString *const SRTLocalServerAcceptKeySuffix = @"258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+@implementation SRTLocalServer {
+    int _listenSocket;
+    int _socket;
+}
+
+- (nullable instancetype)init
+{
+    self = [super init];
+    if (!self) return self;
+
+    _socket = -1;
+    _listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenSocket < 0) {
+        return nil;
+    }
+
+    struct sockaddr_in address = {
+        .sin_len = sizeof(struct sockaddr_in),
+        .sin_family = AF_INET,
+        .sin_port = 0,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addressLength = sizeof(address);
+    if (bind(_listenSocket, (struct sockaddr *)&address, addressLength) != 0 ||
+        listen(_listenSocket, 1) != 0 ||
+        getsockname(_listenSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+        close(_listenSocket);
+        return nil;
+    }
+
+    _URL = [NSURL URLWithString:[NSString stringWithFormat:@"ws://127.0.0.1:%d/", ntohs(address.sin_port)]];
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [self close];
+}
+
+#pragma mark - Connection
+
+- (BOOL)acceptConnection
+{
+    _socket = accept(_listenSocket, NULL, NULL);
+    if (_socket < 0) {
+        return NO;
+    }
+    int noDelay = 1;
+    setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    NSMutableData *request = [NSMutableData data];
+    NSData *terminator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    while ([request rangeOfData:terminator options:0 range:NSMakeRange(0, request.length)].location == NSNotFound) {
+        uint8_t byte;
+        if (![self _readBytes:&byte length:1]) {
+            return NO;
+        }
+        [request appendBytes:&byte length:1];
+    }
+
+    NSString *key = nil;
+    NSString *requestString = [[NSString alloc] initWithData:request encoding:NSUTF8StringEncoding];
+    for (NSString *line in [requestString componentsSeparatedByString:@"\r\n"]) {
+        NSString *prefix = @"sec-websocket-key:";
+        if ([line.lowercaseString hasPrefix:prefix]) {
+            key = [[line substringFromIndex:prefix.length] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        }
+    }
+    if (!key) {
+        return NO;
+    }
+
+    NSData *acceptKey = [[key stringByAppendingString:SRTLocalServerAcceptKeySuffix] dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1(acceptKey.bytes, (CC_LONG)acceptKey.length, digest);
+    NSString *accept = [[NSData dataWithBytes:digest length:sizeof(digest)] base64EncodedStringWithOptions:0];
+    NSString *response = [NSString stringWithFormat:@"HTTP/1.1 101 Switching Protocols\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Accept: %@\r\n\r\n", accept];
+    return [self _writeData:[response dataUsingEncoding:NSASCIIStringEncoding]];
+}
+
+- (void)close
+{
+    if (_socket >= 0) {
+        close(_socket);
+        _socket = -1;
+    }
+    if (_listenSocket >= 0) {
+        close(_listenSocket);
+        _listenSocket = -1;
+    }
+}
+
+#pragma mark - Frames
+
+- (BOOL)sendFrameWithOpCode:(SRTOpCode)opCode payload:(nullable NSData *)payload
+{
+    return [self sendFrameWithOpCode:opCode payload:payload fin:YES];
+}
+
+- (BOOL)sendFrameWithOpCode:(SRTOpCode)opCode payload:(nullable NSData *)payload fin:(BOOL)fin
+{
+    return [self _writeData:[self _frameWithOpCode:opCode payload:payload fin:fin]];
+}
+
+- (BOOL)sendFramesWithOpCode:(SRTOpCode)opCode payloads:(NSArray<NSData *> *)payloads
+{
+    NSMutableData *frames = [NSMutableData data];
+    for (NSData *payload in payloads) {
+        [frames appendData:[self _frameWithOpCode:opCode payload:payload fin:YES]];
+    }
+    return [self _writeData:frames];
+}
+
+- (NSData *)_frameWithOpCode:(SRTOpCode)opCode payload:(nullable NSData *)payload fin:(BOOL)fin
+{
+    uint8_t header[10];
+    size_t headerLength = 2;
+    uint64_t payloadLength = payload.length;
+
+    header[0] = (fin ? 0x80 : 0x00) | opCode;
+    if (payloadLength < 126) {
+        header[1] = (uint8_t)payloadLength;
+    } else if (payloadLength <= UINT16_MAX) {
+        header[1] = 126;
+        uint16_t length = CFSwapInt16HostToBig((uint16_t)payloadLength);
+        memcpy(header + headerLength, &length, sizeof(length));
+        headerLength += sizeof(length);
+    } else {
+        header[1] = 127;
+        uint64_t length = CFSwapInt64HostToBig(payloadLength);
+        memcpy(header + headerLength, &length, sizeof(length));
+        headerLength += sizeof(length);
+    }
+
+    NSMutableData *frame = [NSMutableData dataWithBytes:header length:headerLength];
+    if (payload) {
+        [frame appendData:payload];
+    }
+    return frame;
+}
+
+- (nullable NSData *)readFrameWithOpCode:(SRTOpCode *_Nullable)opCode
+{
+    uint8_t header[2];
+    if (![self _readBytes:header length:sizeof(header)]) {
+        return nil;
+    }
+
+    uint64_t payloadLength = header[1] & 0x7F;
+    if (payloadLength == 126) {
+        uint16_t length;
+        if (![self _readBytes:&length length:sizeof(length)]) {
+            return nil;
+        }
+        payloadLength = CFSwapInt16BigToHost(length);
+    } else if (payloadLength == 127) {
+        uint64_t length;
+        if (![self _readBytes:&length length:sizeof(length)]) {
+            return nil;
+        }
+        payloadLength = CFSwapInt64BigToHost(length);
+    }
+
+    uint8_t maskKey[4] = {0};
+    BOOL masked = (header[1] & 0x80) != 0;
+    if (masked && ![self _readBytes:maskKey length:sizeof(maskKey)]) {
+        return nil;
+    }
+
+    NSMutableData *payload = [NSMutableData dataWithLength:(NSUInteger)payloadLength];
+    if (![self _readBytes:payload.mutableBytes length:payload.length]) {
+        return nil;
+    }
+    uint8_t *bytes = payload.mutableBytes;
+    for (NSUInteger i = 0; masked && i < payload.length; i++) {
+        bytes[i] ^= maskKey[i % sizeof(maskKey)];
+    }
+
+    if (opCode) {
+        *opCode = header[0] & 0x0F;
+    }
+    return payload;
+}
+
+- (void)echoMessagesWithFragmentLength:(NSUInteger)fragmentLength
+{
+    SRTOpCode opCode = 0;
+    NSData *payload = nil;
+    while ((payload = [self readFrameWithOpCode:&opCode])) {
+        switch (opCode) {
+            case SRTOpCodeTextFrame:
+            case SRTOpCodeBinaryFrame:
+                if (![self _sendMessageWithOpCode:opCode payload:payload fragmentLength:fragmentLength]) {
+                    return;
+                }
+                break;
+            case SRTOpCodePing:
+                if (![self sendFrameWithOpCode:SRTOpCodePong payload:payload]) {
+                    return;
+                }
+                break;
+            case SRTOpCodeConnectionClose:
+                [self sendFrameWithOpCode:SRTOpCodeConnectionClose payload:payload];
+                return;
+            default:
+                break;
+        }
+    }
+}
+
+- (BOOL)_sendMessageWithOpCode:(SRTOpCode)opCode payload:(NSData *)payload fragmentLength:(NSUInteger)fragmentLength
+{
+    if (fragmentLength == 0 || payload.length <= fragmentLength) {
+        return [self sendFrameWithOpCode:opCode payload:payload];
+    }
+    for (NSUInteger offset = 0; offset < payload.length; offset += fragmentLength) {
+        NSUInteger length = MIN(fragmentLength, payload.length - offset);
+        NSData *fragment = [payload subdataWithRange:NSMakeRange(offset, length)];
+        SRTOpCode fragmentOpCode = (offset == 0 ? opCode : SRTOpCodeContinuationFrame);
+        if (![self sendFrameWithOpCode:fragmentOpCode payload:fragment fin:(offset + length == payload.length)]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+#pragma mark - I/O
+
+- (BOOL)_readBytes:(void *)bytes length:(size_t)length
+{
+    size_t offset = 0;
+    while (offset < length) {
+        ssize_t bytesRead = read(_socket, (uint8_t *)bytes + offset, length - offset);
+        if (bytesRead <= 0) {
+            return NO;
+        }
+        offset += bytesRead;
+    }
+    return YES;
+}
+
+- (BOOL)_writeData:(NSData *)data
+{
+    size_t offset = 0;
+    while (offset < data.length) {
+        ssize_t bytesWritten = write(_socket, (const uint8_t *)data.bytes + offset, data.length - offset);
+        if (bytesWritten <= 0) {
+            return NO;
+        }
+        offset += bytesWritten;
+    }
+    return YES;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
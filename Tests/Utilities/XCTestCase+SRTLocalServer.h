@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+@import XCTest;
+
+#import <SocketRocket/SRWebSocket.h>
+
+#import "SRTLocalServer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Opening fixture shared by tests that talk to a `SRTLocalServer`.
+ It lives apart from the server, which benchmarks use without XCTest.
+ */
+@interface XCTestCase (SRTLocalServer)
+
+/**
+ Creates a socket for `server.URL` that reports to `delegate`, opens it and waits until the delegate was told it opened.
+
+ @param server          Server to connect to, its connection is accepted while opening.
+ @param delegate        Delegate of the socket, which must fulfill `*openExpectation` in `webSocketDidOpen:`.
+ @param delegateQueue   Queue to report to `delegate` on. If `nil` - the default queue of the socket is kept.
+ @param openExpectation Set to the `Opened` expectation before the socket is opened.
+ @param configuration   Called with the socket before it is opened, to set any other options.
+ */
+- (SRWebSocket *)srt_openWebSocketWithServer:(SRTLocalServer *)server
+                                    delegate:(id<SRWebSocketDelegate>)delegate
+                               delegateQueue:(nullable dispatch_queue_t)delegateQueue
+                             openExpectation:(XCTestExpectation *_Nullable __strong *_Nonnull)openExpectation
+                               configuration:(nullable void (^)(SRWebSocket *webSocket))configuration;
+
+/**
+ Opens an already configured socket and waits for `*openExpectation`, which is set to the `Opened` expectation first.
+ Accepts the connection on `server`, unless it is `nil` because the socket doesn't go through the network.
+ */
+- (void)srt_openWebSocket:(SRWebSocket *)webSocket
+               withServer:(nullable SRTLocalServer *)server
+          openExpectation:(XCTestExpectation *_Nullable __strong *_Nonnull)openExpectation;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#import "XCTestCase+SRTLocalServer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation XCTestCase (SRTLocalServer)
+
+- (SRWebSocket *)srt_openWebSocketWithServer:(SRTLocalServer *)server
+                                    delegate:(id<SRWebSocketDelegate>)delegate
+                               delegateQueue:(nullable dispatch_queue_t)delegateQueue
+                             openExpectation:(XCTestExpectation *_Nullable __strong *_Nonnull)openExpectation
+                               configuration:(nullable void (^)(SRWebSocket *webSocket))configuration
+{
+    SRWebSocket *webSocket = [[SRWebSocket alloc] initWithURL:server.URL];
+    webSocket.delegate = delegate;
+    if (delegateQueue) {
+        webSocket.delegateDispatchQueue = delegateQueue;
+    }
+    if (configuration) {
+        configuration(webSocket);
+    }
+
+    [self srt_openWebSocket:webSocket withServer:server openExpectation:openExpectation];
+    return webSocket;
+}
+
+- (void)srt_openWebSocket:(SRWebSocket *)webSocket
+               withServer:(nullable SRTLocalServer *)server
+          openExpectation:(XCTestExpectation *_Nullable __strong *_Nonnull)openExpectation
+{
+    *openExpectation = [self expectationWithDescription:@"Opened"];
+    [webSocket open];
+    if (server) {
+        XCTAssertTrue([server acceptConnection]);
+    }
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END